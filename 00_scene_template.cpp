@@ -7,7 +7,7 @@
 #include "common/defer.hpp"
 #include "common/scene.h"
 
-void *init(void);
+void *init(uint64_t seed);
 void  update(void  *scene_data, float delta_time);
 void  destroy(void *scene_data);
 
@@ -15,16 +15,27 @@ struct Scene_Data {
     Camera2D camera;
 };
 
-extern "C" struct Scene_Functions __declspec(dllexport) get_scene_functions(void);
+// Every field of the scene data, for hot reloading
+const struct Scene_Field SCENE_DATA_FIELDS[] = {
+    SCENE_FIELD(struct Scene_Data, camera),
+};
+
+extern "C" struct Scene_Functions SCENE_EXPORT get_scene_functions(void);
 struct Scene_Functions get_scene_functions(void) {
-    return (struct Scene_Functions) {
-        .init    = &init,
-        .update  = &update,
-        .destroy = &destroy,
-    };
+    struct Scene_Functions functions = { };
+    functions.init    = &init;
+    functions.update  = &update;
+    functions.destroy = &destroy;
+
+    functions.layout = SCENE_LAYOUT(struct Scene_Data, 1, SCENE_DATA_FIELDS);
+
+    return functions;
 }
 
-void *init(void) {
+void *init(uint64_t seed) {
+    // Scenes with randomness create their streams from `seed`, see common/random.h
+    (void) seed;
+
     struct Scene_Data *self = (struct Scene_Data *) malloc(sizeof(struct Scene_Data));
     memset(self, 0, sizeof(struct Scene_Data));
 
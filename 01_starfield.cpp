@@ -4,41 +4,122 @@
 #include <ctime>
 #include <cassert>
 #include <cmath>
+#include <mutex>
 
 #include "raylib.h"
 #include "raymath.h"
+#include "rlgl.h"
 
 #include "common/common.h"
 #include "common/defer.hpp"
 #include "common/math.h"
 #include "common/scene.h"
+#include "common/thread_pool.h"
 
-void *starfield_init(void);
+#include "01_starfield_simulation.h"
+#include "01_starfield_batch.h"
+
+void *starfield_init(uint64_t seed);
 void  starfield_update(void  *scene_data, float delta_time);
 void  starfield_destroy(void *scene_data);
-
-extern "C" struct Scene_Functions __declspec(dllexport) get_scene_functions(void);
-struct Scene_Functions get_scene_functions(void) {
-    return (struct Scene_Functions) {
-        .init    = &starfield_init,
-        .update  = &starfield_update,
-        .destroy = &starfield_destroy,
-    };
-}
+void  starfield_tick(void    *scene_data, void *snapshot, float delta_time);
+void  starfield_draw(void    *scene_data, const void *previous, const void *current, float alpha);
+void  starfield_before_reload(void *scene_data);
+void  starfield_after_reload(void  *scene_data);
 
 const size_t STAR_COUNT = 600;
 
-struct Star {
-    float x, y, z, last_z;
+// The mesh the batch is drawn from takes 16 bit indices, so every vertex of a full batch has to fit
+const size_t STAR_MESH_VERTEX_COUNT = STAR_COUNT * (3 + 1 + STAR_BATCH_MAX_SEGMENTS);
+const size_t STAR_MESH_INDEX_COUNT  = STAR_COUNT * (3 + 3 * STAR_BATCH_MAX_SEGMENTS);
+static_assert(STAR_MESH_VERTEX_COUNT <= 65536, "Too many stars for the star mesh's 16 bit indices");
+
+// Where raylib keeps a mesh's index buffer among its `vboId`s
+const int STAR_MESH_INDEX_BUFFER = 6;
+
+// Trails are as long as the stars move in a tick, at 60 they look like they did per frame
+const float STARFIELD_TICK_RATE = 60;
+
+// What a tick hands to the frame. `count` stars follow as four arrays, x, y, z and last z.
+struct Starfield_Snapshot {
+    size_t count;
 };
 
 struct Scene_Data {
     Camera2D camera;
+
+    // Simulation thread only, space is passed on through `pause_toggle_queued`
     bool is_paused;
-    struct Star *stars;
+    struct Stars stars;
+    struct Thread_Pool *thread_pool;
+
+    std::mutex *input_mutex;
+    bool        pause_toggle_queued;
+
+    // Main thread only, `drawn` holds the stars between the two snapshots of a frame
+    struct Stars drawn;
+    struct Star_Batch batch;
+    Mesh     star_mesh;
+    Material star_material;
+};
+
+// Every field of the scene data but the ones owning threads, for hot reloading
+const struct Scene_Field SCENE_DATA_FIELDS[] = {
+    SCENE_FIELD(struct Scene_Data, camera),
+    SCENE_FIELD(struct Scene_Data, is_paused),
+    SCENE_FIELD(struct Scene_Data, stars),
+    SCENE_FIELD(struct Scene_Data, input_mutex),
+    SCENE_FIELD(struct Scene_Data, pause_toggle_queued),
+    SCENE_FIELD(struct Scene_Data, drawn),
+    SCENE_FIELD(struct Scene_Data, batch),
+    SCENE_FIELD(struct Scene_Data, star_mesh),
+    SCENE_FIELD(struct Scene_Data, star_material),
 };
 
-void *starfield_init(void) {
+extern "C" struct Scene_Functions SCENE_EXPORT get_scene_functions(void);
+struct Scene_Functions get_scene_functions(void) {
+    struct Scene_Functions functions = { };
+    functions.init    = &starfield_init;
+    functions.update  = &starfield_update;
+    functions.destroy = &starfield_destroy;
+
+    functions.tick          = &starfield_tick;
+    functions.draw          = &starfield_draw;
+    functions.snapshot_size = sizeof(struct Starfield_Snapshot) + 4 * STAR_COUNT * sizeof(float);
+    functions.tick_rate     = STARFIELD_TICK_RATE;
+
+    functions.before_reload = &starfield_before_reload;
+    functions.after_reload  = &starfield_after_reload;
+
+    functions.layout = SCENE_LAYOUT(struct Scene_Data, 1, SCENE_DATA_FIELDS);
+
+    return functions;
+}
+
+// One dynamic mesh big enough for a full batch. Its CPU copies are refilled every frame and belong
+// to the scene, not raylib.
+void star_mesh_load(struct Scene_Data *self) {
+    self->star_mesh = { };
+    self->star_mesh.vertexCount   = (int) STAR_MESH_VERTEX_COUNT;
+    self->star_mesh.triangleCount = (int) (STAR_MESH_INDEX_COUNT / 3);
+    self->star_mesh.vertices = (float *)          calloc(3 * STAR_MESH_VERTEX_COUNT, sizeof(float));
+    self->star_mesh.indices  = (unsigned short *) calloc(STAR_MESH_INDEX_COUNT, sizeof(unsigned short));
+    assert(self->star_mesh.vertices && self->star_mesh.indices && "Failed to allocate star mesh");
+
+    UploadMesh(&self->star_mesh, true);
+    self->star_material = LoadMaterialDefault();
+}
+
+void star_mesh_unload(struct Scene_Data *self) {
+    free(self->star_mesh.vertices);
+    free(self->star_mesh.indices);
+    self->star_mesh.vertices = NULL;
+    self->star_mesh.indices  = NULL;
+    UnloadMesh(self->star_mesh);
+    UnloadMaterial(self->star_material);
+}
+
+void *starfield_init(uint64_t seed) {
     struct Scene_Data *self = (struct Scene_Data *) malloc(sizeof(struct Scene_Data));
     memset(self, 0, sizeof(struct Scene_Data));
 
@@ -48,19 +129,18 @@ void *starfield_init(void) {
         self->camera.target = { .x = -CANVAS_SIZE.x / 2.f, .y = -CANVAS_SIZE.y / 2.f };
     }
 
-    {
-        self->stars = (struct Star *) calloc(STAR_COUNT, sizeof(struct Star));
-        assert(self->stars && "Failed to allocate stars");
-        memset(self->stars, 0, STAR_COUNT * sizeof(struct Star));
-
-        for (size_t i = 0; i < STAR_COUNT; ++i) {
-            struct Star *star = &self->stars[i];
-            star->x = GetRandomValue(-CANVAS_SIZE.x / 2.f, CANVAS_SIZE.x / 2.f);
-            star->y = GetRandomValue(-CANVAS_SIZE.y / 2.f, CANVAS_SIZE.y / 2.f);
-            star->z = GetRandomValue(0, CANVAS_SIZE.x / 2.f);
-            star->last_z = star->z;
-        }
-    }
+    self->stars = stars_create(STAR_COUNT, CANVAS_SIZE.x, CANVAS_SIZE.y, seed);
+    self->thread_pool = thread_pool_create(thread_pool_default_thread_count());
+    self->batch = star_batch_create();
+    star_mesh_load(self);
+    self->input_mutex = new std::mutex();
+
+    self->drawn = { };
+    self->drawn.x      = (float *) calloc(4 * STAR_COUNT, sizeof(float));
+    self->drawn.y      = self->drawn.x + STAR_COUNT;
+    self->drawn.z      = self->drawn.y + STAR_COUNT;
+    self->drawn.last_z = self->drawn.z + STAR_COUNT;
+    assert(self->drawn.x && "Failed to allocate drawn stars");
 
     return (void *) self;
 }
@@ -70,75 +150,119 @@ void starfield_destroy(void *scene_data) {
     DEFER(fprintf(stderr, "Unloaded scene\n"));
     DEFER(free(self));
 
-    free(self->stars);
+    thread_pool_destroy(self->thread_pool);
+    stars_destroy(&self->stars);
+    star_batch_destroy(&self->batch);
+    star_mesh_unload(self);
+    free(self->drawn.x);
+    delete self->input_mutex;
+}
+
+// The pool's workers run this library's code, so a reload ends them and the new library starts
+// its own
+void starfield_before_reload(void *scene_data) {
+    struct Scene_Data *self = (struct Scene_Data *) scene_data;
+    thread_pool_destroy(self->thread_pool);
+    self->thread_pool = NULL;
+}
+
+void starfield_after_reload(void *scene_data) {
+    struct Scene_Data *self = (struct Scene_Data *) scene_data;
+    if (!self->thread_pool) self->thread_pool = thread_pool_create(thread_pool_default_thread_count());
+
+    // Data from before the mesh was added comes over without one
+    if (!self->star_mesh.vaoId) star_mesh_load(self);
+}
+
+// Copies the batch into the star mesh and uploads only the part it fills, then draws it with one
+// indexed draw call. The mesh takes 3D positions and 16 bit indices, so both are widened or
+// narrowed on the way.
+void star_batch_draw(const struct Star_Batch *batch, Mesh mesh, Material material) {
+    assert(batch->vertex_count <= STAR_MESH_VERTEX_COUNT && batch->index_count <= STAR_MESH_INDEX_COUNT);
+
+    for (size_t i = 0; i < batch->vertex_count; ++i) {
+        mesh.vertices[i * 3 + 0] = batch->vertices[i].x;
+        mesh.vertices[i * 3 + 1] = batch->vertices[i].y;
+        mesh.vertices[i * 3 + 2] = 0;
+    }
+    for (size_t i = 0; i < batch->index_count; ++i) {
+        mesh.indices[i] = (unsigned short) batch->indices[i];
+    }
+
+    UpdateMeshBuffer(mesh, 0, mesh.vertices, (int) (batch->vertex_count * 3 * sizeof(float)), 0);
+    rlUpdateVertexBufferElements(mesh.vboId[STAR_MESH_INDEX_BUFFER], mesh.indices, (int) (batch->index_count * sizeof(unsigned short)), 0);
+
+    mesh.triangleCount = (int) (batch->index_count / 3);
+    DrawMesh(mesh, material, MatrixIdentity());
 }
 
 void starfield_update(void *scene_data, float delta_time) {
     struct Scene_Data *self = (struct Scene_Data *) scene_data;
 
-    if (IsKeyPressed(KEY_SPACE)) self->is_paused ^= true;
+    // Only input is handled here, time goes by in `starfield_tick`
+    (void) delta_time;
+
+    if (IsKeyPressed(KEY_SPACE)) {
+        std::lock_guard<std::mutex> lock(*self->input_mutex);
+        self->pause_toggle_queued ^= true;
+    }
+}
+
+void starfield_tick(void *scene_data, void *snapshot, float delta_time) {
+    struct Scene_Data *self = (struct Scene_Data *) scene_data;
+
+    {
+        std::lock_guard<std::mutex> lock(*self->input_mutex);
+        if (self->pause_toggle_queued) self->is_paused ^= true;
+        self->pause_toggle_queued = false;
+    }
+
+    // Joined before the snapshot is written, so it always holds a finished step
+    if (!self->is_paused) stars_step_parallel(&self->stars, self->thread_pool, delta_time);
+
+    struct Starfield_Snapshot *header = (struct Starfield_Snapshot *) snapshot;
+    size_t count = self->stars.count;
+    float *x = (float *) (header + 1);
+    header->count = count;
+    memcpy(x,             self->stars.x,      count * sizeof(float));
+    memcpy(x + count,     self->stars.y,      count * sizeof(float));
+    memcpy(x + count * 2, self->stars.z,      count * sizeof(float));
+    memcpy(x + count * 3, self->stars.last_z, count * sizeof(float));
+}
+
+// Stars only ever come closer, so one that is further away in `current` has respawned and is
+// drawn where it is now instead of sliding back
+void starfield_interpolate(struct Stars *drawn, const struct Starfield_Snapshot *previous, const struct Starfield_Snapshot *current, float alpha) {
+    size_t count = current->count;
+    const float *from = (const float *) (previous + 1);
+    const float *to   = (const float *) (current + 1);
+
+    drawn->count = count;
+    for (size_t i = 0; i < count; ++i) {
+        float from_z = from[count * 2 + i], to_z = to[count * 2 + i];
+        bool is_respawn = to_z > from_z;
+
+        drawn->x[i]      = to[i];
+        drawn->y[i]      = to[count + i];
+        drawn->z[i]      = is_respawn ? to_z : lerp(from_z, to_z, alpha);
+        drawn->last_z[i] = is_respawn ? to[count * 3 + i] : lerp(from[count * 3 + i], to[count * 3 + i], alpha);
+    }
+}
+
+void starfield_draw(void *scene_data, const void *previous, const void *current, float alpha) {
+    struct Scene_Data *self = (struct Scene_Data *) scene_data;
+    const struct Starfield_Snapshot *from = (const struct Starfield_Snapshot *) previous;
+    const struct Starfield_Snapshot *to   = (const struct Starfield_Snapshot *) current;
 
     BeginMode2D(self->camera);
         ClearBackground(BLACK);
-        for (size_t i = 0; i < STAR_COUNT; ++i) {
-            struct Star *star = &self->stars[i];
-
-            float x = remap(star->x / star->z, 0, 1, 0, CANVAS_SIZE.x);
-            float y = remap(star->y / star->z, 0, 1, 0, CANVAS_SIZE.y);
-            float r = remap(star->z, 0, CANVAS_SIZE.x / 2.f, 10, 0);
-
-            // https://math.stackexchange.com/questions/3749993/an-equation-for-a-graph-which-resembles-a-hump-of-a-camel-pulse-in-a-string
-            // I cant really tell if this is actually working though, lol
-            float distance_factor_x;
-            float distance_factor_y;
-            {
-                float a = 3;
-                float b = 1;
-                float c = 0;
-                float d = 1;
-                distance_factor_x = a / (1 + b * pow(star->x - c, 2)) + d;
-                distance_factor_y = a / (1 + b * pow(star->y - c, 2)) + d;
-            }
-
-            float last_x = remap(star->x / star->last_z, 0, 1, 0, CANVAS_SIZE.x);
-            float last_y = remap(star->y / star->last_z, 0, 1, 0, CANVAS_SIZE.y);
-            float last_r = remap(star->last_z, 0, CANVAS_SIZE.x / 2.f, 5, 0);
-
-            // https://en.wikipedia.org/wiki/Tangent_lines_to_circles#With_analytic_geometry
-            Vector2 p1;
-            Vector2 p2;
-            {
-                Vector2 p0 = Vector2Subtract({ last_x, last_y }, {x, y});
-                float   d0 = sqrt(pow(p0.x, 2) + pow(p0.y, 2));
-                Vector2 e1 = Vector2Scale(p0, 1.f / d0);
-                Vector2 e2 = { -p0.y / d0, p0.x / d0 };
-                
-                p1 = Vector2Scale(e1, pow(r, 2) / d0);
-                p1 = Vector2Add(p1, Vector2Scale(e2, (r / d0) * sqrt(pow(d0, 2) - pow(r, 2))));
-                p1 = Vector2Add(p1, {x, y});
-
-                p2 = Vector2Scale(e1, pow(r, 2) / d0);
-                p2 = Vector2Subtract(p2, Vector2Scale(e2, (r / d0) * sqrt(pow(d0, 2) - pow(r, 2))));
-                p2 = Vector2Add(p2, {x, y});
-            }
-
-            // Triangles must be drawn counter-clockwise
-            // https://github.com/raysan5/raylib/issues/941
-            DrawTriangle({ last_x, last_y }, p2, p1, WHITE);
-            DrawCircle(x, y, r, WHITE);
-
-            if (self->is_paused) continue;
-
-            star->last_z = star->z;
-            star->z -= 1500 * distance_factor_x * distance_factor_y * delta_time;
-
-            if (star->z < 1) {
-                star->x = GetRandomValue(-CANVAS_SIZE.x / 2.f, CANVAS_SIZE.x / 2.f);
-                star->y = GetRandomValue(-CANVAS_SIZE.y / 2.f, CANVAS_SIZE.y / 2.f);
-                star->z = CANVAS_SIZE.x / 2.f;
-                star->last_z = star->z;
-            }
+
+        // Nothing has been simulated before the first snapshot
+        if (to->count > 0) {
+            if (from->count != to->count) from = to;
+            starfield_interpolate(&self->drawn, from, to, alpha);
+            star_batch_build(&self->batch, &self->drawn, CANVAS_SIZE.x, CANVAS_SIZE.y);
+            star_batch_draw(&self->batch, self->star_mesh, self->star_material);
         }
     EndMode2D();
 }
-
@@ -0,0 +1,187 @@
+#pragma once
+#ifndef E_STARFIELD_BATCH_H
+#define E_STARFIELD_BATCH_H
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include "common/math.h"
+
+#include "01_starfield_simulation.h"
+
+// Builds every star trail and circle for a frame into one indexed triangle list, so the scene
+// can hand the whole frame to the renderer at once. Nothing in here touches raylib.
+
+struct Batch_Vertex {
+    float x, y;
+};
+
+// Circles are fanned from a unit circle precomputed once per level of detail,
+// the segment count is picked from the projected radius
+const int   STAR_BATCH_LOD_COUNT = 4;
+const int   STAR_BATCH_LOD_SEGMENTS[STAR_BATCH_LOD_COUNT]   = { 8, 12, 24, 36 };
+const float STAR_BATCH_LOD_MAX_RADIUS[STAR_BATCH_LOD_COUNT] = { 1.5f, 4.f, 7.f, INFINITY };
+const int   STAR_BATCH_MAX_SEGMENTS = 36;
+const float STAR_BATCH_TAU = 6.28318530717958647692f;
+
+struct Star_Batch_Circle {
+    int segments;
+    struct Batch_Vertex unit[STAR_BATCH_MAX_SEGMENTS];
+};
+
+struct Star_Batch {
+    struct Star_Batch_Circle circles[STAR_BATCH_LOD_COUNT];
+
+    size_t vertex_count;
+    size_t vertex_capacity;
+    struct Batch_Vertex *vertices;
+
+    size_t index_count;
+    size_t index_capacity;
+    uint32_t *indices;
+
+    // Per-frame counters, reset by `star_batch_begin`
+    size_t trail_count;
+    size_t circle_count;
+};
+
+struct Star_Batch star_batch_create(void) {
+    struct Star_Batch self = { };
+
+    for (int lod = 0; lod < STAR_BATCH_LOD_COUNT; ++lod) {
+        struct Star_Batch_Circle *circle = &self.circles[lod];
+        circle->segments = STAR_BATCH_LOD_SEGMENTS[lod];
+
+        for (int i = 0; i < circle->segments; ++i) {
+            float angle = STAR_BATCH_TAU * (float) i / (float) circle->segments;
+            circle->unit[i] = { cosf(angle), sinf(angle) };
+        }
+    }
+
+    return self;
+}
+
+void star_batch_destroy(struct Star_Batch *self) {
+    free(self->vertices);
+    free(self->indices);
+    *self = { };
+}
+
+// Grows the buffers to fit `star_count` worst-case stars. Only reallocates when the count grows.
+void star_batch_reserve(struct Star_Batch *self, size_t star_count) {
+    size_t vertices = star_count * (3 + 1 + STAR_BATCH_MAX_SEGMENTS);
+    size_t indices  = star_count * (3 + 3 * STAR_BATCH_MAX_SEGMENTS);
+
+    if (vertices > self->vertex_capacity) {
+        self->vertices = (struct Batch_Vertex *) realloc(self->vertices, vertices * sizeof(struct Batch_Vertex));
+        assert(self->vertices && "Failed to allocate batch vertices");
+        self->vertex_capacity = vertices;
+    }
+
+    if (indices > self->index_capacity) {
+        self->indices = (uint32_t *) realloc(self->indices, indices * sizeof(uint32_t));
+        assert(self->indices && "Failed to allocate batch indices");
+        self->index_capacity = indices;
+    }
+}
+
+void star_batch_begin(struct Star_Batch *self) {
+    self->vertex_count = 0;
+    self->index_count  = 0;
+    self->trail_count  = 0;
+    self->circle_count = 0;
+}
+
+size_t star_batch_bytes_written(struct Star_Batch *self) {
+    return self->vertex_count * sizeof(struct Batch_Vertex) + self->index_count * sizeof(uint32_t);
+}
+
+// Triangles must be counter-clockwise
+// https://github.com/raysan5/raylib/issues/941
+void star_batch_push_triangle(struct Star_Batch *self, struct Batch_Vertex a, struct Batch_Vertex b, struct Batch_Vertex c) {
+    uint32_t first = (uint32_t) self->vertex_count;
+    self->vertices[self->vertex_count++] = a;
+    self->vertices[self->vertex_count++] = b;
+    self->vertices[self->vertex_count++] = c;
+
+    self->indices[self->index_count++] = first;
+    self->indices[self->index_count++] = first + 1;
+    self->indices[self->index_count++] = first + 2;
+
+    self->trail_count += 1;
+}
+
+const struct Star_Batch_Circle *star_batch_circle_lod(struct Star_Batch *self, float radius) {
+    int lod = 0;
+    while (radius > STAR_BATCH_LOD_MAX_RADIUS[lod]) lod += 1;
+    return &self->circles[lod];
+}
+
+// Same winding as raylib's DrawCircleSector: center, next, current
+void star_batch_push_circle(struct Star_Batch *self, struct Batch_Vertex center, float radius) {
+    if (radius <= 0) return;
+
+    const struct Star_Batch_Circle *circle = star_batch_circle_lod(self, radius);
+
+    uint32_t first = (uint32_t) self->vertex_count;
+    self->vertices[self->vertex_count++] = center;
+    for (int i = 0; i < circle->segments; ++i) {
+        self->vertices[self->vertex_count++] = {
+            center.x + circle->unit[i].x * radius,
+            center.y + circle->unit[i].y * radius
+        };
+    }
+
+    for (int i = 0; i < circle->segments; ++i) {
+        uint32_t next = (uint32_t) ((i + 1) % circle->segments);
+        self->indices[self->index_count++] = first;
+        self->indices[self->index_count++] = first + 1 + next;
+        self->indices[self->index_count++] = first + 1 + (uint32_t) i;
+    }
+
+    self->circle_count += 1;
+}
+
+// Projects every star onto the canvas and writes its trail and head into the batch
+void star_batch_build(struct Star_Batch *self, const struct Stars *stars, float canvas_width, float canvas_height) {
+    star_batch_reserve(self, stars->count);
+    star_batch_begin(self);
+
+    for (size_t i = 0; i < stars->count; ++i) {
+        float x = remap(stars->x[i] / stars->z[i], 0, 1, 0, canvas_width);
+        float y = remap(stars->y[i] / stars->z[i], 0, 1, 0, canvas_height);
+        float r = remap(stars->z[i], 0, canvas_width / 2.f, 10, 0);
+
+        float last_x = remap(stars->x[i] / stars->last_z[i], 0, 1, 0, canvas_width);
+        float last_y = remap(stars->y[i] / stars->last_z[i], 0, 1, 0, canvas_height);
+
+        // https://en.wikipedia.org/wiki/Tangent_lines_to_circles#With_analytic_geometry
+        // The trail is the triangle from the last position to the two tangent points on the head.
+        // When the last position is inside the head there are no tangents, so there is no trail.
+        float p0_x = last_x - x;
+        float p0_y = last_y - y;
+        float d0_squared = square(p0_x) + square(p0_y);
+        float r_squared  = square(r);
+
+        if (d0_squared > r_squared) {
+            float inverse_d0 = fast_rsqrt(d0_squared);
+            float e1_x =  p0_x * inverse_d0, e1_y = p0_y * inverse_d0;
+            float e2_x = -e1_y,              e2_y = e1_x;
+
+            float along  = r_squared * inverse_d0;
+            float across = r * inverse_d0 * fast_sqrt(d0_squared - r_squared);
+
+            struct Batch_Vertex p1 = { x + e1_x * along + e2_x * across, y + e1_y * along + e2_y * across };
+            struct Batch_Vertex p2 = { x + e1_x * along - e2_x * across, y + e1_y * along - e2_y * across };
+
+            star_batch_push_triangle(self, { last_x, last_y }, p2, p1);
+        }
+
+        star_batch_push_circle(self, { x, y }, r);
+    }
+}
+
+#endif // E_STARFIELD_BATCH_H
@@ -0,0 +1,238 @@
+#pragma once
+#ifndef E_STARFIELD_SIMULATION_H
+#define E_STARFIELD_SIMULATION_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include "common/random.h"
+#include "common/thread_pool.h"
+
+// Star simulation for 01_starfield, kept free of raylib so it can be stepped headless.
+// Stars are stored as a structure of arrays and integrated `STARS_LANES` at a time.
+//
+// The arrays are split into fixed-size chunks, each with its own random stream for respawns.
+// Chunks never share state, so they can be stepped on any thread in any order and the result
+// for a given seed is the same no matter how many threads there are.
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define STARS_LANES 16
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define STARS_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define STARS_LANES 4
+#else
+#define STARS_LANES 1
+#endif
+
+// Multiple of every lane width so chunk boundaries never split a SIMD step
+const size_t STARS_CHUNK_SIZE = 16 * 1024;
+
+// https://math.stackexchange.com/questions/3749993/an-equation-for-a-graph-which-resembles-a-hump-of-a-camel-pulse-in-a-string
+// I cant really tell if this is actually working though, lol
+const float STARS_HUMP_A = 3;
+const float STARS_HUMP_B = 1;
+const float STARS_HUMP_C = 0;
+const float STARS_HUMP_D = 1;
+
+const float STARS_SPEED     = 1500;
+const float STARS_RESPAWN_Z = 1;
+
+struct Stars {
+    size_t count;
+    size_t chunk_count;
+    struct Random *chunk_random;
+
+    float *x;
+    float *y;
+    float *z;
+    float *last_z;
+
+    float half_width;
+    float half_height;
+    float depth;
+};
+
+struct Stars stars_create(size_t count, float width, float height, uint64_t seed) {
+    struct Stars self = { };
+    self.count       = count;
+    self.chunk_count = (count + STARS_CHUNK_SIZE - 1) / STARS_CHUNK_SIZE;
+    self.half_width  = width  / 2.f;
+    self.half_height = height / 2.f;
+    self.depth       = width  / 2.f;
+
+    self.x      = (float *) calloc(count, sizeof(float));
+    self.y      = (float *) calloc(count, sizeof(float));
+    self.z      = (float *) calloc(count, sizeof(float));
+    self.last_z = (float *) calloc(count, sizeof(float));
+    assert(self.x && self.y && self.z && self.last_z && "Failed to allocate stars");
+
+    self.chunk_random = (struct Random *) calloc(self.chunk_count, sizeof(struct Random));
+    assert(self.chunk_random && "Failed to allocate star random streams");
+
+    for (size_t chunk = 0; chunk < self.chunk_count; ++chunk) {
+        // Every stream is derived from the seed and the chunk index alone
+        struct Random *random = &self.chunk_random[chunk];
+        *random = random_create(seed, chunk);
+
+        size_t begin = chunk * STARS_CHUNK_SIZE;
+        size_t end   = begin + STARS_CHUNK_SIZE < count ? begin + STARS_CHUNK_SIZE : count;
+        random_fill_float(random, &self.x[begin], end - begin, -self.half_width,  self.half_width);
+        random_fill_float(random, &self.y[begin], end - begin, -self.half_height, self.half_height);
+        random_fill_float(random, &self.z[begin], end - begin, 0, self.depth);
+        for (size_t i = begin; i < end; ++i) self.last_z[i] = self.z[i];
+    }
+
+    return self;
+}
+
+void stars_destroy(struct Stars *self) {
+    free(self->x);
+    free(self->y);
+    free(self->z);
+    free(self->last_z);
+    free(self->chunk_random);
+    *self = { };
+}
+
+void stars_respawn(struct Stars *self, size_t i, struct Random *random) {
+    self->x[i] = random_float_range(random, -self->half_width,  self->half_width);
+    self->y[i] = random_float_range(random, -self->half_height, self->half_height);
+    self->z[i] = self->depth;
+    self->last_z[i] = self->z[i];
+}
+
+float stars_distance_factor(float v) {
+    float offset = v - STARS_HUMP_C;
+    return STARS_HUMP_A / (1 + STARS_HUMP_B * (offset * offset)) + STARS_HUMP_D;
+}
+
+// Steps stars [begin, end) one at a time. Used for the tail of the SIMD kernel and as its reference.
+void stars_step_scalar(struct Stars *self, size_t begin, size_t end, float delta_time, struct Random *random) {
+    float speed = STARS_SPEED * delta_time;
+    for (size_t i = begin; i < end; ++i) {
+        float factor = stars_distance_factor(self->x[i]) * stars_distance_factor(self->y[i]);
+
+        self->last_z[i] = self->z[i];
+        self->z[i] -= speed * factor;
+
+        if (self->z[i] < STARS_RESPAWN_Z) stars_respawn(self, i, random);
+    }
+}
+
+// Steps stars [begin, end) `STARS_LANES` at a time. Respawns are rare, so lanes that fall
+// behind the camera are collected into a bit mask and handled one by one after the store.
+void stars_step_range(struct Stars *self, size_t begin, size_t end, float delta_time, struct Random *random) {
+    size_t i = begin;
+
+#if STARS_LANES == 16
+    const __m512 a = _mm512_set1_ps(STARS_HUMP_A);
+    const __m512 b = _mm512_set1_ps(STARS_HUMP_B);
+    const __m512 c = _mm512_set1_ps(STARS_HUMP_C);
+    const __m512 d = _mm512_set1_ps(STARS_HUMP_D);
+    const __m512 one     = _mm512_set1_ps(1.f);
+    const __m512 respawn = _mm512_set1_ps(STARS_RESPAWN_Z);
+    const __m512 speed   = _mm512_set1_ps(STARS_SPEED * delta_time);
+
+    for (; i + 16 <= end; i += 16) {
+        __m512 x = _mm512_sub_ps(_mm512_loadu_ps(&self->x[i]), c);
+        __m512 y = _mm512_sub_ps(_mm512_loadu_ps(&self->y[i]), c);
+        __m512 z = _mm512_loadu_ps(&self->z[i]);
+
+        __m512 factor_x = _mm512_add_ps(_mm512_div_ps(a, _mm512_add_ps(one, _mm512_mul_ps(b, _mm512_mul_ps(x, x)))), d);
+        __m512 factor_y = _mm512_add_ps(_mm512_div_ps(a, _mm512_add_ps(one, _mm512_mul_ps(b, _mm512_mul_ps(y, y)))), d);
+        __m512 next_z   = _mm512_sub_ps(z, _mm512_mul_ps(speed, _mm512_mul_ps(factor_x, factor_y)));
+
+        _mm512_storeu_ps(&self->last_z[i], z);
+        _mm512_storeu_ps(&self->z[i], next_z);
+
+        unsigned mask = (unsigned) _mm512_cmp_ps_mask(next_z, respawn, _CMP_LT_OQ);
+        for (; mask; mask &= mask - 1) stars_respawn(self, i + (size_t) __builtin_ctz(mask), random);
+    }
+#elif STARS_LANES == 8
+    const __m256 a = _mm256_set1_ps(STARS_HUMP_A);
+    const __m256 b = _mm256_set1_ps(STARS_HUMP_B);
+    const __m256 c = _mm256_set1_ps(STARS_HUMP_C);
+    const __m256 d = _mm256_set1_ps(STARS_HUMP_D);
+    const __m256 one     = _mm256_set1_ps(1.f);
+    const __m256 respawn = _mm256_set1_ps(STARS_RESPAWN_Z);
+    const __m256 speed   = _mm256_set1_ps(STARS_SPEED * delta_time);
+
+    for (; i + 8 <= end; i += 8) {
+        __m256 x = _mm256_sub_ps(_mm256_loadu_ps(&self->x[i]), c);
+        __m256 y = _mm256_sub_ps(_mm256_loadu_ps(&self->y[i]), c);
+        __m256 z = _mm256_loadu_ps(&self->z[i]);
+
+        __m256 factor_x = _mm256_add_ps(_mm256_div_ps(a, _mm256_add_ps(one, _mm256_mul_ps(b, _mm256_mul_ps(x, x)))), d);
+        __m256 factor_y = _mm256_add_ps(_mm256_div_ps(a, _mm256_add_ps(one, _mm256_mul_ps(b, _mm256_mul_ps(y, y)))), d);
+        __m256 next_z   = _mm256_sub_ps(z, _mm256_mul_ps(speed, _mm256_mul_ps(factor_x, factor_y)));
+
+        _mm256_storeu_ps(&self->last_z[i], z);
+        _mm256_storeu_ps(&self->z[i], next_z);
+
+        unsigned mask = (unsigned) _mm256_movemask_ps(_mm256_cmp_ps(next_z, respawn, _CMP_LT_OQ));
+        for (; mask; mask &= mask - 1) stars_respawn(self, i + (size_t) __builtin_ctz(mask), random);
+    }
+#elif STARS_LANES == 4
+    const __m128 a = _mm_set1_ps(STARS_HUMP_A);
+    const __m128 b = _mm_set1_ps(STARS_HUMP_B);
+    const __m128 c = _mm_set1_ps(STARS_HUMP_C);
+    const __m128 d = _mm_set1_ps(STARS_HUMP_D);
+    const __m128 one     = _mm_set1_ps(1.f);
+    const __m128 respawn = _mm_set1_ps(STARS_RESPAWN_Z);
+    const __m128 speed   = _mm_set1_ps(STARS_SPEED * delta_time);
+
+    for (; i + 4 <= end; i += 4) {
+        __m128 x = _mm_sub_ps(_mm_loadu_ps(&self->x[i]), c);
+        __m128 y = _mm_sub_ps(_mm_loadu_ps(&self->y[i]), c);
+        __m128 z = _mm_loadu_ps(&self->z[i]);
+
+        __m128 factor_x = _mm_add_ps(_mm_div_ps(a, _mm_add_ps(one, _mm_mul_ps(b, _mm_mul_ps(x, x)))), d);
+        __m128 factor_y = _mm_add_ps(_mm_div_ps(a, _mm_add_ps(one, _mm_mul_ps(b, _mm_mul_ps(y, y)))), d);
+        __m128 next_z   = _mm_sub_ps(z, _mm_mul_ps(speed, _mm_mul_ps(factor_x, factor_y)));
+
+        _mm_storeu_ps(&self->last_z[i], z);
+        _mm_storeu_ps(&self->z[i], next_z);
+
+        unsigned mask = (unsigned) _mm_movemask_ps(_mm_cmplt_ps(next_z, respawn));
+        for (; mask; mask &= mask - 1) stars_respawn(self, i + (size_t) __builtin_ctz(mask), random);
+    }
+#endif
+
+    stars_step_scalar(self, i, end, delta_time, random);
+}
+
+void stars_step_chunk(struct Stars *self, size_t chunk, float delta_time) {
+    size_t begin = chunk * STARS_CHUNK_SIZE;
+    size_t end   = begin + STARS_CHUNK_SIZE < self->count ? begin + STARS_CHUNK_SIZE : self->count;
+    stars_step_range(self, begin, end, delta_time, &self->chunk_random[chunk]);
+}
+
+void stars_step(struct Stars *self, float delta_time) {
+    for (size_t chunk = 0; chunk < self->chunk_count; ++chunk) {
+        stars_step_chunk(self, chunk, delta_time);
+    }
+}
+
+struct Stars_Step_Job {
+    struct Stars *stars;
+    float delta_time;
+};
+
+void stars_step_job(void *user_data, size_t chunk) {
+    struct Stars_Step_Job *job = (struct Stars_Step_Job *) user_data;
+    stars_step_chunk(job->stars, chunk, job->delta_time);
+}
+
+// Returns once every chunk has been stepped
+void stars_step_parallel(struct Stars *self, struct Thread_Pool *pool, float delta_time) {
+    struct Stars_Step_Job job = { .stars = self, .delta_time = delta_time };
+    thread_pool_run(pool, self->chunk_count, &stars_step_job, &job);
+}
+
+#endif // E_STARFIELD_SIMULATION_H
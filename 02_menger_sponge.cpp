@@ -3,95 +3,332 @@
 #include <cstdlib>
 #include <cstring>
 #include <cassert>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include "raylib.h"
+#include "raymath.h"
 
 #include "common/common.h"
 #include "common/defer.hpp"
+#include "common/math.h"
+#include "common/morton.h"
 #include "common/scene.h"
+#include "common/thread_pool.h"
 
-void *init(void);
+#include "02_menger_sponge_cache.h"
+#include "02_menger_sponge_cubes.h"
+#include "02_menger_sponge_lod.h"
+#include "02_menger_sponge_mesh.h"
+#include "02_menger_sponge_raymarch.h"
+
+void *init(uint64_t seed);
 void  update(void  *scene_data, float delta_time);
 void  destroy(void *scene_data);
+void  before_reload(void *scene_data);
+void  after_reload(void  *scene_data);
 
-extern "C" struct Scene_Functions __declspec(dllexport) get_scene_functions(void);
-struct Scene_Functions get_scene_functions(void) {
-    return (struct Scene_Functions) {
-        .init    = &init,
-        .update  = &update,
-        .destroy = &destroy,
-    };
-}
-
-struct Cube {
-    Vector3 position;
-    Vector3 size;
+enum Subdivide_Stage {
+    SUBDIVIDE_IDLE,
+    SUBDIVIDE_SUBDIVIDING,
+    SUBDIVIDE_MESHING,
+    SUBDIVIDE_CACHING,
+    SUBDIVIDE_READY,
 };
 
-struct Cube_Array {
-    size_t count;
-    struct Cube *cubes;
-};
+// Builds the next level off the main thread so the frame keeps going while it runs.
+// The worker only reads `source` and writes `destination` and `lod`, then publishes them by
+// storing SUBDIVIDE_READY. The main thread does the swap and the GPU upload after that,
+// GL calls have to stay on the thread that owns the context.
+struct Subdivide_Job {
+    std::thread thread;
+
+    std::atomic<int>   stage;
+    std::atomic<float> mesh_progress;
 
-const size_t MAX_CUBES = 1024 * 10;
+    const struct Cube_Array *source;
+    struct Cube_Array *destination;
+    struct Thread_Pool *pool;
+
+    // Written by the worker, only read once the stage is SUBDIVIDE_READY
+    bool   has_mesh;
+    struct Sponge_Lod lod;
+    double subdivide_seconds;
+    double mesh_seconds;
+    double cache_seconds;
+
+    // Main thread only
+    double start_seconds;
+    double upload_seconds;
+    size_t completed_count;
+    bool   is_from_cache;
+};
 
 struct Scene_Data {
     Camera3D camera;
+
+    struct Thread_Pool *thread_pool;
+    struct Subdivide_Job *subdivide_job;
+
+    // `next_cubes` belongs to the subdivide job while it runs
     struct Cube_Array active_cubes;
     struct Cube_Array next_cubes;
+
+    // GPU copies of every chunk at every level of detail, only rebuilt when the level changes.
+    // `chunk_meshes` is indexed by chunk * SPONGE_LOD_LEVELS + level.
+    struct Sponge_Lod lod;
+    Mesh    *chunk_meshes;
+    Material material;
+
+    // Mapping of the level's cache file when it was loaded from disk, the active cubes and `lod`
+    // point into it until the level changes
+    struct Sponge_Cache cache;
+
+    // R switches to ray marching the distance function on the CPU, which doesn't need cubes at all.
+    // It traces on its own pool so it never waits on a subdivide job holding `thread_pool`.
+    bool   is_raymarching;
+    int    raymarch_depth;
+    double raymarch_seconds;
+    struct Thread_Pool   *render_pool;
+    struct Raymarch_Image raymarch_image;
+    Texture2D             raymarch_texture;
+};
+
+// Every field of the scene data but the ones owning threads, for hot reloading
+const struct Scene_Field SCENE_DATA_FIELDS[] = {
+    SCENE_FIELD(struct Scene_Data, camera),
+    SCENE_FIELD(struct Scene_Data, active_cubes),
+    SCENE_FIELD(struct Scene_Data, next_cubes),
+    SCENE_FIELD(struct Scene_Data, lod),
+    SCENE_FIELD(struct Scene_Data, chunk_meshes),
+    SCENE_FIELD(struct Scene_Data, material),
+    SCENE_FIELD(struct Scene_Data, cache),
+    SCENE_FIELD(struct Scene_Data, is_raymarching),
+    SCENE_FIELD(struct Scene_Data, raymarch_depth),
+    SCENE_FIELD(struct Scene_Data, raymarch_seconds),
+    SCENE_FIELD(struct Scene_Data, raymarch_image),
+    SCENE_FIELD(struct Scene_Data, raymarch_texture),
 };
 
-void cube_create(struct Cube_Array *array, Vector3 position, float width) {
-    if (array->count >= MAX_CUBES) {
-        fprintf(stderr, "array->count: %d\n", array->count);
-        fprintf(stderr, "MAX_CUBES:    %d\n", MAX_CUBES);
-        assert(false && "Out of bounds");
+extern "C" struct Scene_Functions SCENE_EXPORT get_scene_functions(void);
+struct Scene_Functions get_scene_functions(void) {
+    struct Scene_Functions functions = { };
+    functions.init    = &init;
+    functions.update  = &update;
+    functions.destroy = &destroy;
+
+    functions.before_reload = &before_reload;
+    functions.after_reload  = &after_reload;
+
+    functions.layout = SCENE_LAYOUT(struct Scene_Data, 1, SCENE_DATA_FIELDS);
+
+    return functions;
+}
+
+// The ray marched image is traced at a fraction of the canvas and scaled up
+const int RAYMARCH_DOWNSCALE      = 2;
+const int RAYMARCH_DEFAULT_DEPTH  = 4;
+
+// One file per level in the working directory, written when a level is first built
+void sponge_cache_path(int level, char *path, size_t size) {
+    snprintf(path, size, "02_menger_sponge_level_%d.cache", level);
+}
+
+double seconds_now(void) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void chunk_meshes_unload(struct Scene_Data *self) {
+    if (!self->chunk_meshes) return;
+    for (size_t i = 0; i < self->lod.chunk_count * SPONGE_LOD_LEVELS; ++i) {
+        if (self->chunk_meshes[i].vboId) UnloadMesh(self->chunk_meshes[i]);
     }
-    struct Cube *c = &array->cubes[array->count++];
-    c->position = position;
-    c->size     = { width, width, width };
+    free(self->chunk_meshes);
+    self->chunk_meshes = NULL;
 }
 
-void cubes_clear(struct Cube_Array *array) {
-    array->count = 0;
+// Takes over `lod`, uploads its meshes and frees their CPU copies
+void sponge_lod_upload(struct Scene_Data *self, struct Sponge_Lod *lod) {
+    chunk_meshes_unload(self);
+    sponge_lod_destroy(&self->lod);
+    self->lod = *lod;
+    *lod = { };
+
+    self->chunk_meshes = (Mesh *) calloc(self->lod.chunk_count * SPONGE_LOD_LEVELS, sizeof(Mesh));
+    assert(self->chunk_meshes && "Failed to allocate chunk meshes");
+
+    for (size_t c = 0; c < self->lod.chunk_count; ++c) {
+        for (int level = self->lod.chunk_level; level <= self->lod.level; ++level) {
+            struct Sponge_Mesh *sponge_mesh = &self->lod.chunks[c].meshes[level];
+            if (sponge_mesh->vertex_count == 0) continue;
+
+            Mesh *mesh = &self->chunk_meshes[c * SPONGE_LOD_LEVELS + level];
+            mesh->vertexCount   = (int) sponge_mesh->vertex_count;
+            mesh->triangleCount = (int) sponge_mesh->triangle_count;
+            mesh->vertices      = sponge_mesh->vertices;
+            mesh->colors        = sponge_mesh->colors;
+            UploadMesh(mesh, false);
+
+            // The CPU copy is only needed for the upload, and it is ours to free, not raylib's.
+            // Mapped meshes belong to the cache file.
+            mesh->vertices = NULL;
+            mesh->colors   = NULL;
+            if (self->lod.is_mapped) *sponge_mesh = { };
+            else                     sponge_mesh_destroy(sponge_mesh);
+        }
+    }
+
+    fprintf(stderr, "Level %d: %zu triangles before culling, %zu after, in %zu chunks\n",
+        self->lod.level, self->lod.unculled_triangle_count, self->lod.triangle_count, self->lod.chunk_count);
 }
 
-void cube_subdivide(struct Scene_Data *self, struct Cube cube) {
-    for (int x = -1; x < 2; ++x) {
-        for (int y = -1; y < 2; ++y) {
-            for (int z = -1; z < 2; ++z) {
-                int sum = (int) (fabs(x) + fabs(y) + fabs(z));
-                if (sum <= 1) continue;
+void subdivide_job_run(struct Subdivide_Job *job) {
+    double start = seconds_now();
+    cubes_subdivide_parallel(job->source, job->destination, job->pool);
+    double subdivided = seconds_now();
 
-                float w = cube.size.x / 3.f;
-                Vector3 pos = {
-                    cube.position.x + (x * w),
-                    cube.position.y + (y * w),
-                    cube.position.z + (z * w)
-                };
+    job->has_mesh = job->destination->level <= MENGER_MESH_MAX_LEVEL;
+    if (job->has_mesh) {
+        job->stage.store(SUBDIVIDE_MESHING, std::memory_order_relaxed);
+        job->lod = sponge_lod_build(job->destination, job->pool, &job->mesh_progress);
+    }
+    double meshed = seconds_now();
 
-                cube_create(&self->next_cubes, pos, w);
-            }
+    // Written before the upload frees the CPU copies, and off the main thread since it's hundreds
+    // of megabytes at level 5
+    if (job->has_mesh) {
+        job->stage.store(SUBDIVIDE_CACHING, std::memory_order_relaxed);
+        char path[256];
+        sponge_cache_path(job->destination->level, path, sizeof(path));
+        if (!sponge_cache_write(path, job->destination, &job->lod, job->pool)) {
+            fprintf(stderr, "Failed to write %s\n", path);
         }
     }
+
+    job->subdivide_seconds = subdivided - start;
+    job->mesh_seconds      = meshed - subdivided;
+    job->cache_seconds     = seconds_now() - meshed;
+    job->stage.store(SUBDIVIDE_READY, std::memory_order_release);
 }
 
-void cubes_subdivide(struct Scene_Data *self) {
-    cubes_clear(&self->next_cubes);
-    for (size_t cube_index = 0; cube_index < self->active_cubes.count; ++cube_index) {
-        struct Cube cube = self->active_cubes.cubes[cube_index];
-        cube_subdivide(self, cube);
+// Makes `level` active straight from its cache file, if there is a current one. Only call this
+// while the subdivide job is idle, it uses the job's pool and replaces the cubes the job reads.
+bool sponge_cache_load(struct Scene_Data *self, int level) {
+    char path[256];
+    sponge_cache_path(level, path, sizeof(path));
+
+    struct Sponge_Cache cache = { };
+    if (!sponge_cache_open(path, level, self->thread_pool, &cache)) return false;
+
+    sponge_cache_cubes(&cache, &self->active_cubes);
+    struct Sponge_Lod lod = sponge_cache_lod(&cache);
+    sponge_lod_upload(self, &lod);
+
+    // Nothing points into the previous level's mapping anymore
+    sponge_cache_close(&self->cache);
+    self->cache = cache;
+    return true;
+}
+
+void cubes_subdivide_start(struct Scene_Data *self) {
+    struct Subdivide_Job *job = self->subdivide_job;
+    if (job->stage.load(std::memory_order_acquire) != SUBDIVIDE_IDLE) return;
+
+    if (self->active_cubes.level >= MENGER_MAX_LEVEL) {
+        fprintf(stderr, "Already at the maximum level (%d)\n", MENGER_MAX_LEVEL);
+        return;
     }
 
-    memcpy(
-        self->active_cubes.cubes,
-        self->next_cubes.cubes,
-        self->next_cubes.count * sizeof(struct Cube)
-    );
+    int level = self->active_cubes.level + 1;
+    double cache_start = seconds_now();
+    if (level <= MENGER_MESH_MAX_LEVEL && sponge_cache_load(self, level)) {
+        job->upload_seconds   = seconds_now() - cache_start;
+        job->is_from_cache    = true;
+        job->completed_count += 1;
+        return;
+    }
 
-    self->active_cubes.count = self->next_cubes.count;
+    job->source      = &self->active_cubes;
+    job->destination = &self->next_cubes;
+    job->pool        = self->thread_pool;
+    job->has_mesh    = false;
+    job->lod         = { };
+    job->mesh_progress.store(0, std::memory_order_relaxed);
+    job->stage.store(SUBDIVIDE_SUBDIVIDING, std::memory_order_relaxed);
+    job->start_seconds = seconds_now();
+
+    job->thread = std::thread(&subdivide_job_run, job);
 }
 
-void *init(void) {
+// Polled every frame, swaps in the finished level without waiting on an unfinished one
+void cubes_subdivide_finish(struct Scene_Data *self) {
+    struct Subdivide_Job *job = self->subdivide_job;
+    if (job->stage.load(std::memory_order_acquire) != SUBDIVIDE_READY) return;
+
+    if (job->thread.joinable()) job->thread.join();
+
+    // The next level becomes active, and the old level's memory is reused next time
+    struct Cube_Array previous = self->active_cubes;
+    self->active_cubes = self->next_cubes;
+    self->next_cubes   = previous;
+
+    double upload_start = seconds_now();
+    if (job->has_mesh) {
+        sponge_lod_upload(self, &job->lod);
+        sponge_cache_close(&self->cache);
+    } else {
+        fprintf(stderr, "Level %d is too deep to mesh, still showing level %d\n", self->active_cubes.level, self->lod.level);
+    }
+    job->upload_seconds   = seconds_now() - upload_start;
+    job->is_from_cache    = false;
+    job->completed_count += 1;
+
+    job->stage.store(SUBDIVIDE_IDLE, std::memory_order_relaxed);
+}
+
+void subdivide_job_draw_status(const struct Subdivide_Job *job, int x, int y) {
+    switch (job->stage.load(std::memory_order_acquire)) {
+        case SUBDIVIDE_SUBDIVIDING: {
+            DrawText(TextFormat("subdividing... %.0f ms", (seconds_now() - job->start_seconds) * 1e3), x, y, 20, YELLOW);
+        } break;
+
+        case SUBDIVIDE_MESHING: {
+            DrawText(TextFormat("meshing... %3.0f%%  %.0f ms",
+                job->mesh_progress.load(std::memory_order_relaxed) * 100.f, (seconds_now() - job->start_seconds) * 1e3), x, y, 20, YELLOW);
+        } break;
+
+        case SUBDIVIDE_CACHING:
+        case SUBDIVIDE_READY: {
+            DrawText(TextFormat("writing cache... %.0f ms", (seconds_now() - job->start_seconds) * 1e3), x, y, 20, YELLOW);
+        } break;
+
+        case SUBDIVIDE_IDLE: {
+            if (job->completed_count == 0) break;
+            if (job->is_from_cache) {
+                DrawText(TextFormat("last build: loaded from cache in %.1f ms", job->upload_seconds * 1e3), x, y, 20, RAYWHITE);
+                break;
+            }
+            DrawText(TextFormat("last build: subdivide %.1f ms, mesh %.1f ms, cache %.1f ms, upload %.1f ms",
+                job->subdivide_seconds * 1e3, job->mesh_seconds * 1e3, job->cache_seconds * 1e3, job->upload_seconds * 1e3), x, y, 20, RAYWHITE);
+        } break;
+    }
+}
+
+// Back to the single level 0 cube, for starting over after a cached level was picked up
+void sponge_reset(struct Scene_Data *self) {
+    cubes_reserve(&self->active_cubes, 0, 1);
+    cube_create(&self->active_cubes, { 0, 0, 0 });
+
+    struct Sponge_Lod lod = sponge_lod_build(&self->active_cubes, self->thread_pool, NULL);
+    sponge_lod_upload(self, &lod);
+    sponge_cache_close(&self->cache);
+}
+
+void *init(uint64_t seed) {
+    // The sponge is the same every run, nothing in it is random
+    (void) seed;
+
     struct Scene_Data *self = (struct Scene_Data *) malloc(sizeof(struct Scene_Data));
     assert(self && "failed to allocate scene data");
     memset(self, 0, sizeof(struct Scene_Data));
@@ -105,13 +342,39 @@ void *init(void) {
         self->camera.projection = CAMERA_PERSPECTIVE;
     }
 
-    self->active_cubes.cubes = (struct Cube *) calloc(MAX_CUBES, sizeof(struct Cube));
-    assert(self->active_cubes.cubes && "failed to allocate cubes");
+    self->thread_pool = thread_pool_create(thread_pool_default_thread_count());
+
+    // Either buffer can end up holding the deepest level, so both reserve for it
+    self->active_cubes = cubes_create(MENGER_MAX_LEVEL);
+    self->next_cubes   = cubes_create(MENGER_MAX_LEVEL);
 
-    self->next_cubes.cubes = (struct Cube *) calloc(MAX_CUBES, sizeof(struct Cube));
-    assert(self->next_cubes.cubes && "failed to allocate cubes");
+    self->subdivide_job = new Subdivide_Job();
+
+    self->render_pool    = thread_pool_create(thread_pool_default_thread_count());
+    self->raymarch_depth = RAYMARCH_DEFAULT_DEPTH;
+    self->raymarch_image = raymarch_image_create((int) CANVAS_SIZE.x / RAYMARCH_DOWNSCALE, (int) CANVAS_SIZE.y / RAYMARCH_DOWNSCALE);
+    {
+        Image image = { };
+        image.data    = self->raymarch_image.pixels;
+        image.width   = self->raymarch_image.width;
+        image.height  = self->raymarch_image.height;
+        image.mipmaps = 1;
+        image.format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+        self->raymarch_texture = LoadTextureFromImage(image);
+    }
+
+    self->material = LoadMaterialDefault();
+
+    // Picks up at the deepest level built before, which is a mapping and an upload instead of
+    // seconds of subdividing and meshing
+    bool is_cached = false;
+    for (int level = MENGER_MESH_MAX_LEVEL; level > 0 && !is_cached; --level) {
+        double start = seconds_now();
+        is_cached = sponge_cache_load(self, level);
+        if (is_cached) fprintf(stderr, "Loaded level %d from cache in %.1f ms\n", level, (seconds_now() - start) * 1e3);
+    }
+    if (!is_cached) sponge_reset(self);
 
-    cube_create(&self->active_cubes, { 0, 0, 0 }, 5);
     return (void *) self;
 }
 
@@ -120,17 +383,83 @@ void update(void *scene_data, float delta_time) {
 
     UpdateCamera(&self->camera, CAMERA_ORBITAL);
 
-    if (IsKeyPressed(KEY_SPACE)) cubes_subdivide(self);
+    // Keeps drawing the current level until the next one is ready
+    if (IsKeyPressed(KEY_SPACE)) cubes_subdivide_start(self);
+    cubes_subdivide_finish(self);
+    if (IsKeyPressed(KEY_BACKSPACE) && self->subdivide_job->stage.load(std::memory_order_acquire) == SUBDIVIDE_IDLE) sponge_reset(self);
+
+    if (IsKeyPressed(KEY_R)) self->is_raymarching = !self->is_raymarching;
+    if (IsKeyPressed(KEY_UP)   && self->raymarch_depth < RAYMARCH_MAX_DEPTH) self->raymarch_depth += 1;
+    if (IsKeyPressed(KEY_DOWN) && self->raymarch_depth > 0)                  self->raymarch_depth -= 1;
+
+    float position[3] = { self->camera.position.x, self->camera.position.y, self->camera.position.z };
+    float target[3]   = { self->camera.target.x,   self->camera.target.y,   self->camera.target.z   };
+    float up[3]       = { self->camera.up.x,       self->camera.up.y,       self->camera.up.z       };
+
+    if (self->is_raymarching) {
+        struct Raymarch_Image *image = &self->raymarch_image;
+        struct Sponge_View view = sponge_view_create(position, target, up, self->camera.fovy,
+            (float) image->width / (float) image->height, (float) image->height);
+
+        double start = seconds_now();
+        raymarch_render(image, &view, self->raymarch_depth, self->render_pool);
+        self->raymarch_seconds = seconds_now() - start;
+        UpdateTexture(self->raymarch_texture, image->pixels);
 
-    BeginMode3D(self->camera);
         ClearBackground(BLACK);
-        for (size_t cube_index = 0; cube_index < self->active_cubes.count; ++cube_index) {
-            struct Cube cube = self->active_cubes.cubes[cube_index];
-            DrawCubeV(cube.position, cube.size, RED);
-            DrawCubeWiresV(cube.position, cube.size, MAROON);
-        }
-        DrawGrid(10, 1.0f);
-    EndMode3D();
+        Rectangle source      = { 0, 0, (float) image->width, (float) image->height };
+        Rectangle destination = { 0, 0, CANVAS_SIZE.x, CANVAS_SIZE.y };
+        DrawTexturePro(self->raymarch_texture, source, destination, { 0, 0 }, 0, WHITE);
+    } else {
+        struct Sponge_View view = sponge_view_create(position, target, up, self->camera.fovy, CANVAS_SIZE.x / CANVAS_SIZE.y, CANVAS_SIZE.y);
+        sponge_lod_select(&self->lod, &view);
+
+        BeginMode3D(self->camera);
+            ClearBackground(BLACK);
+            for (size_t i = 0; i < self->lod.draw_count; ++i) {
+                struct Sponge_Lod_Draw draw = self->lod.draws[i];
+                DrawMesh(self->chunk_meshes[draw.chunk * SPONGE_LOD_LEVELS + draw.level], self->material, MatrixIdentity());
+            }
+            DrawGrid(10, 1.0f);
+        EndMode3D();
+    }
+
+    DrawText(TextFormat("level %d, %zu cubes", self->active_cubes.level, self->active_cubes.count), 10, 10, 20, RAYWHITE);
+    DrawText(TextFormat("drawing %zu of %zu triangles, %zu of %zu chunks (%zu before face culling)",
+        self->lod.drawn_triangle_count, self->lod.triangle_count, self->lod.draw_count, self->lod.chunk_count,
+        self->lod.unculled_triangle_count), 10, 35, 20, RAYWHITE);
+    subdivide_job_draw_status(self->subdivide_job, 10, 60);
+
+    if (self->is_raymarching) {
+        double rays = (double) self->raymarch_image.width * (double) self->raymarch_image.height;
+        DrawText(TextFormat("ray marching depth %d (up/down): %.1f ms, %.1f Mrays/s", self->raymarch_depth,
+            self->raymarch_seconds * 1e3, rays / self->raymarch_seconds / 1e6), 10, 85, 20, RAYWHITE);
+    }
+}
+
+// The subdivide job and both pools run this library's code on their threads, so a reload ends
+// them and the new library starts its own. A build in progress is waited for and swapped in, the
+// same as on the next frame.
+void before_reload(void *scene_data) {
+    struct Scene_Data *self = (struct Scene_Data *) scene_data;
+
+    struct Subdivide_Job *job = self->subdivide_job;
+    if (job->thread.joinable()) job->thread.join();
+    cubes_subdivide_finish(self);
+    delete job;
+    self->subdivide_job = NULL;
+
+    thread_pool_destroy(self->render_pool);
+    thread_pool_destroy(self->thread_pool);
+    self->render_pool = NULL;
+    self->thread_pool = NULL;
+}
+
+void after_reload(void *scene_data) {
+    struct Scene_Data *self = (struct Scene_Data *) scene_data;
+    if (!self->subdivide_job) self->subdivide_job = new Subdivide_Job();
+    if (!self->thread_pool)   self->thread_pool   = thread_pool_create(thread_pool_default_thread_count());
+    if (!self->render_pool)   self->render_pool   = thread_pool_create(thread_pool_default_thread_count());
 }
 
 void destroy(void *scene_data) {
@@ -138,7 +467,24 @@ void destroy(void *scene_data) {
     DEFER(fprintf(stderr, "Unloaded scene\n"));
     DEFER(free(self));
 
-    free(self->active_cubes.cubes);
-    free(self->next_cubes.cubes);
+    // @TODO: The job can't be cancelled, so unloading mid-build waits for it to finish. There is
+    // no job after `before_reload`.
+    struct Subdivide_Job *job = self->subdivide_job;
+    if (job) {
+        if (job->thread.joinable()) job->thread.join();
+        if (job->has_mesh && job->stage.load(std::memory_order_acquire) == SUBDIVIDE_READY) sponge_lod_destroy(&job->lod);
+        delete job;
+    }
+
+    chunk_meshes_unload(self);
+    sponge_lod_destroy(&self->lod);
+    sponge_cache_close(&self->cache);
+    UnloadMaterial(self->material);
+    UnloadTexture(self->raymarch_texture);
+    raymarch_image_destroy(&self->raymarch_image);
+    thread_pool_destroy(self->render_pool);
+    thread_pool_destroy(self->thread_pool);
+    cubes_destroy(&self->active_cubes);
+    cubes_destroy(&self->next_cubes);
 }
 
@@ -0,0 +1,419 @@
+#pragma once
+#ifndef E_MENGER_SPONGE_CACHE_H
+#define E_MENGER_SPONGE_CACHE_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#include "WinDef.h"
+#include "winbase.h"
+#include "processthreadsapi.h"
+#else
+#include <unistd.h>
+#endif
+
+#include "common/mapped_file.h"
+#include "common/thread_pool.h"
+
+#include "02_menger_sponge_cubes.h"
+#include "02_menger_sponge_lod.h"
+#include "02_menger_sponge_mesh.h"
+
+// On-disk cache of a finished level: its cubes, its level of detail hierarchy and every chunk mesh.
+// Arrays are stored exactly as they sit in memory, each at an offset given in the header, so a
+// mapped file is used in place. Only the small chunk table is turned back into structs, the
+// cubes, nodes and vertices are read straight out of the mapping, and uploaded from it.
+//
+// A file is rejected unless its key matches this build's, which covers the format and every
+// constant that shapes the output, and the checksum of everything after the header matches.
+// Little-endian only, like every platform this builds for.
+
+const char     SPONGE_CACHE_MAGIC[8]  = { 'M', 'E', 'N', 'G', 'E', 'R', 'S', 'C' };
+const uint32_t SPONGE_CACHE_VERSION   = 1;
+const size_t   SPONGE_CACHE_ALIGNMENT = 64;
+
+// Checksummed in parallel, one block per job
+const size_t SPONGE_CACHE_BLOCK_SIZE = 1024 * 1024;
+
+struct Sponge_Cache_Header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t key;
+
+    int32_t  level;
+    int32_t  chunk_level;
+
+    uint64_t cube_count;
+    uint64_t cube_offset;
+    uint64_t node_count;
+    uint64_t node_offset;
+    uint64_t chunk_count;
+    uint64_t chunk_offset;
+
+    uint64_t triangle_count;
+    uint64_t unculled_triangle_count;
+
+    uint64_t file_size;
+    uint64_t checksum;
+};
+
+// `Sponge_Lod_Chunk` with file offsets in place of the mesh pointers
+struct Sponge_Cache_Chunk {
+    float    min[3];
+    float    max[3];
+    int32_t  position[3];
+    uint32_t padding;
+
+    uint64_t vertex_counts[SPONGE_LOD_LEVELS];
+    uint64_t triangle_counts[SPONGE_LOD_LEVELS];
+    uint64_t unculled_triangle_counts[SPONGE_LOD_LEVELS];
+    uint64_t vertex_offsets[SPONGE_LOD_LEVELS];
+    uint64_t color_offsets[SPONGE_LOD_LEVELS];
+};
+
+static_assert(sizeof(struct Sponge_Cache_Header) == 112, "Cache header layout changed, bump SPONGE_CACHE_VERSION");
+static_assert(sizeof(struct Sponge_Cache_Chunk) == 40 + 5 * 8 * SPONGE_LOD_LEVELS, "Cache chunk layout changed, bump SPONGE_CACHE_VERSION");
+static_assert(sizeof(struct Sponge_Lod_Node) == 36 && alignof(struct Sponge_Lod_Node) == 4, "Nodes are stored as they are in memory");
+
+struct Sponge_Cache {
+    struct Mapped_File file;
+    const struct Sponge_Cache_Header *header;
+};
+
+size_t sponge_cache_align(size_t offset) {
+    return (offset + SPONGE_CACHE_ALIGNMENT - 1) & ~(SPONGE_CACHE_ALIGNMENT - 1);
+}
+
+// Not cryptographic, only meant to catch stale and damaged files. Eight independent lanes keep
+// the multiplies overlapping, so a block hashes at close to memory bandwidth.
+const uint64_t SPONGE_CACHE_HASH_PRIME = 0x9E3779B97F4A7C15ull;
+
+uint64_t sponge_cache_mix(uint64_t hash, uint64_t value) {
+    hash = (hash ^ value) * SPONGE_CACHE_HASH_PRIME;
+    return hash ^ (hash >> 32);
+}
+
+uint64_t sponge_cache_hash(const uint8_t *data, size_t size, uint64_t seed) {
+    uint64_t lanes[8] = { seed, seed + 1, seed + 2, seed + 3, seed + 4, seed + 5, seed + 6, seed + 7 };
+
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        for (int k = 0; k < 8; ++k) {
+            uint64_t word;
+            memcpy(&word, &data[i + (size_t) k * 8], sizeof(word));
+            lanes[k] = sponge_cache_mix(lanes[k], word);
+        }
+    }
+
+    uint64_t hash = sponge_cache_mix(seed, size);
+    for (int k = 0; k < 8; ++k) hash = sponge_cache_mix(hash, lanes[k]);
+    for (; i < size; ++i) hash = sponge_cache_mix(hash, data[i]);
+    return hash;
+}
+
+struct Sponge_Cache_Checksum_Job {
+    const uint8_t *data;
+    size_t size;
+    uint64_t *block_hashes;
+};
+
+void sponge_cache_checksum_block(void *user_data, size_t block) {
+    struct Sponge_Cache_Checksum_Job *job = (struct Sponge_Cache_Checksum_Job *) user_data;
+    size_t begin = block * SPONGE_CACHE_BLOCK_SIZE;
+    size_t end   = begin + SPONGE_CACHE_BLOCK_SIZE < job->size ? begin + SPONGE_CACHE_BLOCK_SIZE : job->size;
+    job->block_hashes[block] = sponge_cache_hash(&job->data[begin], end - begin, block);
+}
+
+// Hash of the per-block hashes, so it comes out the same for any number of threads
+uint64_t sponge_cache_checksum(const uint8_t *data, size_t size, struct Thread_Pool *pool) {
+    struct Sponge_Cache_Checksum_Job job = { };
+    job.data = data;
+    job.size = size;
+
+    size_t block_count = (size + SPONGE_CACHE_BLOCK_SIZE - 1) / SPONGE_CACHE_BLOCK_SIZE;
+    job.block_hashes = (uint64_t *) calloc(block_count ? block_count : 1, sizeof(uint64_t));
+    assert(job.block_hashes && "Failed to allocate cache checksum");
+
+    thread_pool_run(pool, block_count, &sponge_cache_checksum_block, &job);
+    uint64_t checksum = sponge_cache_hash((const uint8_t *) job.block_hashes, block_count * sizeof(uint64_t), size);
+
+    free(job.block_hashes);
+    return checksum;
+}
+
+void sponge_cache_key_append(uint8_t *buffer, size_t *used, size_t capacity, const void *data, size_t size) {
+    assert(*used + size <= capacity && "Cache key buffer too small");
+    memcpy(&buffer[*used], data, size);
+    *used += size;
+}
+
+// Changes whenever anything that shapes the cached data does, so files from an older build are
+// rejected instead of drawing the wrong thing
+uint64_t sponge_cache_key(void) {
+    uint8_t buffer[1024];
+    size_t used = 0;
+
+    uint32_t version = SPONGE_CACHE_VERSION;
+    uint32_t sizes[4] = {
+        (uint32_t) sizeof(struct Sponge_Cache_Header), (uint32_t) sizeof(struct Sponge_Cache_Chunk),
+        (uint32_t) sizeof(struct Sponge_Lod_Node),     (uint32_t) sizeof(Cube_Code),
+    };
+    int32_t constants[4] = { Menger_Rule::SPLIT, Menger_Rule::CHILD_COUNT, MENGER_CHUNK_DEPTH, SPONGE_LOD_LEVELS };
+
+    sponge_cache_key_append(buffer, &used, sizeof(buffer), &version, sizeof(version));
+    sponge_cache_key_append(buffer, &used, sizeof(buffer), sizes, sizeof(sizes));
+    sponge_cache_key_append(buffer, &used, sizeof(buffer), constants, sizeof(constants));
+    sponge_cache_key_append(buffer, &used, sizeof(buffer), Menger_Rule::CHILDREN.x, sizeof(uint32_t) * Menger_Rule::CHILD_COUNT);
+    sponge_cache_key_append(buffer, &used, sizeof(buffer), Menger_Rule::CHILDREN.y, sizeof(uint32_t) * Menger_Rule::CHILD_COUNT);
+    sponge_cache_key_append(buffer, &used, sizeof(buffer), Menger_Rule::CHILDREN.z, sizeof(uint32_t) * Menger_Rule::CHILD_COUNT);
+    sponge_cache_key_append(buffer, &used, sizeof(buffer), &MENGER_SIZE, sizeof(MENGER_SIZE));
+    sponge_cache_key_append(buffer, &used, sizeof(buffer), SPONGE_MESH_COLOR, sizeof(SPONGE_MESH_COLOR));
+    sponge_cache_key_append(buffer, &used, sizeof(buffer), SPONGE_MESH_SHADE, sizeof(SPONGE_MESH_SHADE));
+
+    return sponge_cache_hash(buffer, used, 0);
+}
+
+bool sponge_cache_write_at(FILE *file, size_t *offset, size_t target, const void *data, size_t size) {
+    static const uint8_t ZEROS[SPONGE_CACHE_ALIGNMENT] = { };
+    assert(target >= *offset && target - *offset <= SPONGE_CACHE_ALIGNMENT && "Cache layout out of order");
+
+    if (target > *offset && fwrite(ZEROS, 1, target - *offset, file) != target - *offset) return false;
+    if (size > 0 && fwrite(data, 1, size, file) != size) return false;
+    *offset = target + size;
+    return true;
+}
+
+// The file is written under a name of its own in the same directory and only moved over `path`
+// once it is complete, so a cache that is there is never one being written, and a crash or a
+// failed write leaves the previous one as it was.
+bool sponge_cache_temp_path(const char *path, char *temp_path, size_t size) {
+#if defined(_WIN32)
+    unsigned long pid = (unsigned long) GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long) getpid();
+#endif
+    int length = snprintf(temp_path, size, "%s.tmp.%lu", path, pid);
+    return length > 0 && (size_t) length < size;
+}
+
+// rename() doesn't replace an existing file on Windows
+bool sponge_cache_replace(const char *temp_path, const char *path) {
+#if defined(_WIN32)
+    return MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(temp_path, path) == 0;
+#endif
+}
+
+// Writes `cubes` and the meshes of `lod`, which must still have their CPU copies.
+// The header goes in last, so a write cut short never leaves a file that opens.
+bool sponge_cache_write(const char *path, const struct Cube_Array *cubes, const struct Sponge_Lod *lod, struct Thread_Pool *pool) {
+    assert(cubes->level == lod->level && "Cubes and meshes are from different levels");
+
+    struct Sponge_Cache_Header header = { };
+    memcpy(header.magic, SPONGE_CACHE_MAGIC, sizeof(header.magic));
+    header.version                 = SPONGE_CACHE_VERSION;
+    header.header_size             = (uint32_t) sizeof(header);
+    header.key                     = sponge_cache_key();
+    header.level                   = lod->level;
+    header.chunk_level             = lod->chunk_level;
+    header.cube_count              = cubes->count;
+    header.node_count              = lod->node_count;
+    header.chunk_count             = lod->chunk_count;
+    header.triangle_count          = lod->triangle_count;
+    header.unculled_triangle_count = lod->unculled_triangle_count;
+
+    // Lay everything out first so the chunk table can be written before the meshes it points at
+    size_t offset = sponge_cache_align(sizeof(header));
+    header.cube_offset  = offset; offset = sponge_cache_align(offset + cubes->count    * sizeof(Cube_Code));
+    header.node_offset  = offset; offset = sponge_cache_align(offset + lod->node_count  * sizeof(struct Sponge_Lod_Node));
+    header.chunk_offset = offset; offset = sponge_cache_align(offset + lod->chunk_count * sizeof(struct Sponge_Cache_Chunk));
+
+    struct Sponge_Cache_Chunk *chunks = (struct Sponge_Cache_Chunk *) calloc(lod->chunk_count ? lod->chunk_count : 1, sizeof(struct Sponge_Cache_Chunk));
+    assert(chunks && "Failed to allocate cache chunk table");
+
+    for (size_t c = 0; c < lod->chunk_count; ++c) {
+        const struct Sponge_Lod_Chunk *chunk = &lod->chunks[c];
+        struct Sponge_Cache_Chunk *record = &chunks[c];
+        memcpy(record->min, chunk->min, sizeof(record->min));
+        memcpy(record->max, chunk->max, sizeof(record->max));
+        record->position[0] = chunk->position.x;
+        record->position[1] = chunk->position.y;
+        record->position[2] = chunk->position.z;
+
+        for (int level = 0; level < SPONGE_LOD_LEVELS; ++level) {
+            const struct Sponge_Mesh *mesh = &chunk->meshes[level];
+            assert((mesh->vertices || chunk->triangle_counts[level] == 0) && "Meshes were already freed");
+
+            record->vertex_counts[level]            = mesh->vertex_count;
+            record->triangle_counts[level]          = mesh->triangle_count;
+            record->unculled_triangle_counts[level] = mesh->unculled_triangle_count;
+            record->vertex_offsets[level] = offset; offset = sponge_cache_align(offset + mesh->vertex_count * 3 * sizeof(float));
+            record->color_offsets[level]  = offset; offset = sponge_cache_align(offset + mesh->vertex_count * 4 * sizeof(unsigned char));
+        }
+    }
+    header.file_size = offset;
+
+    char temp_path[1024];
+    FILE *file = sponge_cache_temp_path(path, temp_path, sizeof(temp_path)) ? fopen(temp_path, "wb") : NULL;
+    if (!file) {
+        free(chunks);
+        return false;
+    }
+
+    // Zeroed until the payload is complete and checksummed
+    struct Sponge_Cache_Header blank = { };
+    size_t written = 0;
+    bool ok = sponge_cache_write_at(file, &written, 0, &blank, sizeof(blank));
+    ok = ok && sponge_cache_write_at(file, &written, header.cube_offset,  cubes->cubes, cubes->count * sizeof(Cube_Code));
+    ok = ok && sponge_cache_write_at(file, &written, header.node_offset,  lod->nodes,   lod->node_count * sizeof(struct Sponge_Lod_Node));
+    ok = ok && sponge_cache_write_at(file, &written, header.chunk_offset, chunks,       lod->chunk_count * sizeof(struct Sponge_Cache_Chunk));
+    for (size_t c = 0; ok && c < lod->chunk_count; ++c) {
+        for (int level = 0; ok && level < SPONGE_LOD_LEVELS; ++level) {
+            const struct Sponge_Mesh *mesh = &lod->chunks[c].meshes[level];
+            ok = ok && sponge_cache_write_at(file, &written, chunks[c].vertex_offsets[level], mesh->vertices, mesh->vertex_count * 3 * sizeof(float));
+            ok = ok && sponge_cache_write_at(file, &written, chunks[c].color_offsets[level],  mesh->colors,   mesh->vertex_count * 4 * sizeof(unsigned char));
+        }
+    }
+    ok = ok && sponge_cache_write_at(file, &written, header.file_size, NULL, 0);
+    ok = (fclose(file) == 0) && ok;
+    free(chunks);
+
+    // Checksummed from the file itself, which the OS still has cached, rather than piece by piece
+    struct Mapped_File mapped = { };
+    ok = ok && mapped_file_open(temp_path, &mapped);
+    if (ok) {
+        ok = mapped.size == header.file_size;
+        if (ok) header.checksum = sponge_cache_checksum(&mapped.data[sizeof(header)], mapped.size - sizeof(header), pool);
+        mapped_file_close(&mapped);
+    }
+
+    file = ok ? fopen(temp_path, "r+b") : NULL;
+    if (file) {
+        ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = (fflush(file) == 0) && ok;
+        ok = (fclose(file) == 0) && ok;
+    } else {
+        ok = false;
+    }
+
+    ok = ok && sponge_cache_replace(temp_path, path);
+    if (!ok) remove(temp_path);
+    return ok;
+}
+
+bool sponge_cache_range_fits(const struct Sponge_Cache *cache, uint64_t offset, uint64_t count, size_t element_size) {
+    uint64_t size = cache->file.size;
+    if (offset > size || offset % alignof(uint32_t) != 0) return false;
+    return count <= (size - offset) / element_size;
+}
+
+const struct Sponge_Cache_Chunk *sponge_cache_chunks(const struct Sponge_Cache *cache) {
+    return (const struct Sponge_Cache_Chunk *) &cache->file.data[cache->header->chunk_offset];
+}
+
+// Maps the cache for `level` at `path` and checks that it is current and intact. Nothing is
+// parsed or copied, the checksum is the only pass over the data. False leaves `cache` closed.
+bool sponge_cache_open(const char *path, int level, struct Thread_Pool *pool, struct Sponge_Cache *cache) {
+    *cache = { };
+    if (!mapped_file_open(path, &cache->file)) return false;
+
+    const struct Sponge_Cache_Header *header = (const struct Sponge_Cache_Header *) cache->file.data;
+    cache->header = header;
+
+    bool ok = cache->file.size >= sizeof(struct Sponge_Cache_Header)
+           && memcmp(header->magic, SPONGE_CACHE_MAGIC, sizeof(header->magic)) == 0
+           && header->version     == SPONGE_CACHE_VERSION
+           && header->header_size == sizeof(struct Sponge_Cache_Header)
+           && header->key         == sponge_cache_key()
+           && header->level       == level
+           && header->file_size   == cache->file.size
+           && header->level <= MENGER_MESH_MAX_LEVEL
+           && header->chunk_level >= 0 && header->chunk_level <= header->level
+           && header->cube_count  == menger_cube_count(level)
+           && sponge_cache_range_fits(cache, header->cube_offset,  header->cube_count,  sizeof(Cube_Code))
+           && sponge_cache_range_fits(cache, header->node_offset,  header->node_count,  sizeof(struct Sponge_Lod_Node))
+           && sponge_cache_range_fits(cache, header->chunk_offset, header->chunk_count, sizeof(struct Sponge_Cache_Chunk))
+           && header->chunk_offset % alignof(struct Sponge_Cache_Chunk) == 0;
+
+    for (size_t c = 0; ok && c < header->chunk_count; ++c) {
+        const struct Sponge_Cache_Chunk *chunk = &sponge_cache_chunks(cache)[c];
+        for (int l = 0; ok && l < SPONGE_LOD_LEVELS; ++l) {
+            ok = sponge_cache_range_fits(cache, chunk->vertex_offsets[l], chunk->vertex_counts[l], 3 * sizeof(float))
+              && sponge_cache_range_fits(cache, chunk->color_offsets[l],  chunk->vertex_counts[l], 4 * sizeof(unsigned char));
+        }
+    }
+
+    ok = ok && header->checksum == sponge_cache_checksum(&cache->file.data[sizeof(*header)], cache->file.size - sizeof(*header), pool);
+
+    if (!ok) {
+        mapped_file_close(&cache->file);
+        *cache = { };
+    }
+    return ok;
+}
+
+void sponge_cache_close(struct Sponge_Cache *cache) {
+    mapped_file_close(&cache->file);
+    *cache = { };
+}
+
+// Points `array` at the mapped cubes. Its arena stays its own for the next time it is refilled,
+// until then the cache has to stay open.
+void sponge_cache_cubes(const struct Sponge_Cache *cache, struct Cube_Array *array) {
+    arena_reset(&array->arena);
+    array->level    = cache->header->level;
+    array->count    = cache->header->cube_count;
+    array->capacity = cache->header->cube_count;
+    array->cubes    = (Cube_Code *) &cache->file.data[cache->header->cube_offset];
+}
+
+// A level of detail hierarchy whose nodes and meshes point into the mapping. Only the chunk table
+// and the draw list are allocated. The mapping is read-only, the meshes must only be read.
+struct Sponge_Lod sponge_cache_lod(const struct Sponge_Cache *cache) {
+    const struct Sponge_Cache_Header *header = cache->header;
+
+    struct Sponge_Lod lod = { };
+    lod.is_mapped               = true;
+    lod.level                   = header->level;
+    lod.chunk_level             = header->chunk_level;
+    lod.node_count              = header->node_count;
+    lod.nodes                   = (struct Sponge_Lod_Node *) &cache->file.data[header->node_offset];
+    lod.chunk_count             = header->chunk_count;
+    lod.triangle_count          = header->triangle_count;
+    lod.unculled_triangle_count = header->unculled_triangle_count;
+
+    lod.chunks = (struct Sponge_Lod_Chunk *) calloc(lod.chunk_count ? lod.chunk_count : 1, sizeof(struct Sponge_Lod_Chunk));
+    lod.draws  = (struct Sponge_Lod_Draw *)  calloc(lod.chunk_count ? lod.chunk_count : 1, sizeof(struct Sponge_Lod_Draw));
+    assert(lod.chunks && lod.draws && "Failed to allocate sponge LOD");
+
+    for (size_t c = 0; c < lod.chunk_count; ++c) {
+        const struct Sponge_Cache_Chunk *record = &sponge_cache_chunks(cache)[c];
+        struct Sponge_Lod_Chunk *chunk = &lod.chunks[c];
+        memcpy(chunk->min, record->min, sizeof(chunk->min));
+        memcpy(chunk->max, record->max, sizeof(chunk->max));
+        chunk->position = { record->position[0], record->position[1], record->position[2] };
+
+        for (int level = 0; level < SPONGE_LOD_LEVELS; ++level) {
+            struct Sponge_Mesh *mesh = &chunk->meshes[level];
+            mesh->level                   = level;
+            mesh->vertex_count            = record->vertex_counts[level];
+            mesh->vertex_capacity         = record->vertex_counts[level];
+            mesh->triangle_count          = record->triangle_counts[level];
+            mesh->unculled_triangle_count = record->unculled_triangle_counts[level];
+            mesh->vertices = (float *)         &cache->file.data[record->vertex_offsets[level]];
+            mesh->colors   = (unsigned char *) &cache->file.data[record->color_offsets[level]];
+            chunk->triangle_counts[level] = mesh->triangle_count;
+        }
+    }
+
+    return lod;
+}
+
+#endif // E_MENGER_SPONGE_CACHE_H
@@ -0,0 +1,356 @@
+#pragma once
+#ifndef E_MENGER_SPONGE_CUBES_H
+#define E_MENGER_SPONGE_CUBES_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "common/arena.h"
+#include "common/math.h"
+#include "common/morton.h"
+#include "common/thread_pool.h"
+
+// Cube storage and subdivision for 02_menger_sponge, kept free of raylib so it can run headless.
+//
+// Cubes are stored packed: every cube at a level has the same size and sits on the level's
+// lattice (3^level for the sponge), so the array keeps the level once and each cube is just its Morton-coded lattice
+// position. 4 bytes per cube instead of 24 for a float position and size.
+typedef uint32_t Cube_Code;
+
+// Each cube array lives in its own arena, sized exactly for the level it holds
+struct Cube_Array {
+    int    level;
+    size_t count;
+    size_t capacity;
+    Cube_Code *cubes;
+    struct Arena arena;
+};
+
+// Subdivision rules. A rule splits a cube into N x N x N children and keeps the ones its mask
+// marks, so a level n array holds kept^n cubes on an N^level lattice. Everything about a rule is
+// known at compile time: each instantiation gets its own child table and fully unrolled inner loop.
+template <int N>
+struct Ifs_Keep_Mask {
+    bool keep[N * N * N];  // Child (x, y, z) at x + N * (y + N * z)
+};
+
+template <int N>
+constexpr struct Ifs_Keep_Mask<N> ifs_keep_mask_create(bool (*keep)(int x, int y, int z)) {
+    struct Ifs_Keep_Mask<N> mask = { };
+    for (int z = 0; z < N; ++z) {
+        for (int y = 0; y < N; ++y) {
+            for (int x = 0; x < N; ++x) mask.keep[x + N * (y + N * z)] = keep(x, y, z);
+        }
+    }
+    return mask;
+}
+
+template <int N>
+constexpr int ifs_keep_mask_count(const struct Ifs_Keep_Mask<N> &mask) {
+    int count = 0;
+    for (int i = 0; i < N * N * N; ++i) count += mask.keep[i] ? 1 : 0;
+    return count;
+}
+
+constexpr int ifs_lattice_size(int split, int level) { return level == 0 ? 1 : split * ifs_lattice_size(split, level - 1); }
+
+// Deepest level whose lattice still fits the 10 bits per axis of a Morton code
+constexpr int ifs_max_level(int split) {
+    int level = 0;
+    while (ifs_lattice_size(split, level + 1) - 1 <= (int) MORTON_AXIS_MAX) level += 1;
+    return level;
+}
+
+// Kept children in the order the loops below emit them (x fastest, the same order as the mask).
+// Offsets are stored per axis as Morton-spread values so a child is one `morton_add` away from
+// its parent's scaled code. Padded to whole 8-wide vectors so every group loads aligned.
+template <int COUNT>
+struct Ifs_Child_Table {
+    static constexpr int PADDED_COUNT = (COUNT + 7) / 8 * 8;
+
+    alignas(32) uint32_t x[PADDED_COUNT];
+    alignas(32) uint32_t y[PADDED_COUNT];
+    alignas(32) uint32_t z[PADDED_COUNT];
+};
+
+template <int N, int COUNT>
+constexpr struct Ifs_Child_Table<COUNT> ifs_child_table_create(const struct Ifs_Keep_Mask<N> &mask) {
+    struct Ifs_Child_Table<COUNT> table = { };
+    int count = 0;
+    for (int z = 0; z < N; ++z) {
+        for (int y = 0; y < N; ++y) {
+            for (int x = 0; x < N; ++x) {
+                if (!mask.keep[x + N * (y + N * z)]) continue;
+                table.x[count] = morton_spread((uint32_t) x);
+                table.y[count] = morton_spread((uint32_t) y) << 1;
+                table.z[count] = morton_spread((uint32_t) z) << 2;
+                count += 1;
+            }
+        }
+    }
+    return table;
+}
+
+template <int N, struct Ifs_Keep_Mask<N> MASK>
+struct Ifs_Rule {
+    static constexpr int SPLIT       = N;
+    static constexpr int CHILD_COUNT = ifs_keep_mask_count(MASK);
+    static constexpr int MAX_LEVEL   = ifs_max_level(N);
+
+    static constexpr struct Ifs_Child_Table<CHILD_COUNT> CHILDREN = ifs_child_table_create<N, CHILD_COUNT>(MASK);
+};
+
+constexpr int ifs_abs(int v) { return v < 0 ? -v : v; }
+
+// Menger sponge: everything but the center and the six face centers, 20 of 27
+constexpr bool menger_keep(int x, int y, int z) {
+    return ifs_abs(x - 1) + ifs_abs(y - 1) + ifs_abs(z - 1) > 1;
+}
+
+// Mosely snowflake (the lighter variant): everything but the center and the eight corners, 18 of 27
+constexpr bool mosely_keep(int x, int y, int z) {
+    bool is_center = x == 1 && y == 1 && z == 1;
+    bool is_corner = x != 1 && y != 1 && z != 1;
+    return !is_center && !is_corner;
+}
+
+// Jerusalem cube on a 5 x 5 x 5 grid: 2x2x2 blocks in the corners and one cell in the middle of
+// each edge, 76 of 125. The real thing scales its corner cubes by sqrt(2) - 1 and its edge cubes by
+// the square of that, which no uniform grid can express. Here the proportions match (0.4 and 0.2
+// against 0.414 and 0.172) but every cell recurses on its own, so deeper levels drift from the
+// true fractal.
+constexpr bool jerusalem_keep(int x, int y, int z) {
+    int middle = (x == 2) + (y == 2) + (z == 2);
+    if (middle == 0) return true;
+    if (middle > 1)  return false;
+    int outer = (x == 0 || x == 4) + (y == 0 || y == 4) + (z == 0 || z == 4);
+    return outer == 2;
+}
+
+// Sierpinski tetrahedron on a 2 x 2 x 2 grid: the four cells with even coordinate parity, which are
+// the corners of a tetrahedron inscribed in the cube. Keeping them is exactly the tetrahedron's
+// iterated function system, so the cubes converge on the real fractal.
+constexpr bool sierpinski_keep(int x, int y, int z) {
+    return (x + y + z) % 2 == 0;
+}
+
+typedef struct Ifs_Rule<3, ifs_keep_mask_create<3>(&menger_keep)>     Menger_Rule;
+typedef struct Ifs_Rule<3, ifs_keep_mask_create<3>(&mosely_keep)>     Mosely_Rule;
+typedef struct Ifs_Rule<5, ifs_keep_mask_create<5>(&jerusalem_keep)>  Jerusalem_Rule;
+typedef struct Ifs_Rule<2, ifs_keep_mask_create<2>(&sierpinski_keep)> Sierpinski_Rule;
+
+static_assert(Menger_Rule::CHILD_COUNT     == 20, "Menger rule should keep 20 children");
+static_assert(Mosely_Rule::CHILD_COUNT     == 18, "Mosely rule should keep 18 children");
+static_assert(Jerusalem_Rule::CHILD_COUNT  == 76, "Jerusalem rule should keep 76 children");
+static_assert(Sierpinski_Rule::CHILD_COUNT == 4,  "Sierpinski rule should keep 4 children");
+
+// The scene only draws the Menger sponge, so these stay its shorthands.
+// Every subdivision turns one cube into 20, so level n has exactly 20^n cubes.
+const int CUBES_PER_SUBDIVISION = Menger_Rule::CHILD_COUNT;
+const int MENGER_MAX_LEVEL      = 6;
+static_assert(MENGER_MAX_LEVEL == Menger_Rule::MAX_LEVEL, "Lattice does not fit the Morton code");
+
+// The whole sponge, level 0 is one cube of this size centered on the origin
+const float MENGER_SIZE = 5;
+
+constexpr int menger_lattice_size(int level) { return ifs_lattice_size(3, level); }
+
+template <typename Rule>
+size_t ifs_cube_count(int level) {
+    size_t count = 1;
+    for (int i = 0; i < level; ++i) count *= (size_t) Rule::CHILD_COUNT;
+    return count;
+}
+
+size_t menger_cube_count(int level) {
+    return ifs_cube_count<Menger_Rule>(level);
+}
+
+float cube_width(int level) {
+    return MENGER_SIZE / (float) menger_lattice_size(level);
+}
+
+// An empty array with room for any level of `Rule` up to `max_level`
+template <typename Rule>
+struct Cube_Array ifs_cubes_create(int max_level) {
+    struct Cube_Array array = { };
+    array.arena = arena_create(ifs_cube_count<Rule>(max_level) * sizeof(Cube_Code));
+    return array;
+}
+
+struct Cube_Array cubes_create(int max_level) {
+    return ifs_cubes_create<Menger_Rule>(max_level);
+}
+
+void cubes_destroy(struct Cube_Array *array) {
+    arena_destroy(&array->arena);
+    *array = { };
+}
+
+// Drops the current contents and makes room for exactly `capacity` cubes of `level`
+void cubes_reserve(struct Cube_Array *array, int level, size_t capacity) {
+    arena_reset(&array->arena);
+    array->cubes    = ARENA_PUSH_ARRAY(&array->arena, Cube_Code, capacity);
+    array->level    = level;
+    array->capacity = capacity;
+    array->count    = 0;
+}
+
+void cube_create(struct Cube_Array *array, struct Vector3_Int lattice_position) {
+    if (array->count >= array->capacity) {
+        fprintf(stderr, "array->count:    %zu\n", array->count);
+        fprintf(stderr, "array->capacity: %zu\n", array->capacity);
+        assert(false && "Out of bounds");
+    }
+    array->cubes[array->count++] = morton_encode(lattice_position);
+}
+
+// Code of the parent's first child, (Nx, Ny, Nz)
+template <int N>
+Cube_Code ifs_child_base(Cube_Code parent) {
+    struct Vector3_Int p = morton_decode(parent);
+    return morton_encode({ p.x * N, p.y * N, p.z * N });
+}
+
+template <typename Rule, size_t... K>
+void ifs_write_children(Cube_Code base, Cube_Code *out, std::index_sequence<K...>) {
+    ((out[K] = morton_add(base, Rule::CHILDREN.x[K] | Rule::CHILDREN.y[K] | Rule::CHILDREN.z[K])), ...);
+}
+
+// Reference version, one child at a time. The pack expansion unrolls it over the rule's table,
+// so every offset is an immediate.
+template <typename Rule>
+void ifs_subdivide_range_scalar(const struct Cube_Array *source, struct Cube_Array *destination, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        Cube_Code base = ifs_child_base<Rule::SPLIT>(source->cubes[i]);
+        ifs_write_children<Rule>(base, &destination->cubes[i * Rule::CHILD_COUNT], std::make_index_sequence<Rule::CHILD_COUNT>());
+    }
+}
+
+// Writes the children of parents [begin, end). Parent i owns output slots [i*k, i*k + k) for k
+// children per parent, so ranges never overlap and can run on any thread without coordination.
+// Whole vectors first, then a half vector and single children for whatever the rule leaves over.
+template <typename Rule>
+void ifs_subdivide_range(const struct Cube_Array *source, struct Cube_Array *destination, size_t begin, size_t end) {
+    constexpr int COUNT = Rule::CHILD_COUNT;
+    constexpr const struct Ifs_Child_Table<COUNT> &CHILDREN = Rule::CHILDREN;
+
+#if defined(__AVX2__)
+    constexpr int WIDE_END = COUNT / 8 * 8;
+    constexpr int HALF_END = COUNT - WIDE_END >= 4 ? WIDE_END + 4 : WIDE_END;
+
+    const __m256i mask_x = _mm256_set1_epi32((int) MORTON_MASK_X);
+    const __m256i mask_y = _mm256_set1_epi32((int) MORTON_MASK_Y);
+    const __m256i mask_z = _mm256_set1_epi32((int) MORTON_MASK_Z);
+
+    for (size_t i = begin; i < end; ++i) {
+        Cube_Code base = ifs_child_base<Rule::SPLIT>(source->cubes[i]);
+        Cube_Code *out = &destination->cubes[i * COUNT];
+
+        // See `morton_add`, the other axes' bits are set so carries skip over them
+        __m256i base_x = _mm256_set1_epi32((int) (base | ~MORTON_MASK_X));
+        __m256i base_y = _mm256_set1_epi32((int) (base | ~MORTON_MASK_Y));
+        __m256i base_z = _mm256_set1_epi32((int) (base | ~MORTON_MASK_Z));
+
+        for (int k = 0; k < WIDE_END; k += 8) {
+            __m256i x = _mm256_and_si256(_mm256_add_epi32(base_x, _mm256_load_si256((const __m256i *) &CHILDREN.x[k])), mask_x);
+            __m256i y = _mm256_and_si256(_mm256_add_epi32(base_y, _mm256_load_si256((const __m256i *) &CHILDREN.y[k])), mask_y);
+            __m256i z = _mm256_and_si256(_mm256_add_epi32(base_z, _mm256_load_si256((const __m256i *) &CHILDREN.z[k])), mask_z);
+            _mm256_storeu_si256((__m256i *) &out[k], _mm256_or_si256(x, _mm256_or_si256(y, z)));
+        }
+
+        if constexpr (HALF_END > WIDE_END) {
+            __m128i x = _mm_and_si128(_mm_add_epi32(_mm256_castsi256_si128(base_x), _mm_load_si128((const __m128i *) &CHILDREN.x[WIDE_END])), _mm256_castsi256_si128(mask_x));
+            __m128i y = _mm_and_si128(_mm_add_epi32(_mm256_castsi256_si128(base_y), _mm_load_si128((const __m128i *) &CHILDREN.y[WIDE_END])), _mm256_castsi256_si128(mask_y));
+            __m128i z = _mm_and_si128(_mm_add_epi32(_mm256_castsi256_si128(base_z), _mm_load_si128((const __m128i *) &CHILDREN.z[WIDE_END])), _mm256_castsi256_si128(mask_z));
+            _mm_storeu_si128((__m128i *) &out[WIDE_END], _mm_or_si128(x, _mm_or_si128(y, z)));
+        }
+
+        for (int k = HALF_END; k < COUNT; ++k) {
+            out[k] = morton_add(base, CHILDREN.x[k] | CHILDREN.y[k] | CHILDREN.z[k]);
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    constexpr int WIDE_END = COUNT / 4 * 4;
+
+    const __m128i mask_x = _mm_set1_epi32((int) MORTON_MASK_X);
+    const __m128i mask_y = _mm_set1_epi32((int) MORTON_MASK_Y);
+    const __m128i mask_z = _mm_set1_epi32((int) MORTON_MASK_Z);
+
+    for (size_t i = begin; i < end; ++i) {
+        Cube_Code base = ifs_child_base<Rule::SPLIT>(source->cubes[i]);
+        Cube_Code *out = &destination->cubes[i * COUNT];
+
+        __m128i base_x = _mm_set1_epi32((int) (base | ~MORTON_MASK_X));
+        __m128i base_y = _mm_set1_epi32((int) (base | ~MORTON_MASK_Y));
+        __m128i base_z = _mm_set1_epi32((int) (base | ~MORTON_MASK_Z));
+
+        for (int k = 0; k < WIDE_END; k += 4) {
+            __m128i x = _mm_and_si128(_mm_add_epi32(base_x, _mm_load_si128((const __m128i *) &CHILDREN.x[k])), mask_x);
+            __m128i y = _mm_and_si128(_mm_add_epi32(base_y, _mm_load_si128((const __m128i *) &CHILDREN.y[k])), mask_y);
+            __m128i z = _mm_and_si128(_mm_add_epi32(base_z, _mm_load_si128((const __m128i *) &CHILDREN.z[k])), mask_z);
+            _mm_storeu_si128((__m128i *) &out[k], _mm_or_si128(x, _mm_or_si128(y, z)));
+        }
+
+        for (int k = WIDE_END; k < COUNT; ++k) {
+            out[k] = morton_add(base, CHILDREN.x[k] | CHILDREN.y[k] | CHILDREN.z[k]);
+        }
+    }
+#else
+    ifs_subdivide_range_scalar<Rule>(source, destination, begin, end);
+#endif
+}
+
+// Parents per job, small enough to balance across threads and big enough to amortize the hand-off
+const size_t CUBES_SUBDIVIDE_CHUNK_SIZE = 4 * 1024;
+
+struct Cubes_Subdivide_Job {
+    const struct Cube_Array *source;
+    struct Cube_Array *destination;
+};
+
+template <typename Rule>
+void ifs_subdivide_job(void *user_data, size_t chunk) {
+    struct Cubes_Subdivide_Job *job = (struct Cubes_Subdivide_Job *) user_data;
+    size_t begin = chunk * CUBES_SUBDIVIDE_CHUNK_SIZE;
+    size_t end   = begin + CUBES_SUBDIVIDE_CHUNK_SIZE < job->source->count ? begin + CUBES_SUBDIVIDE_CHUNK_SIZE : job->source->count;
+    ifs_subdivide_range<Rule>(job->source, job->destination, begin, end);
+}
+
+// Fills `destination` with the next level of `source`. Every output slot is known up front,
+// so the destination is sized once and written in place from all threads.
+template <typename Rule>
+void ifs_subdivide_parallel(const struct Cube_Array *source, struct Cube_Array *destination, struct Thread_Pool *pool) {
+    assert(source->level < Rule::MAX_LEVEL && "Already at the maximum level");
+
+    cubes_reserve(destination, source->level + 1, source->count * (size_t) Rule::CHILD_COUNT);
+    destination->count = destination->capacity;
+
+    struct Cubes_Subdivide_Job job = { .source = source, .destination = destination };
+    size_t chunk_count = (source->count + CUBES_SUBDIVIDE_CHUNK_SIZE - 1) / CUBES_SUBDIVIDE_CHUNK_SIZE;
+    thread_pool_run(pool, chunk_count, &ifs_subdivide_job<Rule>, &job);
+}
+
+void cubes_subdivide_range_scalar(const struct Cube_Array *source, struct Cube_Array *destination, size_t begin, size_t end) {
+    ifs_subdivide_range_scalar<Menger_Rule>(source, destination, begin, end);
+}
+
+void cubes_subdivide_range(const struct Cube_Array *source, struct Cube_Array *destination, size_t begin, size_t end) {
+    ifs_subdivide_range<Menger_Rule>(source, destination, begin, end);
+}
+
+void cubes_subdivide_parallel(const struct Cube_Array *source, struct Cube_Array *destination, struct Thread_Pool *pool) {
+    ifs_subdivide_parallel<Menger_Rule>(source, destination, pool);
+}
+
+#endif // E_MENGER_SPONGE_CUBES_H
@@ -0,0 +1,357 @@
+#pragma once
+#ifndef E_MENGER_SPONGE_LOD_H
+#define E_MENGER_SPONGE_LOD_H
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include "common/morton.h"
+#include "common/thread_pool.h"
+
+#include "02_menger_sponge_cubes.h"
+#include "02_menger_sponge_mesh.h"
+
+// View-dependent drawing for the sponge, kept free of raylib like the mesher.
+//
+// The sponge is cut into chunks, the cubes MENGER_CHUNK_DEPTH levels above the finest one, and
+// every chunk is meshed once per level from its own single cube down to the finest level.
+// Above the chunks sits the 27-ary hierarchy the sponge already is: a node's children are the
+// cubes kept out of its 3x3x3 split.
+// Selection walks that hierarchy, drops every node outside the view frustum, and draws each
+// visible chunk at the finest level whose cubes are still MENGER_LOD_MIN_PIXELS tall on screen.
+// Drawn triangles follow how much of the screen the sponge covers instead of 20^level.
+//
+// Chunk meshes treat everything outside the chunk as empty, so neighbours at different levels
+// never crack, at the cost of the faces where chunks touch.
+
+// 27 cells across at the finest level, big enough that the faces where chunks touch stay a
+// small part of the mesh (~11% extra at level 5) while level 5 still gets 400 chunks to cull
+const int   MENGER_CHUNK_DEPTH    = 3;
+const float MENGER_LOD_MIN_PIXELS = 2;
+
+// Meshes are indexed by level, so a chunk's entries below the chunk level stay empty
+const int SPONGE_LOD_LEVELS = MENGER_MESH_MAX_LEVEL + 1;
+
+struct Sponge_Lod_Node {
+    float min[3];
+    float max[3];
+
+    // Children are stored next to each other, a node without children is a chunk
+    uint32_t first_child;
+    uint32_t child_count;
+    uint32_t chunk;
+};
+
+struct Sponge_Lod_Chunk {
+    float min[3];
+    float max[3];
+    struct Vector3_Int position;  // On the chunk level's lattice
+
+    // Kept after the meshes are handed to the GPU and freed
+    size_t triangle_counts[SPONGE_LOD_LEVELS];
+    struct Sponge_Mesh meshes[SPONGE_LOD_LEVELS];
+};
+
+struct Sponge_Lod_Draw {
+    uint32_t chunk;
+    int      level;
+};
+
+struct Sponge_Lod {
+    int level;        // Finest level, what the chunks show up close
+    int chunk_level;  // Coarsest level, what the chunks show far away
+
+    size_t node_count;
+    struct Sponge_Lod_Node *nodes;
+
+    size_t chunk_count;
+    struct Sponge_Lod_Chunk *chunks;
+
+    // Of the whole sponge at the finest level, for comparison with what gets drawn
+    size_t triangle_count;
+    size_t unculled_triangle_count;
+
+    // Nodes and meshes point into a mapped cache file (see 02_menger_sponge_cache.h), which owns
+    // them and has to stay open for as long as they are used
+    bool is_mapped;
+
+    // Filled by `sponge_lod_select`
+    size_t draw_count;
+    struct Sponge_Lod_Draw *draws;
+    size_t drawn_triangle_count;
+    size_t culled_node_count;
+};
+
+// Camera reduced to what culling and level selection need
+struct Sponge_View {
+    float position[3];
+    float forward[3];
+    float right[3];
+    float up[3];
+
+    float tan_half_fovy;
+    float aspect;
+    float near;
+    float far;
+    float viewport_height;
+};
+
+float sponge_view_dot(const float a[3], const float b[3]) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+void sponge_view_cross(const float a[3], const float b[3], float out[3]) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+void sponge_view_normalize(float v[3]) {
+    float length_squared = sponge_view_dot(v, v);
+    if (length_squared <= 0) return;
+    float inverse_length = 1.f / sqrtf(length_squared);
+    for (int k = 0; k < 3; ++k) v[k] *= inverse_length;
+}
+
+// Same basis as a look-at matrix, `up` only has to be roughly up
+struct Sponge_View sponge_view_create(const float position[3], const float target[3], const float up[3],
+                                      float fovy_degrees, float aspect, float viewport_height) {
+    struct Sponge_View view = { };
+    for (int k = 0; k < 3; ++k) {
+        view.position[k] = position[k];
+        view.forward[k]  = target[k] - position[k];
+    }
+    sponge_view_normalize(view.forward);
+
+    sponge_view_cross(view.forward, up, view.right);
+    sponge_view_normalize(view.right);
+    sponge_view_cross(view.right, view.forward, view.up);
+
+    view.tan_half_fovy   = tanf(fovy_degrees * 0.5f * 3.14159265f / 180.f);
+    view.aspect          = aspect;
+    view.near            = 0.01f;
+    view.far             = 1000.f;
+    view.viewport_height = viewport_height;
+    return view;
+}
+
+// Plane i keeps points with dot(normals[i], p) + offsets[i] >= 0. Normals aren't unit length,
+// only the sign of the test is used.
+struct Sponge_Frustum {
+    float normals[6][3];
+    float offsets[6];
+};
+
+struct Sponge_Frustum sponge_frustum_create(const struct Sponge_View *view) {
+    struct Sponge_Frustum frustum = { };
+    float tan_half_fovx = view->tan_half_fovy * view->aspect;
+
+    for (int k = 0; k < 3; ++k) {
+        frustum.normals[0][k] =  view->right[k] + view->forward[k] * tan_half_fovx;
+        frustum.normals[1][k] = -view->right[k] + view->forward[k] * tan_half_fovx;
+        frustum.normals[2][k] =  view->up[k]    + view->forward[k] * view->tan_half_fovy;
+        frustum.normals[3][k] = -view->up[k]    + view->forward[k] * view->tan_half_fovy;
+        frustum.normals[4][k] =  view->forward[k];
+        frustum.normals[5][k] = -view->forward[k];
+    }
+
+    for (int i = 0; i < 6; ++i) frustum.offsets[i] = -sponge_view_dot(frustum.normals[i], view->position);
+    frustum.offsets[4] -= view->near;
+    frustum.offsets[5] += view->far;
+    return frustum;
+}
+
+// Conservative, a box can pass while being just outside near a frustum corner
+bool sponge_frustum_test_box(const struct Sponge_Frustum *frustum, const float min[3], const float max[3]) {
+    for (int i = 0; i < 6; ++i) {
+        // The corner furthest along the plane normal
+        float corner[3];
+        for (int k = 0; k < 3; ++k) corner[k] = frustum->normals[i][k] >= 0 ? max[k] : min[k];
+        if (sponge_view_dot(frustum->normals[i], corner) + frustum->offsets[i] < 0) return false;
+    }
+    return true;
+}
+
+float sponge_view_distance_to_box(const struct Sponge_View *view, const float min[3], const float max[3]) {
+    float distance_squared = 0;
+    for (int k = 0; k < 3; ++k) {
+        float p = view->position[k];
+        float d = p < min[k] ? min[k] - p : (p > max[k] ? p - max[k] : 0);
+        distance_squared += d * d;
+    }
+    return sqrtf(distance_squared);
+}
+
+void sponge_lod_box(int level, struct Vector3_Int position, float min[3], float max[3]) {
+    float w = cube_width(level);
+    int lattice[3] = { position.x, position.y, position.z };
+    for (int k = 0; k < 3; ++k) {
+        min[k] = -MENGER_SIZE / 2.f + (float) lattice[k] * w;
+        max[k] = min[k] + w;
+    }
+}
+
+void sponge_lod_destroy(struct Sponge_Lod *lod) {
+    if (!lod->is_mapped) {
+        for (size_t c = 0; c < lod->chunk_count; ++c) {
+            for (int level = 0; level < SPONGE_LOD_LEVELS; ++level) sponge_mesh_destroy(&lod->chunks[c].meshes[level]);
+        }
+        free(lod->nodes);
+    }
+    free(lod->chunks);
+    free(lod->draws);
+    *lod = { };
+}
+
+struct Sponge_Lod_Build_Job {
+    struct Sponge_Lod *lod;
+    const struct Cube_Occupancy *occupancies;  // Indexed by level
+    std::atomic<size_t> chunks_built;
+    std::atomic<float> *progress;
+};
+
+void sponge_lod_build_chunk(void *user_data, size_t chunk_index) {
+    struct Sponge_Lod_Build_Job *job = (struct Sponge_Lod_Build_Job *) user_data;
+    struct Sponge_Lod *lod = job->lod;
+    struct Sponge_Lod_Chunk *chunk = &lod->chunks[chunk_index];
+
+    for (int level = lod->chunk_level; level <= lod->level; ++level) {
+        int scale = menger_lattice_size(level - lod->chunk_level);
+        int origin[3] = { chunk->position.x * scale, chunk->position.y * scale, chunk->position.z * scale };
+        chunk->meshes[level] = sponge_mesh_build_region(&job->occupancies[level], origin, scale, NULL);
+        chunk->triangle_counts[level] = chunk->meshes[level].triangle_count;
+    }
+
+    size_t built = job->chunks_built.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (job->progress) {
+        // Chunks finish out of order, only ever move the bar forward
+        float done = (float) built / (float) lod->chunk_count;
+        float seen = job->progress->load(std::memory_order_relaxed);
+        while (seen < done && !job->progress->compare_exchange_weak(seen, done, std::memory_order_relaxed)) { }
+    }
+}
+
+// Builds the hierarchy and every chunk's meshes for `cubes`, the chunks in parallel on `pool`
+struct Sponge_Lod sponge_lod_build(const struct Cube_Array *cubes, struct Thread_Pool *pool, std::atomic<float> *progress) {
+    assert(cubes->level <= MENGER_MESH_MAX_LEVEL && "Level too deep to mesh");
+
+    struct Sponge_Lod lod = { };
+    lod.level       = cubes->level;
+    lod.chunk_level = cubes->level > MENGER_CHUNK_DEPTH ? cubes->level - MENGER_CHUNK_DEPTH : 0;
+
+    struct Cube_Occupancy occupancies[SPONGE_LOD_LEVELS] = { };
+    for (int level = 0; level <= lod.level; ++level) occupancies[level] = cube_occupancy_create(cubes, level);
+
+    // At most 27 children per node on the way down to the chunks
+    size_t node_capacity = 0;
+    for (int level = 0, width = 1; level <= lod.chunk_level; ++level, width *= 27) node_capacity += (size_t) width;
+
+    lod.nodes  = (struct Sponge_Lod_Node *)  calloc(node_capacity, sizeof(struct Sponge_Lod_Node));
+    lod.chunks = (struct Sponge_Lod_Chunk *) calloc(menger_cube_count(lod.chunk_level), sizeof(struct Sponge_Lod_Chunk));
+    lod.draws  = (struct Sponge_Lod_Draw *)  calloc(menger_cube_count(lod.chunk_level), sizeof(struct Sponge_Lod_Draw));
+    assert(lod.nodes && lod.chunks && lod.draws && "Failed to allocate sponge LOD");
+
+    // Breadth first, so every node's children are appended together. Positions ride along in
+    // the chunk slot until the leaves get their real chunk index.
+    struct Vector3_Int *positions = (struct Vector3_Int *) calloc(node_capacity, sizeof(struct Vector3_Int));
+    assert(positions && "Failed to allocate sponge LOD");
+
+    lod.node_count = 1;
+    sponge_lod_box(0, { 0, 0, 0 }, lod.nodes[0].min, lod.nodes[0].max);
+
+    size_t level_begin = 0;
+    for (int level = 0; level < lod.chunk_level; ++level) {
+        size_t level_end = lod.node_count;
+        for (size_t n = level_begin; n < level_end; ++n) {
+            lod.nodes[n].first_child = (uint32_t) lod.node_count;
+
+            for (int child = 0; child < 27; ++child) {
+                struct Vector3_Int p = {
+                    positions[n].x * 3 + child % 3,
+                    positions[n].y * 3 + (child / 3) % 3,
+                    positions[n].z * 3 + child / 9,
+                };
+                int cell[3] = { p.x, p.y, p.z };
+                if (!cube_occupancy_test(&occupancies[level + 1], cell)) continue;
+
+                struct Sponge_Lod_Node *node = &lod.nodes[lod.node_count];
+                sponge_lod_box(level + 1, p, node->min, node->max);
+                positions[lod.node_count] = p;
+                lod.node_count += 1;
+                lod.nodes[n].child_count += 1;
+            }
+        }
+        level_begin = level_end;
+    }
+
+    for (size_t n = level_begin; n < lod.node_count; ++n) {
+        struct Sponge_Lod_Chunk *chunk = &lod.chunks[lod.chunk_count];
+        chunk->position = positions[n];
+        sponge_lod_box(lod.chunk_level, chunk->position, chunk->min, chunk->max);
+        lod.nodes[n].chunk = (uint32_t) lod.chunk_count;
+        lod.chunk_count += 1;
+    }
+    free(positions);
+
+    struct Sponge_Lod_Build_Job job = { };
+    job.lod         = &lod;
+    job.occupancies = occupancies;
+    job.progress    = progress;
+    thread_pool_run(pool, lod.chunk_count, &sponge_lod_build_chunk, &job);
+
+    for (size_t c = 0; c < lod.chunk_count; ++c) {
+        lod.triangle_count          += lod.chunks[c].meshes[lod.level].triangle_count;
+        lod.unculled_triangle_count += lod.chunks[c].meshes[lod.level].unculled_triangle_count;
+    }
+
+    for (int level = 0; level <= lod.level; ++level) cube_occupancy_destroy(&occupancies[level]);
+    return lod;
+}
+
+void sponge_lod_select_node(struct Sponge_Lod *lod, const struct Sponge_View *view, const struct Sponge_Frustum *frustum, uint32_t node_index) {
+    const struct Sponge_Lod_Node *node = &lod->nodes[node_index];
+    if (!sponge_frustum_test_box(frustum, node->min, node->max)) {
+        lod->culled_node_count += 1;
+        return;
+    }
+
+    if (node->child_count) {
+        for (uint32_t child = 0; child < node->child_count; ++child) {
+            sponge_lod_select_node(lod, view, frustum, node->first_child + child);
+        }
+        return;
+    }
+
+    const struct Sponge_Lod_Chunk *chunk = &lod->chunks[node->chunk];
+    float distance = sponge_view_distance_to_box(view, chunk->min, chunk->max);
+    if (distance < view->near) distance = view->near;
+    float pixels_per_unit = view->viewport_height / (2.f * view->tan_half_fovy * distance);
+
+    int level = lod->chunk_level;
+    for (int candidate = lod->level; candidate > lod->chunk_level; --candidate) {
+        if (cube_width(candidate) * pixels_per_unit >= MENGER_LOD_MIN_PIXELS) {
+            level = candidate;
+            break;
+        }
+    }
+
+    lod->draws[lod->draw_count++] = (struct Sponge_Lod_Draw) { .chunk = node->chunk, .level = level };
+    lod->drawn_triangle_count += chunk->triangle_counts[level];
+}
+
+// Fills `draws` with the visible chunks and the level to draw each at
+void sponge_lod_select(struct Sponge_Lod *lod, const struct Sponge_View *view) {
+    lod->draw_count           = 0;
+    lod->drawn_triangle_count = 0;
+    lod->culled_node_count    = 0;
+    if (lod->node_count == 0) return;
+
+    struct Sponge_Frustum frustum = sponge_frustum_create(view);
+    sponge_lod_select_node(lod, view, &frustum, 0);
+}
+
+#endif // E_MENGER_SPONGE_LOD_H
@@ -0,0 +1,245 @@
+#pragma once
+#ifndef E_MENGER_SPONGE_MESH_H
+#define E_MENGER_SPONGE_MESH_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/morton.h"
+
+#include "02_menger_sponge_cubes.h"
+
+// Turns a level's cube list into one triangle mesh with only the faces you can see.
+// The cubes are rasterized into an occupancy bitset over the level's lattice, every face between
+// a filled and an empty cell becomes part of a 2D mask per slice, and each mask is greedily
+// merged into as few rectangles as possible.
+// https://0fps.net/2012/06/30/meshing-in-a-minecraft-game/
+//
+// Output is a flat triangle list in the layout raylib's Mesh expects, but nothing here needs raylib.
+// Shading is baked into vertex colors per face direction, so there are no normals to store.
+
+struct Cube_Occupancy {
+    int level;
+    int size;
+    uint64_t *bits;
+};
+
+struct Sponge_Mesh {
+    int level;
+
+    size_t vertex_count;
+    size_t vertex_capacity;
+    float *vertices;        // xyz per vertex
+    unsigned char *colors;  // rgba per vertex
+
+    // Two triangles per emitted rectangle, versus twelve per cube when every cube is drawn whole
+    size_t triangle_count;
+    size_t unculled_triangle_count;
+};
+
+// Level 5 already merges down to ~7M triangles (~330MB of vertices). Level 6 would be 20 times
+// that, and its cubes are smaller than a pixel at the default camera distance anyway.
+const int MENGER_MESH_MAX_LEVEL = 5;
+
+const unsigned char SPONGE_MESH_COLOR[3] = { 230, 41, 55 };
+
+// Baked per-axis shading so faces read apart without a lit shader: x, y, z for + and - sides
+const float SPONGE_MESH_SHADE[3][2] = {
+    { 0.80f, 0.70f },
+    { 1.00f, 0.45f },
+    { 0.90f, 0.60f },
+};
+
+// Occupancy of `level`, which can be coarser than the cubes. A coarse cell is filled when any of
+// its descendants is, which for the sponge is exactly the coarser level's cubes.
+struct Cube_Occupancy cube_occupancy_create(const struct Cube_Array *cubes, int level) {
+    assert(level <= cubes->level && "Occupancy can only be coarser than its cubes");
+
+    struct Cube_Occupancy occupancy = { };
+    occupancy.level = level;
+    occupancy.size  = menger_lattice_size(level);
+    int scale = menger_lattice_size(cubes->level - level);
+
+    size_t cell_count = (size_t) occupancy.size * (size_t) occupancy.size * (size_t) occupancy.size;
+    occupancy.bits = (uint64_t *) calloc((cell_count + 63) / 64, sizeof(uint64_t));
+    assert(occupancy.bits && "Failed to allocate occupancy");
+
+    for (size_t i = 0; i < cubes->count; ++i) {
+        struct Vector3_Int p = morton_decode(cubes->cubes[i]);
+        p = { p.x / scale, p.y / scale, p.z / scale };
+        size_t cell = (size_t) p.x + (size_t) occupancy.size * ((size_t) p.y + (size_t) occupancy.size * (size_t) p.z);
+        occupancy.bits[cell / 64] |= 1ull << (cell % 64);
+    }
+
+    return occupancy;
+}
+
+void cube_occupancy_destroy(struct Cube_Occupancy *occupancy) {
+    free(occupancy->bits);
+    *occupancy = { };
+}
+
+// Out of bounds reads as empty so the outer shell gets faces
+bool cube_occupancy_test(const struct Cube_Occupancy *occupancy, const int position[3]) {
+    for (int axis = 0; axis < 3; ++axis) {
+        if (position[axis] < 0 || position[axis] >= occupancy->size) return false;
+    }
+    size_t cell = (size_t) position[0] + (size_t) occupancy->size * ((size_t) position[1] + (size_t) occupancy->size * (size_t) position[2]);
+    return (occupancy->bits[cell / 64] >> (cell % 64)) & 1;
+}
+
+void sponge_mesh_destroy(struct Sponge_Mesh *mesh) {
+    free(mesh->vertices);
+    free(mesh->colors);
+    *mesh = { };
+}
+
+void sponge_mesh_reserve(struct Sponge_Mesh *mesh, size_t vertex_count) {
+    if (vertex_count <= mesh->vertex_capacity) return;
+
+    size_t capacity = mesh->vertex_capacity ? mesh->vertex_capacity : 1024;
+    while (capacity < vertex_count) capacity *= 2;
+
+    mesh->vertices = (float *)         realloc(mesh->vertices, capacity * 3 * sizeof(float));
+    mesh->colors   = (unsigned char *) realloc(mesh->colors,   capacity * 4 * sizeof(unsigned char));
+    assert(mesh->vertices && mesh->colors && "Failed to allocate mesh");
+
+    mesh->vertex_capacity = capacity;
+}
+
+void sponge_mesh_push_vertex(struct Sponge_Mesh *mesh, const float position[3], float shade) {
+    size_t i = mesh->vertex_count++;
+    memcpy(&mesh->vertices[i * 3], position, 3 * sizeof(float));
+    mesh->colors[i * 4 + 0] = (unsigned char) ((float) SPONGE_MESH_COLOR[0] * shade);
+    mesh->colors[i * 4 + 1] = (unsigned char) ((float) SPONGE_MESH_COLOR[1] * shade);
+    mesh->colors[i * 4 + 2] = (unsigned char) ((float) SPONGE_MESH_COLOR[2] * shade);
+    mesh->colors[i * 4 + 3] = 255;
+}
+
+// Emits the rectangle at lattice `origin` spanning `width` cells along `u` and `height` along `v`,
+// facing +axis when `sign` is positive. Counter-clockwise seen from the side it faces.
+void sponge_mesh_push_quad(struct Sponge_Mesh *mesh, int axis, int sign, const int origin[3], int width, int height) {
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
+
+    float cell = cube_width(mesh->level);
+    float corner[4][3];
+    for (int i = 0; i < 4; ++i) {
+        int lattice[3] = { origin[0], origin[1], origin[2] };
+        if (i == 1 || i == 2) lattice[u] += width;
+        if (i == 2 || i == 3) lattice[v] += height;
+        for (int k = 0; k < 3; ++k) corner[i][k] = -MENGER_SIZE / 2.f + (float) lattice[k] * cell;
+    }
+
+    float shade = SPONGE_MESH_SHADE[axis][sign > 0 ? 0 : 1];
+
+    static const int FRONT[6] = { 0, 1, 2, 0, 2, 3 };
+    static const int BACK[6]  = { 0, 2, 1, 0, 3, 2 };
+    const int *order = sign > 0 ? FRONT : BACK;
+
+    sponge_mesh_reserve(mesh, mesh->vertex_count + 6);
+    for (int i = 0; i < 6; ++i) sponge_mesh_push_vertex(mesh, corner[order[i]], shade);
+    mesh->triangle_count += 2;
+}
+
+// Cells outside the meshed region read as empty, so a region is closed on its own and regions
+// drawn at different levels of detail never leave cracks between them
+bool sponge_mesh_region_test(const struct Cube_Occupancy *occupancy, const int region_origin[3], int region_size, const int position[3]) {
+    for (int axis = 0; axis < 3; ++axis) {
+        if (position[axis] < region_origin[axis] || position[axis] >= region_origin[axis] + region_size) return false;
+    }
+    return cube_occupancy_test(occupancy, position);
+}
+
+// Meshes the cube of `region_size` cells at `region_origin` on the occupancy's lattice.
+// `progress`, when given, is raised from 0 to 1 as slices are meshed so another thread can watch.
+struct Sponge_Mesh sponge_mesh_build_region(const struct Cube_Occupancy *occupancy, const int region_origin[3], int region_size, std::atomic<float> *progress) {
+    struct Sponge_Mesh mesh = { };
+    mesh.level = occupancy->level;
+    int n = region_size;
+
+    // +1 / -1 for a face pointing along / against the axis, 0 for no face
+    int8_t *mask = (int8_t *) calloc((size_t) n * (size_t) n, sizeof(int8_t));
+    assert(mask && "Failed to allocate mesh mask");
+
+    for (int axis = 0; axis < 3; ++axis) {
+        int u = (axis + 1) % 3;
+        int v = (axis + 2) % 3;
+
+        // Slice `plane` is the boundary between cell plane - 1 and cell plane
+        for (int plane = 0; plane <= n; ++plane) {
+            int behind[3], ahead[3];
+            for (int j = 0; j < n; ++j) {
+                for (int i = 0; i < n; ++i) {
+                    behind[axis] = region_origin[axis] + plane - 1;
+                    ahead[axis]  = region_origin[axis] + plane;
+                    behind[u] = ahead[u] = region_origin[u] + i;
+                    behind[v] = ahead[v] = region_origin[v] + j;
+
+                    bool a = sponge_mesh_region_test(occupancy, region_origin, region_size, behind);
+                    bool b = sponge_mesh_region_test(occupancy, region_origin, region_size, ahead);
+                    mask[i + j * n] = (int8_t) (a == b ? 0 : (a ? 1 : -1));
+
+                    // Every cell is `ahead` of exactly one plane per axis
+                    if (axis == 0 && b) mesh.unculled_triangle_count += 12;
+                }
+            }
+
+            // Greedy merge: grow each face along u, then grow that strip along v while it still fits
+            for (int j = 0; j < n; ++j) {
+                for (int i = 0; i < n;) {
+                    int8_t face = mask[i + j * n];
+                    if (face == 0) { ++i; continue; }
+
+                    int width = 1;
+                    while (i + width < n && mask[i + width + j * n] == face) ++width;
+
+                    int height = 1;
+                    for (; j + height < n; ++height) {
+                        bool row_matches = true;
+                        for (int k = 0; k < width; ++k) {
+                            if (mask[i + k + (j + height) * n] != face) { row_matches = false; break; }
+                        }
+                        if (!row_matches) break;
+                    }
+
+                    int origin[3];
+                    origin[axis] = region_origin[axis] + plane;
+                    origin[u]    = region_origin[u] + i;
+                    origin[v]    = region_origin[v] + j;
+                    sponge_mesh_push_quad(&mesh, axis, face, origin, width, height);
+
+                    for (int h = 0; h < height; ++h) {
+                        memset(&mask[i + (j + h) * n], 0, (size_t) width);
+                    }
+                    i += width;
+                }
+            }
+
+            if (progress) {
+                float done = (float) (axis * (n + 1) + plane + 1) / (float) (3 * (n + 1));
+                progress->store(done, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    free(mask);
+    return mesh;
+}
+
+// The whole level as one mesh
+struct Sponge_Mesh sponge_mesh_build(const struct Cube_Array *cubes, std::atomic<float> *progress) {
+    assert(cubes->level <= MENGER_MESH_MAX_LEVEL && "Level too deep to mesh");
+
+    struct Cube_Occupancy occupancy = cube_occupancy_create(cubes, cubes->level);
+    const int origin[3] = { 0, 0, 0 };
+    struct Sponge_Mesh mesh = sponge_mesh_build_region(&occupancy, origin, occupancy.size, progress);
+    cube_occupancy_destroy(&occupancy);
+    return mesh;
+}
+
+#endif // E_MENGER_SPONGE_MESH_H
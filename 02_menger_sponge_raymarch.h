@@ -0,0 +1,458 @@
+#pragma once
+#ifndef E_MENGER_SPONGE_RAYMARCH_H
+#define E_MENGER_SPONGE_RAYMARCH_H
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "common/thread_pool.h"
+
+#include "02_menger_sponge_cubes.h"
+#include "02_menger_sponge_lod.h"
+#include "02_menger_sponge_mesh.h"
+
+// CPU renderer for the sponge that never builds cubes. Rays march the sponge's signed distance
+// function, so the depth is only limited by float precision instead of memory.
+// https://iquilezles.org/articles/menger/
+//
+// The image is cut into tiles that run as thread pool jobs, and each tile marches RAYMARCH_LANES
+// neighbouring pixels of a row together, 8 with AVX and 4 with SSE2. Lanes that finish early
+// idle until the whole packet is done.
+//
+// Hits are flat shaded with the mesher's per-axis colors, and `raymarch_render_cubes` traces the
+// cube lattice directly with the same shading, so the two images can be compared pixel by pixel.
+
+const int   RAYMARCH_TILE_SIZE = 16;
+const int   RAYMARCH_MAX_STEPS = 160;
+const int   RAYMARCH_MAX_DEPTH = 10;  // Past this the lattice is finer than float precision near the surface
+
+struct Raymarch_Image {
+    int width;
+    int height;
+    uint8_t *pixels;  // rgba
+};
+
+struct Raymarch_Image raymarch_image_create(int width, int height) {
+    struct Raymarch_Image image = { };
+    image.width  = width;
+    image.height = height;
+    image.pixels = (uint8_t *) calloc((size_t) width * (size_t) height * 4, 1);
+    assert(image.pixels && "Failed to allocate image");
+    return image;
+}
+
+void raymarch_image_destroy(struct Raymarch_Image *image) {
+    free(image->pixels);
+    *image = { };
+}
+
+bool raymarch_image_write_ppm(const struct Raymarch_Image *image, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+
+    fprintf(file, "P6\n%d %d\n255\n", image->width, image->height);
+    for (size_t i = 0; i < (size_t) image->width * (size_t) image->height; ++i) {
+        fwrite(&image->pixels[i * 4], 1, 3, file);
+    }
+    return fclose(file) == 0;
+}
+
+void raymarch_image_shade(struct Raymarch_Image *image, int x, int y, bool is_hit, int axis, int sign) {
+    uint8_t *pixel = &image->pixels[((size_t) y * (size_t) image->width + (size_t) x) * 4];
+    float shade = is_hit ? SPONGE_MESH_SHADE[axis][sign > 0 ? 0 : 1] : 0;
+    pixel[0] = (uint8_t) ((float) SPONGE_MESH_COLOR[0] * shade);
+    pixel[1] = (uint8_t) ((float) SPONGE_MESH_COLOR[1] * shade);
+    pixel[2] = (uint8_t) ((float) SPONGE_MESH_COLOR[2] * shade);
+    pixel[3] = 255;
+}
+
+// Direction through the center of pixel (x, y), not normalized
+void raymarch_pixel_direction(const struct Sponge_View *view, int width, int height, int x, int y, float direction[3]) {
+    float u = (2.f * ((float) x + 0.5f) / (float) width - 1.f) * view->tan_half_fovy * view->aspect;
+    float v = (1.f - 2.f * ((float) y + 0.5f) / (float) height) * view->tan_half_fovy;
+    for (int k = 0; k < 3; ++k) direction[k] = view->forward[k] + u * view->right[k] + v * view->up[k];
+}
+
+// Where the ray enters and leaves the sponge's bounding box, false when it misses
+bool raymarch_clip_to_sponge(const float origin[3], const float direction[3], float *t_enter, float *t_exit, int *enter_axis) {
+    float half = MENGER_SIZE / 2.f;
+    float t0 = 0, t1 = INFINITY;
+    *enter_axis = 0;
+    for (int k = 0; k < 3; ++k) {
+        float inverse = 1.f / direction[k];
+        float near = (-half - origin[k]) * inverse;
+        float far  = ( half - origin[k]) * inverse;
+        if (near > far) { float swap = near; near = far; far = swap; }
+        if (near > t0) { t0 = near; *enter_axis = k; }
+        if (far < t1) t1 = far;
+    }
+    *t_enter = t0;
+    *t_exit  = t1;
+    return t0 <= t1;
+}
+
+// Distance to the sponge of `depth` levels, in world units. The sponge is scaled to [-1, 1]^3,
+// where every level folds space into a cell and carves the cross out of it.
+float raymarch_menger_distance(float x, float y, float z, int depth) {
+    const float to_unit = 2.f / MENGER_SIZE;
+    float p[3] = { x * to_unit, y * to_unit, z * to_unit };
+
+    float outside = 0, inside = -INFINITY;
+    for (int k = 0; k < 3; ++k) {
+        float q = fabsf(p[k]) - 1.f;
+        outside += q > 0 ? q * q : 0;
+        inside = q > inside ? q : inside;
+    }
+    float distance = sqrtf(outside) + (inside < 0 ? inside : 0);
+
+    float scale = 1;
+    for (int level = 0; level < depth; ++level) {
+        float r[3];
+        for (int k = 0; k < 3; ++k) {
+            float a = p[k] * scale;
+            a = a - 2.f * floorf(a * 0.5f) - 1.f;
+            r[k] = fabsf(1.f - 3.f * fabsf(a));
+        }
+        scale *= 3;
+
+        float da = r[0] > r[1] ? r[0] : r[1];
+        float db = r[1] > r[2] ? r[1] : r[2];
+        float dc = r[2] > r[0] ? r[2] : r[0];
+        float cross = ((da < db ? (da < dc ? da : dc) : (db < dc ? db : dc)) - 1.f) * (1.f / scale);
+        distance = distance > cross ? distance : cross;
+    }
+    return distance * (1.f / to_unit);
+}
+
+// Tetrahedron gradient, 4 taps instead of 6
+// https://iquilezles.org/articles/normalsSDF/
+void raymarch_menger_normal(const float p[3], float h, int depth, float normal[3]) {
+    static const float TAPS[4][3] = { { 1, -1, -1 }, { -1, -1, 1 }, { -1, 1, -1 }, { 1, 1, 1 } };
+    normal[0] = normal[1] = normal[2] = 0;
+    for (int i = 0; i < 4; ++i) {
+        float d = raymarch_menger_distance(p[0] + TAPS[i][0] * h, p[1] + TAPS[i][1] * h, p[2] + TAPS[i][2] * h, depth);
+        for (int k = 0; k < 3; ++k) normal[k] += TAPS[i][k] * d;
+    }
+}
+
+int raymarch_dominant_axis(const float normal[3]) {
+    float x = fabsf(normal[0]), y = fabsf(normal[1]), z = fabsf(normal[2]);
+    return x >= y ? (x >= z ? 0 : 2) : (y >= z ? 1 : 2);
+}
+
+// A hit is anything closer than half a pixel at that distance
+float raymarch_pixel_radius(const struct Sponge_View *view, int height) {
+    return view->tan_half_fovy / (float) height;
+}
+
+// Reference version, one ray at a time
+void raymarch_pixel_scalar(struct Raymarch_Image *image, const struct Sponge_View *view, int depth, int x, int y) {
+    float direction[3];
+    raymarch_pixel_direction(view, image->width, image->height, x, y, direction);
+    sponge_view_normalize(direction);
+
+    float t, t_exit;
+    int enter_axis;
+    if (!raymarch_clip_to_sponge(view->position, direction, &t, &t_exit, &enter_axis)) {
+        raymarch_image_shade(image, x, y, false, 0, 0);
+        return;
+    }
+
+    float pixel_radius = raymarch_pixel_radius(view, image->height);
+    float p[3];
+    bool is_hit = true;
+    for (int step = 0; step < RAYMARCH_MAX_STEPS; ++step) {
+        for (int k = 0; k < 3; ++k) p[k] = view->position[k] + direction[k] * t;
+        float distance = raymarch_menger_distance(p[0], p[1], p[2], depth);
+        if (distance < t * pixel_radius) break;
+
+        t += distance;
+        if (t > t_exit) { is_hit = false; break; }
+    }
+
+    if (!is_hit) {
+        raymarch_image_shade(image, x, y, false, 0, 0);
+        return;
+    }
+
+    float normal[3];
+    raymarch_menger_normal(p, t * pixel_radius, depth, normal);
+    int axis = raymarch_dominant_axis(normal);
+    raymarch_image_shade(image, x, y, true, axis, normal[axis] > 0 ? 1 : -1);
+}
+
+#if defined(__AVX__)
+const int RAYMARCH_LANES = 8;
+typedef __m256 Ray_Float;
+
+Ray_Float ray_set1(float v)                  { return _mm256_set1_ps(v); }
+Ray_Float ray_load(const float *v)           { return _mm256_loadu_ps(v); }
+void      ray_store(float *out, Ray_Float v) { _mm256_storeu_ps(out, v); }
+Ray_Float ray_add(Ray_Float a, Ray_Float b)  { return _mm256_add_ps(a, b); }
+Ray_Float ray_sub(Ray_Float a, Ray_Float b)  { return _mm256_sub_ps(a, b); }
+Ray_Float ray_mul(Ray_Float a, Ray_Float b)  { return _mm256_mul_ps(a, b); }
+Ray_Float ray_min(Ray_Float a, Ray_Float b)  { return _mm256_min_ps(a, b); }
+Ray_Float ray_max(Ray_Float a, Ray_Float b)  { return _mm256_max_ps(a, b); }
+Ray_Float ray_sqrt(Ray_Float v)              { return _mm256_sqrt_ps(v); }
+Ray_Float ray_abs(Ray_Float v)               { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), v); }
+Ray_Float ray_floor(Ray_Float v)             { return _mm256_floor_ps(v); }
+Ray_Float ray_less(Ray_Float a, Ray_Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+Ray_Float ray_and(Ray_Float a, Ray_Float b)     { return _mm256_and_ps(a, b); }
+Ray_Float ray_or(Ray_Float a, Ray_Float b)      { return _mm256_or_ps(a, b); }
+Ray_Float ray_and_not(Ray_Float a, Ray_Float b) { return _mm256_andnot_ps(b, a); }
+Ray_Float ray_select(Ray_Float mask, Ray_Float a, Ray_Float b) { return _mm256_blendv_ps(b, a, mask); }
+int       ray_any(Ray_Float mask)            { return _mm256_movemask_ps(mask); }
+#elif defined(__SSE2__) || defined(_M_X64)
+const int RAYMARCH_LANES = 4;
+typedef __m128 Ray_Float;
+
+Ray_Float ray_set1(float v)                  { return _mm_set1_ps(v); }
+Ray_Float ray_load(const float *v)           { return _mm_loadu_ps(v); }
+void      ray_store(float *out, Ray_Float v) { _mm_storeu_ps(out, v); }
+Ray_Float ray_add(Ray_Float a, Ray_Float b)  { return _mm_add_ps(a, b); }
+Ray_Float ray_sub(Ray_Float a, Ray_Float b)  { return _mm_sub_ps(a, b); }
+Ray_Float ray_mul(Ray_Float a, Ray_Float b)  { return _mm_mul_ps(a, b); }
+Ray_Float ray_min(Ray_Float a, Ray_Float b)  { return _mm_min_ps(a, b); }
+Ray_Float ray_max(Ray_Float a, Ray_Float b)  { return _mm_max_ps(a, b); }
+Ray_Float ray_sqrt(Ray_Float v)              { return _mm_sqrt_ps(v); }
+Ray_Float ray_abs(Ray_Float v)               { return _mm_andnot_ps(_mm_set1_ps(-0.f), v); }
+Ray_Float ray_less(Ray_Float a, Ray_Float b) { return _mm_cmplt_ps(a, b); }
+Ray_Float ray_and(Ray_Float a, Ray_Float b)     { return _mm_and_ps(a, b); }
+Ray_Float ray_or(Ray_Float a, Ray_Float b)      { return _mm_or_ps(a, b); }
+Ray_Float ray_and_not(Ray_Float a, Ray_Float b) { return _mm_andnot_ps(b, a); }
+Ray_Float ray_select(Ray_Float mask, Ray_Float a, Ray_Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+int       ray_any(Ray_Float mask)            { return _mm_movemask_ps(mask); }
+
+// No SSE2 floor, truncate and step down where that rounded up. Inputs stay far inside int range.
+Ray_Float ray_floor(Ray_Float v) {
+    Ray_Float truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+    return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, v), _mm_set1_ps(1.f)));
+}
+#else
+const int RAYMARCH_LANES = 1;
+#endif
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+// `raymarch_menger_distance` for a packet
+Ray_Float raymarch_menger_distance_lanes(Ray_Float x, Ray_Float y, Ray_Float z, int depth) {
+    const Ray_Float to_unit = ray_set1(2.f / MENGER_SIZE);
+    const Ray_Float zero = ray_set1(0), one = ray_set1(1), two = ray_set1(2), three = ray_set1(3), half = ray_set1(0.5f);
+    Ray_Float p[3] = { ray_mul(x, to_unit), ray_mul(y, to_unit), ray_mul(z, to_unit) };
+
+    Ray_Float outside = zero, inside = ray_set1(-INFINITY);
+    for (int k = 0; k < 3; ++k) {
+        Ray_Float q = ray_sub(ray_abs(p[k]), one);
+        Ray_Float clamped = ray_max(q, zero);
+        outside = ray_add(outside, ray_mul(clamped, clamped));
+        inside  = ray_max(inside, q);
+    }
+    Ray_Float distance = ray_add(ray_sqrt(outside), ray_min(inside, zero));
+
+    float scale = 1;
+    for (int level = 0; level < depth; ++level) {
+        Ray_Float vscale = ray_set1(scale);
+        Ray_Float r[3];
+        for (int k = 0; k < 3; ++k) {
+            Ray_Float a = ray_mul(p[k], vscale);
+            a = ray_sub(ray_sub(a, ray_mul(two, ray_floor(ray_mul(a, half)))), one);
+            r[k] = ray_abs(ray_sub(one, ray_mul(three, ray_abs(a))));
+        }
+        scale *= 3;
+
+        Ray_Float da = ray_max(r[0], r[1]);
+        Ray_Float db = ray_max(r[1], r[2]);
+        Ray_Float dc = ray_max(r[2], r[0]);
+        Ray_Float cross = ray_mul(ray_sub(ray_min(da, ray_min(db, dc)), one), ray_set1(1.f / scale));
+        distance = ray_max(distance, cross);
+    }
+    return ray_mul(distance, ray_set1(1.f / (2.f / MENGER_SIZE)));
+}
+
+// Pixels [x, x + RAYMARCH_LANES) of row y
+void raymarch_pixels_lanes(struct Raymarch_Image *image, const struct Sponge_View *view, int depth, int x, int y) {
+    alignas(32) float origin_t[RAYMARCH_LANES], exit_t[RAYMARCH_LANES], alive[RAYMARCH_LANES];
+    alignas(32) float dx[RAYMARCH_LANES], dy[RAYMARCH_LANES], dz[RAYMARCH_LANES];
+
+    for (int lane = 0; lane < RAYMARCH_LANES; ++lane) {
+        float direction[3];
+        raymarch_pixel_direction(view, image->width, image->height, x + lane, y, direction);
+        sponge_view_normalize(direction);
+        dx[lane] = direction[0]; dy[lane] = direction[1]; dz[lane] = direction[2];
+
+        int enter_axis;
+        bool is_inside = raymarch_clip_to_sponge(view->position, direction, &origin_t[lane], &exit_t[lane], &enter_axis);
+        alive[lane] = is_inside ? 1.f : 0.f;
+    }
+
+    const Ray_Float ox = ray_set1(view->position[0]), oy = ray_set1(view->position[1]), oz = ray_set1(view->position[2]);
+    const Ray_Float vdx = ray_load(dx), vdy = ray_load(dy), vdz = ray_load(dz);
+    const Ray_Float t_exit = ray_load(exit_t);
+    const Ray_Float pixel_radius = ray_set1(raymarch_pixel_radius(view, image->height));
+
+    Ray_Float t      = ray_load(origin_t);
+    Ray_Float active = ray_less(ray_set1(0.5f), ray_load(alive));
+    Ray_Float missed = ray_less(ray_load(alive), ray_set1(0.5f));
+
+    for (int step = 0; step < RAYMARCH_MAX_STEPS && ray_any(active); ++step) {
+        Ray_Float distance = raymarch_menger_distance_lanes(
+            ray_add(ox, ray_mul(vdx, t)), ray_add(oy, ray_mul(vdy, t)), ray_add(oz, ray_mul(vdz, t)), depth);
+
+        Ray_Float hit = ray_and(active, ray_less(distance, ray_mul(t, pixel_radius)));
+        active = ray_and_not(active, hit);
+
+        t = ray_select(active, ray_add(t, distance), t);
+        Ray_Float left = ray_and(active, ray_less(t_exit, t));
+        missed = ray_or(missed, left);
+        active = ray_and_not(active, left);
+    }
+
+    // Rays still going after the step budget are grazing a surface and count as hits, same as the scalar path
+    alignas(32) float missed_lanes[RAYMARCH_LANES];
+    alignas(32) float normal[3][RAYMARCH_LANES];
+    ray_store(missed_lanes, missed);
+
+    if (ray_any(missed) != (1 << RAYMARCH_LANES) - 1) {
+        // `raymarch_menger_normal` for the packet
+        static const float TAPS[4][3] = { { 1, -1, -1 }, { -1, -1, 1 }, { -1, 1, -1 }, { 1, 1, 1 } };
+        Ray_Float px = ray_add(ox, ray_mul(vdx, t)), py = ray_add(oy, ray_mul(vdy, t)), pz = ray_add(oz, ray_mul(vdz, t));
+        Ray_Float h  = ray_mul(t, pixel_radius);
+        Ray_Float n[3] = { ray_set1(0), ray_set1(0), ray_set1(0) };
+        for (int i = 0; i < 4; ++i) {
+            Ray_Float d = raymarch_menger_distance_lanes(
+                ray_add(px, ray_mul(h, ray_set1(TAPS[i][0]))),
+                ray_add(py, ray_mul(h, ray_set1(TAPS[i][1]))),
+                ray_add(pz, ray_mul(h, ray_set1(TAPS[i][2]))), depth);
+            for (int k = 0; k < 3; ++k) n[k] = ray_add(n[k], ray_mul(ray_set1(TAPS[i][k]), d));
+        }
+        for (int k = 0; k < 3; ++k) ray_store(normal[k], n[k]);
+    }
+
+    for (int lane = 0; lane < RAYMARCH_LANES; ++lane) {
+        uint32_t missed_bits;
+        memcpy(&missed_bits, &missed_lanes[lane], sizeof(missed_bits));
+        if (missed_bits) {
+            raymarch_image_shade(image, x + lane, y, false, 0, 0);
+            continue;
+        }
+
+        float lane_normal[3] = { normal[0][lane], normal[1][lane], normal[2][lane] };
+        int axis = raymarch_dominant_axis(lane_normal);
+        raymarch_image_shade(image, x + lane, y, true, axis, lane_normal[axis] > 0 ? 1 : -1);
+    }
+}
+#endif
+
+// Reference image from the cube list: walks the lattice cell by cell (Amanatides & Woo) until it
+// finds a filled cell. Exact, so it's what the ray marcher gets checked against.
+void raymarch_pixel_cubes(struct Raymarch_Image *image, const struct Sponge_View *view, const struct Cube_Occupancy *occupancy, int x, int y) {
+    float direction[3];
+    raymarch_pixel_direction(view, image->width, image->height, x, y, direction);
+    sponge_view_normalize(direction);
+
+    float t_enter, t_exit;
+    int axis;
+    if (!raymarch_clip_to_sponge(view->position, direction, &t_enter, &t_exit, &axis)) {
+        raymarch_image_shade(image, x, y, false, 0, 0);
+        return;
+    }
+
+    float cell_width = cube_width(occupancy->level);
+    int cell[3], step[3];
+    float t_next[3], t_delta[3];
+    for (int k = 0; k < 3; ++k) {
+        float entry = (view->position[k] + direction[k] * t_enter + MENGER_SIZE / 2.f) / cell_width;
+        cell[k] = (int) floorf(entry);
+        if (cell[k] < 0) cell[k] = 0;
+        if (cell[k] >= occupancy->size) cell[k] = occupancy->size - 1;
+
+        step[k] = direction[k] >= 0 ? 1 : -1;
+        t_delta[k] = fabsf(cell_width / direction[k]);
+        float boundary = -MENGER_SIZE / 2.f + (float) (cell[k] + (step[k] > 0 ? 1 : 0)) * cell_width;
+        t_next[k] = (boundary - view->position[k]) / direction[k];
+    }
+
+    for (;;) {
+        if (cube_occupancy_test(occupancy, cell)) {
+            raymarch_image_shade(image, x, y, true, axis, -step[axis]);
+            return;
+        }
+
+        axis = t_next[0] < t_next[1] ? (t_next[0] < t_next[2] ? 0 : 2) : (t_next[1] < t_next[2] ? 1 : 2);
+        if (t_next[axis] > t_exit) break;
+        cell[axis]   += step[axis];
+        t_next[axis] += t_delta[axis];
+        if (cell[axis] < 0 || cell[axis] >= occupancy->size) break;
+    }
+    raymarch_image_shade(image, x, y, false, 0, 0);
+}
+
+struct Raymarch_Job {
+    struct Raymarch_Image *image;
+    const struct Sponge_View *view;
+    int depth;
+    int tiles_x;
+
+    const struct Cube_Occupancy *occupancy;  // Traces the cube lattice instead when set
+    bool is_scalar;                          // Forces one ray at a time, for comparison
+};
+
+void raymarch_tile_job(void *user_data, size_t tile) {
+    struct Raymarch_Job *job = (struct Raymarch_Job *) user_data;
+    struct Raymarch_Image *image = job->image;
+
+    int x0 = (int) (tile % (size_t) job->tiles_x) * RAYMARCH_TILE_SIZE;
+    int y0 = (int) (tile / (size_t) job->tiles_x) * RAYMARCH_TILE_SIZE;
+    int x1 = x0 + RAYMARCH_TILE_SIZE < image->width  ? x0 + RAYMARCH_TILE_SIZE : image->width;
+    int y1 = y0 + RAYMARCH_TILE_SIZE < image->height ? y0 + RAYMARCH_TILE_SIZE : image->height;
+
+    for (int y = y0; y < y1; ++y) {
+        int x = x0;
+        if (job->occupancy) {
+            for (; x < x1; ++x) raymarch_pixel_cubes(image, job->view, job->occupancy, x, y);
+            continue;
+        }
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+        if (!job->is_scalar) {
+            for (; x + RAYMARCH_LANES <= x1; x += RAYMARCH_LANES) raymarch_pixels_lanes(image, job->view, job->depth, x, y);
+        }
+#endif
+        for (; x < x1; ++x) raymarch_pixel_scalar(image, job->view, job->depth, x, y);
+    }
+}
+
+void raymarch_run(struct Raymarch_Job *job, struct Thread_Pool *pool) {
+    job->tiles_x = (job->image->width + RAYMARCH_TILE_SIZE - 1) / RAYMARCH_TILE_SIZE;
+    int tiles_y  = (job->image->height + RAYMARCH_TILE_SIZE - 1) / RAYMARCH_TILE_SIZE;
+    thread_pool_run(pool, (size_t) job->tiles_x * (size_t) tiles_y, &raymarch_tile_job, job);
+}
+
+// `view` should have the image's aspect ratio and height
+void raymarch_render(struct Raymarch_Image *image, const struct Sponge_View *view, int depth, struct Thread_Pool *pool) {
+    struct Raymarch_Job job = { };
+    job.image = image;
+    job.view  = view;
+    job.depth = depth;
+    raymarch_run(&job, pool);
+}
+
+void raymarch_render_cubes(struct Raymarch_Image *image, const struct Sponge_View *view, const struct Cube_Occupancy *occupancy, struct Thread_Pool *pool) {
+    struct Raymarch_Job job = { };
+    job.image     = image;
+    job.view      = view;
+    job.occupancy = occupancy;
+    raymarch_run(&job, pool);
+}
+
+#endif // E_MENGER_SPONGE_RAYMARCH_H
@@ -2,16 +2,29 @@
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <mutex>
 #include "raylib.h"
 
 #include "common/common.h"
 #include "common/defer.hpp"
 #include "common/scene.h"
+#include "common/scene_migration.h"
 #include "common/math.h"
+#include "common/random.h"
 
-void *init(void);
+#include "03_snake_simulation.h"
+#include "03_snake_replay.h"
+#include "03_snake_arena.h"
+#include "03_snake_autopilot.h"
+
+void *init(uint64_t seed);
 void  update(void  *scene_data, float delta_time);
 void  destroy(void *scene_data);
+void  tick(void    *scene_data, void *snapshot, float delta_time);
+void  draw(void    *scene_data, const void *previous, const void *current, float alpha);
+void *migrate(void *old_data, const struct Scene_Layout *old_layout);
+void  before_reload(void *scene_data);
+void  after_reload(void  *scene_data);
 
 const Vector2_Int CELL_SIZE  = { .x = 20, .y = 20 };
 const Vector2_Int BOARD_SIZE = { 
@@ -19,10 +32,30 @@ const Vector2_Int BOARD_SIZE = {
     .y = (int) CANVAS_SIZE.y / CELL_SIZE.y
 };
 
-const size_t SNAKE_MAX_LENGTH = BOARD_SIZE.x * BOARD_SIZE.y;
+// Toggled with L. Far bigger than the screen, frames only draw what the camera sees.
+const Vector2_Int LARGE_BOARD_SIZE = { .x = 4096, .y = 4096 };
+
+// Toggled with A. AI snakes only, drawn from a texture with one pixel per cell.
+const Vector2_Int ARENA_SIZE        = { .x = 512, .y = 512 };
+const size_t      ARENA_SNAKE_COUNT = 4096;
+const uint32_t    ARENA_FOOD_COUNT  = 2048;
 
+const float TURN_LENGTH            = 0.0625f;
 const float DEATH_ANIMATION_LENGTH = 2.f;
 
+const float CAMERA_ZOOM_MIN  = 0.01f;
+const float CAMERA_ZOOM_MAX  = 4.f;
+const float CAMERA_ZOOM_STEP = 0.1f;
+
+// Snapshots hold at most this many runs of the body, counted from the head. Only a snake with
+// more turns than this still in its body is drawn cut short.
+const size_t SNAPSHOT_MAX_RUNS = 64 * 1024;
+
+const uint32_t NO_CELL = UINT32_MAX;
+
+// Every turn of the session is recorded and written here when the scene unloads
+const char *REPLAY_PATH = "03_snake_session.replay";
+
 enum Event {
     E_TURN_UP,   E_TURN_DOWN,
     E_TURN_LEFT, E_TURN_RIGHT,
@@ -30,23 +63,68 @@ enum Event {
     E_EVENTS_COUNT,
 };
 
-enum Direction {
-    DIRECTION_UP,   DIRECTION_DOWN,
-    DIRECTION_LEFT, DIRECTION_RIGHT,
+// What an arena cell shows, one byte per cell in snapshots
+enum Arena_Cell {
+    ARENA_CELL_EMPTY,
+    ARENA_CELL_FOOD,
+    ARENA_CELL_BODY,
+    ARENA_CELL_HEAD,
 };
 
-struct Snake_Link {
-    struct Vector2_Int position;
-    struct Vector2_Int position_previous;
+// A straight piece of the body, `length` cells ending at `head` and running back against
+// `direction`. Runs are also cut where the body wraps around the board, so each one is a single
+// rectangle and the body is drawn in as many rectangles as it has turns.
+struct Snake_Run {
+    uint32_t head;
+    uint32_t length;
+    enum Direction direction;
 };
 
+// The body's runs from the head, a ring buffer that doubles when it fills up. Kept in step with
+// the game one move at a time, so it costs the same at any length.
+struct Snake_Runs {
+    struct Snake_Run *runs;
+    size_t first;
+    size_t count;
+    size_t capacity;  // Power of two
+};
+
+// What a frame draws, written by `tick` on the simulation thread. Room for `SNAPSHOT_MAX_RUNS`
+// runs follows it, then one `Arena_Cell` per arena cell, only filled in arena mode.
+struct Snake_Snapshot {
+    uint64_t generation;  // Bumped for every new game, 0 until the first tick
+    bool     is_arena;
+    uint32_t arena_alive;
+    uint64_t arena_deaths;
+    uint64_t turn;        // Turns into the current game, the head only slides when it changed
+    int32_t  board_width;
+    int32_t  board_height;
+    uint32_t length;      // Cells to draw from the head, counting down while dying
+    uint32_t run_count;
+    uint32_t vacated;     // Cell the tail left on the last turn, NO_CELL if it grew instead
+    uint32_t food;
+    size_t   score;
+    size_t   high_score;
+    bool     is_autopilot;
+};
+
+// `update` runs on the main thread and only queues input, the rest is owned by the simulation
+// thread until the host joins it. The camera is only used by `update` and `draw`.
 struct Scene_Data {
     Camera2D camera;
+    bool     camera_follows;  // Framed automatically until dragged, F goes back to it
+    bool     wants_large_board;
+    bool     wants_arena;
 
+    uint64_t seed;
     float turn_timer;
 
+    std::mutex *events_mutex;
     size_t      events_count;
     enum Event *events;
+    bool        board_toggle_queued;
+    bool        arena_toggle_queued;
+    bool        autopilot_toggle_queued;
 
     // @Hack
     bool move_queued;
@@ -54,59 +132,330 @@ struct Scene_Data {
     bool  is_dying;
     float death_animation_timer;
 
-    struct Vector2_Int food_position;
+    // The rules live in `game`, the scene only feeds it input and draws it. While dying the body
+    // is eaten from the tail, so only the first `snake_visible_length` links are drawn.
+    struct Snake_Game game;
+    size_t snake_visible_length;
+    struct Snake_Runs runs;
+    uint32_t vacated;
+
+    // Steers through the same event queue as the keyboard, keys pressed this turn win
+    bool is_autopilot;
+    struct Snake_Autopilot autopilot;
+
+    struct Snake_Replay replay;
+    uint64_t generation;
+
+    // The single game is paused, not reset, while the arena runs
+    bool is_arena;
+    struct Snake_Arena  arena;
+    struct Thread_Pool *pool;
+    Texture2D arena_texture;
+    Color    *arena_pixels;
 
     // @TODO: Save data between runs
     size_t session_max_length;
-    size_t snake_length_max;
-    size_t snake_length;
-    struct Snake_Link *snake_links;
-    enum   Direction   snake_direction;
 };
 
-extern "C" struct Scene_Functions __declspec(dllexport) get_scene_functions(void);
+// Every field of the scene data but the ones owning threads, for hot reloading
+const struct Scene_Field SCENE_DATA_FIELDS[] = {
+    SCENE_FIELD(struct Scene_Data, camera),
+    SCENE_FIELD(struct Scene_Data, camera_follows),
+    SCENE_FIELD(struct Scene_Data, wants_large_board),
+    SCENE_FIELD(struct Scene_Data, wants_arena),
+    SCENE_FIELD(struct Scene_Data, seed),
+    SCENE_FIELD(struct Scene_Data, turn_timer),
+    SCENE_FIELD(struct Scene_Data, events_mutex),
+    SCENE_FIELD(struct Scene_Data, events_count),
+    SCENE_FIELD(struct Scene_Data, events),
+    SCENE_FIELD(struct Scene_Data, board_toggle_queued),
+    SCENE_FIELD(struct Scene_Data, arena_toggle_queued),
+    SCENE_FIELD(struct Scene_Data, autopilot_toggle_queued),
+    SCENE_FIELD(struct Scene_Data, move_queued),
+    SCENE_FIELD(struct Scene_Data, is_dying),
+    SCENE_FIELD(struct Scene_Data, death_animation_timer),
+    SCENE_FIELD(struct Scene_Data, game),
+    SCENE_FIELD(struct Scene_Data, snake_visible_length),
+    SCENE_FIELD(struct Scene_Data, runs),
+    SCENE_FIELD(struct Scene_Data, vacated),
+    SCENE_FIELD(struct Scene_Data, is_autopilot),
+    SCENE_FIELD(struct Scene_Data, autopilot),
+    SCENE_FIELD(struct Scene_Data, replay),
+    SCENE_FIELD(struct Scene_Data, generation),
+    SCENE_FIELD(struct Scene_Data, is_arena),
+    SCENE_FIELD(struct Scene_Data, arena),
+    SCENE_FIELD(struct Scene_Data, arena_texture),
+    SCENE_FIELD(struct Scene_Data, arena_pixels),
+    SCENE_FIELD(struct Scene_Data, session_max_length),
+};
+
+extern "C" struct Scene_Functions SCENE_EXPORT get_scene_functions(void);
 struct Scene_Functions get_scene_functions(void) {
-    return (struct Scene_Functions) {
-        .init    = &init,
-        .update  = &update,
-        .destroy = &destroy,
-    };
+    struct Scene_Functions functions = { };
+    functions.init    = &init;
+    functions.update  = &update;
+    functions.destroy = &destroy;
+
+    functions.tick          = &tick;
+    functions.draw          = &draw;
+    functions.snapshot_size = sizeof(struct Snake_Snapshot) + SNAPSHOT_MAX_RUNS * sizeof(struct Snake_Run) + (size_t) ARENA_SIZE.x * ARENA_SIZE.y;
+    functions.tick_rate     = 1.f / TURN_LENGTH;
+
+    functions.before_reload = &before_reload;
+    functions.after_reload  = &after_reload;
+
+    functions.layout  = SCENE_LAYOUT(struct Scene_Data, 1, SCENE_DATA_FIELDS);
+    functions.migrate = &migrate;
+
+    return functions;
 }
 
-void snake_reset(struct Scene_Data *self) {
-    // @Leak
-    self->snake_links = (struct Snake_Link *) calloc(SNAKE_MAX_LENGTH, sizeof(struct Snake_Link));
-    self->snake_direction = (enum Direction) GetRandomValue(0, 3);
-    self->snake_length = 1;
-    self->snake_length_max = self->snake_length;
-    self->snake_links[0].position = {
-        .x = GetRandomValue(0, BOARD_SIZE.x - 1),
-        .y = GetRandomValue(0, BOARD_SIZE.y - 1)
-    };
+struct Snake_Run *snake_run(struct Snake_Runs *self, size_t i) {
+    return &self->runs[(self->first + i) & (self->capacity - 1)];
 }
 
-void snake_extend(struct Scene_Data *self) {
-    struct Snake_Link *old_link = &self->snake_links[self->snake_length - 1];
-    struct Snake_Link *new_link = &self->snake_links[self->snake_length++];
+void snake_runs_reset(struct Snake_Runs *self, uint32_t head, enum Direction direction) {
+    if (!self->runs) {
+        self->capacity = 64;
+        self->runs = (struct Snake_Run *) calloc(self->capacity, sizeof(struct Snake_Run));
+        assert(self->runs && "Failed to allocate snake runs");
+    }
+    self->first   = 0;
+    self->count   = 1;
+    self->runs[0] = { .head = head, .length = 1, .direction = direction };
+}
+
+void snake_runs_push_head(struct Snake_Runs *self, struct Snake_Run run) {
+    if (self->count == self->capacity) {
+        struct Snake_Run *runs = (struct Snake_Run *) malloc(self->capacity * 2 * sizeof(struct Snake_Run));
+        assert(runs && "Failed to allocate snake runs");
+        for (size_t i = 0; i < self->count; ++i) runs[i] = *snake_run(self, i);
+        free(self->runs);
+        self->runs      = runs;
+        self->first     = 0;
+        self->capacity *= 2;
+    }
+
+    self->first = (self->first - 1) & (self->capacity - 1);
+    self->runs[self->first] = run;
+    self->count += 1;
+}
 
-    new_link->position = old_link->position_previous;
-    self->snake_length_max = self->snake_length;
+void snake_runs_pop_tail(struct Snake_Runs *self) {
+    struct Snake_Run *tail = snake_run(self, self->count - 1);
+    tail->length -= 1;
+    if (tail->length == 0) self->count -= 1;
+}
+
+// Follows one move of the game: the head run grows or a new one starts, and the tail run
+// shrinks unless the snake grew
+void snake_runs_move(struct Scene_Data *self, uint32_t previous_head, uint32_t previous_tail, uint32_t previous_length) {
+    struct Snake_Game *game = &self->game;
+    uint32_t head = snake_game_link(game, 0);
+
+    struct Vector2_Int from = snake_game_position(game, previous_head);
+    struct Vector2_Int to   = snake_game_position(game, head);
+    bool wrapped = abs(to.x - from.x) + abs(to.y - from.y) != 1;
+
+    struct Snake_Run *first = snake_run(&self->runs, 0);
+    if (!wrapped && first->direction == game->direction) {
+        first->head    = head;
+        first->length += 1;
+    } else {
+        snake_runs_push_head(&self->runs, { .head = head, .length = 1, .direction = game->direction });
+    }
 
-    if (self->snake_length_max > self->session_max_length) {
-        self->session_max_length = self->snake_length_max;
+    self->vacated = NO_CELL;
+    if (game->length == previous_length) {
+        self->vacated = previous_tail;
+        snake_runs_pop_tail(&self->runs);
     }
 }
 
-void snake_draw(struct Scene_Data *self) {
-    for (size_t i = 0; i < self->snake_length; ++i) {
-        DrawRectangle(
-            self->snake_links[i].position.x * CELL_SIZE.x,
-            self->snake_links[i].position.y * CELL_SIZE.y,
-            CELL_SIZE.x,
-            CELL_SIZE.y,
-            WHITE
-        );
+void snake_start_game(struct Scene_Data *self) {
+    self->snake_visible_length = self->game.length;
+    self->vacated = NO_CELL;
+    self->generation += 1;
+    snake_runs_reset(&self->runs, snake_game_link(&self->game, 0), self->game.direction);
+}
+
+// A fresh game and replay on the other board size
+void snake_toggle_board(struct Scene_Data *self) {
+    Vector2_Int size = self->game.width == BOARD_SIZE.x && self->game.height == BOARD_SIZE.y ? LARGE_BOARD_SIZE : BOARD_SIZE;
+
+    snake_game_destroy(&self->game);
+    snake_replay_destroy(&self->replay);
+    snake_autopilot_destroy(&self->autopilot);
+    self->game      = snake_game_create(size.x, size.y, self->seed, 0);
+    self->replay    = snake_replay_create(self->seed, 0, size.x, size.y);
+    self->autopilot = snake_autopilot_create(size.x, size.y);
+
+    self->is_dying = false;
+    self->death_animation_timer = 0;
+    self->turn_timer = 0;
+    snake_start_game(self);
+}
+
+// The arena is built fresh every time it is entered and dropped on the way out
+void snake_toggle_arena(struct Scene_Data *self) {
+    if (self->is_arena) {
+        snake_arena_destroy(&self->arena);
+    } else {
+        self->arena = snake_arena_create(ARENA_SNAKE_COUNT, ARENA_SIZE.x, ARENA_SIZE.y, ARENA_FOOD_COUNT, self->seed + self->generation);
     }
+    self->is_arena   = !self->is_arena;
+    self->turn_timer = 0;
+    self->generation += 1;
+}
+
+struct Snake_Run *snake_snapshot_runs(struct Snake_Snapshot *snapshot) {
+    return (struct Snake_Run *) (snapshot + 1);
+}
+
+const struct Snake_Run *snake_snapshot_runs(const struct Snake_Snapshot *snapshot) {
+    return (const struct Snake_Run *) (snapshot + 1);
+}
+
+uint8_t *snake_snapshot_arena_cells(struct Snake_Snapshot *snapshot) {
+    return (uint8_t *) (snake_snapshot_runs(snapshot) + SNAPSHOT_MAX_RUNS);
+}
+
+const uint8_t *snake_snapshot_arena_cells(const struct Snake_Snapshot *snapshot) {
+    return (const uint8_t *) (snake_snapshot_runs(snapshot) + SNAPSHOT_MAX_RUNS);
+}
+
+void snake_snapshot_write(struct Scene_Data *self, struct Snake_Snapshot *snapshot) {
+    snapshot->generation   = self->generation;
+    snapshot->is_arena     = false;
+    snapshot->turn         = self->game.turn;
+    snapshot->board_width  = self->game.width;
+    snapshot->board_height = self->game.height;
+    snapshot->length       = (uint32_t) self->snake_visible_length;
+    snapshot->run_count    = (uint32_t) (self->runs.count < SNAPSHOT_MAX_RUNS ? self->runs.count : SNAPSHOT_MAX_RUNS);
+    snapshot->vacated      = self->vacated;
+    snapshot->food         = self->game.food;
+    snapshot->score        = self->snake_visible_length;
+    snapshot->high_score   = self->session_max_length;
+    snapshot->is_autopilot = self->is_autopilot;
+
+    struct Snake_Run *runs = snake_snapshot_runs(snapshot);
+    for (uint32_t i = 0; i < snapshot->run_count; ++i) runs[i] = *snake_run(&self->runs, i);
+}
+
+void arena_snapshot_write(struct Scene_Data *self, struct Snake_Snapshot *snapshot) {
+    struct Snake_Arena *arena = &self->arena;
+    snapshot->generation   = self->generation;
+    snapshot->is_arena     = true;
+    snapshot->arena_alive  = arena->alive_count;
+    snapshot->arena_deaths = arena->death_count;
+    snapshot->board_width  = arena->width;
+    snapshot->board_height = arena->height;
+
+    uint8_t *cells = snake_snapshot_arena_cells(snapshot);
+    for (uint32_t cell = 0; cell < arena->cell_count; ++cell) {
+        uint32_t value = arena->cells[cell];
+        cells[cell] = value == SNAKE_ARENA_EMPTY ? ARENA_CELL_EMPTY : (value == SNAKE_ARENA_FOOD ? ARENA_CELL_FOOD : ARENA_CELL_BODY);
+    }
+    for (size_t i = 0; i < arena->snake_count; ++i) {
+        if (arena->snakes[i].is_alive) cells[snake_arena_link(arena, i, 0)] = ARENA_CELL_HEAD;
+    }
+}
+
+// Arena frames show the newest tick as it is, thousands of snakes sliding wouldn't read any better
+void arena_draw(struct Scene_Data *self, const struct Snake_Snapshot *current) {
+    const uint8_t *cells = snake_snapshot_arena_cells(current);
+    const Color colors[] = { BLACK, RED, LIGHTGRAY, WHITE };
+    size_t cell_count = (size_t) current->board_width * (size_t) current->board_height;
+    for (size_t cell = 0; cell < cell_count; ++cell) self->arena_pixels[cell] = colors[cells[cell]];
+    UpdateTexture(self->arena_texture, self->arena_pixels);
+
+    Rectangle source      = { 0, 0, (float) current->board_width, (float) current->board_height };
+    Rectangle destination = { 0, 0, (float) (current->board_width * CELL_SIZE.x), (float) (current->board_height * CELL_SIZE.y) };
+    DrawTexturePro(self->arena_texture, source, destination, { 0, 0 }, 0, WHITE);
+}
+
+// World space rectangle the camera sees
+Rectangle camera_view(Camera2D camera) {
+    return {
+        .x      = camera.target.x - camera.offset.x / camera.zoom,
+        .y      = camera.target.y - camera.offset.y / camera.zoom,
+        .width  = CANVAS_SIZE.x / camera.zoom,
+        .height = CANVAS_SIZE.y / camera.zoom,
+    };
+}
+
+// Cells [x, x + width) by [y, y + height), fractions allowed, unless the camera can't see them
+void draw_cells(Rectangle view, float x, float y, float width, float height, Color color) {
+    Rectangle rectangle = {
+        .x      = x * (float) CELL_SIZE.x,
+        .y      = y * (float) CELL_SIZE.y,
+        .width  = width  * (float) CELL_SIZE.x,
+        .height = height * (float) CELL_SIZE.y,
+    };
+    if (rectangle.x > view.x + view.width  || rectangle.x + rectangle.width  < view.x) return;
+    if (rectangle.y > view.y + view.height || rectangle.y + rectangle.height < view.y) return;
+    DrawRectangleRec(rectangle, color);
+}
+
+struct Vector2_Int direction_step(enum Direction direction) {
+    switch (direction) {
+    case DIRECTION_UP:    return { .x =  0, .y = -1 };
+    case DIRECTION_DOWN:  return { .x =  0, .y =  1 };
+    case DIRECTION_LEFT:  return { .x = -1, .y =  0 };
+    case DIRECTION_RIGHT: return { .x =  1, .y =  0 };
+    }
+    return { };
+}
+
+struct Vector2_Int snapshot_position(const struct Snake_Snapshot *snapshot, uint32_t cell) {
+    return { .x = (int) (cell % (uint32_t) snapshot->board_width), .y = (int) (cell / (uint32_t) snapshot->board_width) };
+}
+
+// One rectangle per run in view. When the snake moved between the two snapshots, the head run
+// is pulled back and the cell the tail left is still partly covered, so the body slides from one
+// turn to the next instead of jumping.
+void snake_draw(Rectangle view, const struct Snake_Snapshot *previous, const struct Snake_Snapshot *current, float alpha) {
+    bool moved = previous->generation == current->generation && previous->turn != current->turn;
+    float head_cut = moved ? 1.f - alpha : 0.f;
+
+    const struct Snake_Run *runs = snake_snapshot_runs(current);
+    uint32_t remaining = current->length;
+    struct Vector2_Int tail = { };
+
+    for (uint32_t i = 0; i < current->run_count && remaining > 0; ++i) {
+        uint32_t length = runs[i].length < remaining ? runs[i].length : remaining;
+        remaining -= length;
+
+        struct Vector2_Int head = snapshot_position(current, runs[i].head);
+        struct Vector2_Int step = direction_step(runs[i].direction);
+        tail = { .x = head.x - step.x * (int) (length - 1), .y = head.y - step.y * (int) (length - 1) };
+
+        float x = (float) (head.x < tail.x ? head.x : tail.x);
+        float y = (float) (head.y < tail.y ? head.y : tail.y);
+        float width  = (float) (abs(head.x - tail.x) + 1);
+        float height = (float) (abs(head.y - tail.y) + 1);
+
+        if (i == 0) {
+            if (step.x < 0) x += head_cut;
+            if (step.y < 0) y += head_cut;
+            if (step.x != 0) width  -= head_cut;
+            if (step.y != 0) height -= head_cut;
+        }
+        draw_cells(view, x, y, width, height, WHITE);
+    }
+
+    bool is_whole = remaining == 0 && current->length > 0;
+    if (!moved || !is_whole || current->vacated == NO_CELL) return;
+
+    // The tail only ever leaves into the cell next to it, unless it wrapped around the board
+    struct Vector2_Int vacated = snapshot_position(current, current->vacated);
+    int dx = tail.x - vacated.x;
+    int dy = tail.y - vacated.y;
+    if (abs(dx) + abs(dy) != 1) return;
+
+    float x = (float) vacated.x + (dx > 0 ? alpha : 0.f);
+    float y = (float) vacated.y + (dy > 0 ? alpha : 0.f);
+    draw_cells(view, x, y, dx != 0 ? 1.f - alpha : 1.f, dy != 0 ? 1.f - alpha : 1.f, WHITE);
 }
 
 void enqueue_event(struct Scene_Data *self, enum Event event) {
@@ -124,6 +473,7 @@ void enqueue_event(struct Scene_Data *self, enum Event event) {
     fprintf(stderr, "Enqueue: %s (%d)\n", event_name, event);
     */
 
+    std::lock_guard<std::mutex> lock(*self->events_mutex);
     if (self->move_queued) return;
 
     self->events[self->events_count++] = event;
@@ -137,91 +487,132 @@ void enqueue_event(struct Scene_Data *self, enum Event event) {
 
 }
 
+// Hands the queued input to the game as this turn's action
 void end_turn(struct Scene_Data *self) {
+    enum Snake_Action action = SNAKE_ACTION_NONE;
+    uint32_t extend_count = 0;
 
-    self->snake_links[0].position_previous = self->snake_links[0].position;
-
-    switch (self->snake_direction) {
-    case DIRECTION_UP:    { self->snake_links[0].position.y -= 1; } break;
-    case DIRECTION_DOWN:  { self->snake_links[0].position.y += 1; } break;
-    case DIRECTION_LEFT:  { self->snake_links[0].position.x -= 1; } break;
-    case DIRECTION_RIGHT: { self->snake_links[0].position.x += 1; } break;
-    }
-
-    // @HACK: This is using BOARD_SIZE.x/y - 1 and x/y == BOARD_SIZE.x/y because of an off-by-one error somewhere else
-    if (self->snake_links[0].position.x < 0) self->snake_links[0].position.x = BOARD_SIZE.x - 1;
-    if (self->snake_links[0].position.y < 0) self->snake_links[0].position.y = BOARD_SIZE.y - 1;
-    if (self->snake_links[0].position.x == BOARD_SIZE.x) self->snake_links[0].position.x = 0;
-    if (self->snake_links[0].position.y == BOARD_SIZE.y) self->snake_links[0].position.y = 0;
-
+    std::unique_lock<std::mutex> lock(*self->events_mutex);
     for (size_t i = 0; i < self->events_count; ++i) {
         switch (self->events[i]) {
-        case E_EXTEND: { snake_extend(self); } break;
-
-        case E_TURN_UP: {
-            if (self->snake_direction == DIRECTION_DOWN) break;
-            self->snake_direction = DIRECTION_UP;
-        } break;
-
-        case E_TURN_DOWN: {
-            if (self->snake_direction == DIRECTION_UP) break;
-            self->snake_direction = DIRECTION_DOWN;
-        } break;
-
-        case E_TURN_LEFT: {
-            if (self->snake_direction == DIRECTION_RIGHT) break;
-            self->snake_direction = DIRECTION_LEFT;
-        } break;
-
-        case E_TURN_RIGHT: {
-            if (self->snake_direction == DIRECTION_LEFT) break;
-            self->snake_direction = DIRECTION_RIGHT;
-        } break;
+        case E_EXTEND:     { extend_count += 1;              } break;
+        case E_TURN_UP:    { action = SNAKE_ACTION_UP;       } break;
+        case E_TURN_DOWN:  { action = SNAKE_ACTION_DOWN;     } break;
+        case E_TURN_LEFT:  { action = SNAKE_ACTION_LEFT;     } break;
+        case E_TURN_RIGHT: { action = SNAKE_ACTION_RIGHT;    } break;
+        case E_EVENTS_COUNT: break;
         }
     }
 
     self->events_count = 0;
     self->move_queued = false;
+    lock.unlock();
 
-    struct Snake_Link head = self->snake_links[0];
-    struct Snake_Link previous_link = head;
-    for (size_t i = 1; i < self->snake_length; ++i) {
-        self->snake_links[i].position_previous = self->snake_links[i].position;
-        self->snake_links[i].position = previous_link.position_previous;
-        
-        if ((head.position.x == self->snake_links[i].position.x) &&
-            (head.position.y == self->snake_links[i].position.y)) {
-            
-            self->is_dying = true;
-            return;
-        }
+    snake_replay_record_turn(&self->replay, action, extend_count);
+    for (uint32_t i = 0; i < extend_count; ++i) snake_game_extend(&self->game);
+
+    uint32_t previous_head   = snake_game_link(&self->game, 0);
+    uint32_t previous_tail   = snake_game_link(&self->game, self->game.length - 1);
+    uint32_t previous_length = self->game.length;
 
-        previous_link = self->snake_links[i];
+    uint32_t flags = snake_step(&self->game, action);
+    self->snake_visible_length = self->game.length;
+
+    if (self->game.length > self->session_max_length) {
+        self->session_max_length = self->game.length;
+    }
+    if (flags & SNAKE_STEP_DIED) {
+        self->is_dying = true;
+        self->vacated  = NO_CELL;
+    } else {
+        snake_runs_move(self, previous_head, previous_tail, previous_length);
     }
 }
 
-void *init(void) {
-    struct Scene_Data *self = (struct Scene_Data *) malloc(sizeof(struct Scene_Data));
-    memset(self, 0, sizeof(struct Scene_Data));
+// Makes whatever the scene is still missing, on a zeroed scene that is all of it. Hot reloads
+// that changed the layout come through here too, with every field that still fit copied over.
+// The game, its replay, the autopilot and the runs go together, when one of them is missing the
+// game starts over.
+void snake_create_missing(struct Scene_Data *self) {
+    if (!self->events_mutex) self->events_mutex = new std::mutex();
 
-    {
+    if (self->camera.zoom == 0) {
         self->camera = { };
-        self->camera.target = { .x = -(float) CELL_SIZE.x * 2, .y = -(float) CELL_SIZE.y * 2 };
         self->camera.zoom = 0.9;
+        self->camera_follows = true;
     }
 
     // @CleanUp: MAX_EVENTS
     // @Leak
-    self->events = (enum Event *) calloc(24, sizeof(enum Event));
+    if (!self->events) {
+        self->events = (enum Event *) calloc(24, sizeof(enum Event));
+        self->events_count = 0;
+    }
 
-    snake_reset(self);
+    if (!self->game.width || !self->replay.width || !self->autopilot.width || !self->runs.runs) {
+        snake_game_destroy(&self->game);
+        snake_replay_destroy(&self->replay);
+        snake_autopilot_destroy(&self->autopilot);
+        self->game      = snake_game_create(BOARD_SIZE.x, BOARD_SIZE.y, self->seed, 0);
+        self->replay    = snake_replay_create(self->seed, 0, BOARD_SIZE.x, BOARD_SIZE.y);
+        self->autopilot = snake_autopilot_create(BOARD_SIZE.x, BOARD_SIZE.y);
+
+        self->is_dying = false;
+        self->death_animation_timer = 0;
+        self->turn_timer = 0;
+        snake_start_game(self);
+        if (self->session_max_length < self->game.length) self->session_max_length = self->game.length;
+    }
 
-    // @CleanUp: food_reset
-    // @Specificity: It shouldnt be possible to spawn food on a cell that there is currently a snake link
-    self->food_position = {
-        .x = GetRandomValue(0, BOARD_SIZE.x - 1),
-        .y = GetRandomValue(0, BOARD_SIZE.y - 1)
-    };
+    if (!self->pool) self->pool = thread_pool_create(thread_pool_default_thread_count());
+    if (self->is_arena && !self->arena.width) self->is_arena = false;
+
+    if (!self->arena_pixels || !self->arena_texture.id) {
+        if (self->arena_texture.id) UnloadTexture(self->arena_texture);
+        free(self->arena_pixels);
+        self->arena_pixels = (Color *) calloc((size_t) ARENA_SIZE.x * ARENA_SIZE.y, sizeof(Color));
+
+        Image image = { };
+        image.data    = self->arena_pixels;
+        image.width   = ARENA_SIZE.x;
+        image.height  = ARENA_SIZE.y;
+        image.mipmaps = 1;
+        image.format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+        self->arena_texture = LoadTextureFromImage(image);
+    }
+}
+
+void *init(uint64_t seed) {
+    struct Scene_Data *self = (struct Scene_Data *) malloc(sizeof(struct Scene_Data));
+    memset(self, 0, sizeof(struct Scene_Data));
+
+    self->seed = seed;
+    snake_create_missing(self);
+
+    return (void *) self;
+}
+
+// The pool's workers run this library's code, so a reload ends them and the new library starts
+// its own
+void before_reload(void *scene_data) {
+    struct Scene_Data *self = (struct Scene_Data *) scene_data;
+    thread_pool_destroy(self->pool);
+    self->pool = NULL;
+}
+
+void after_reload(void *scene_data) {
+    snake_create_missing((struct Scene_Data *) scene_data);
+}
+
+// The pool isn't in the layout, `before_reload` ended the old one and `snake_create_missing`
+// starts a new one from this library
+void *migrate(void *old_data, const struct Scene_Layout *old_layout) {
+    struct Scene_Data *self = (struct Scene_Data *) calloc(1, sizeof(struct Scene_Data));
+    struct Scene_Layout layout = get_scene_functions().layout;
+
+    scene_migrate_fields(self, &layout, old_data, old_layout);
+    free(old_data);
+    snake_create_missing(self);
 
     return (void *) self;
 }
@@ -229,6 +620,9 @@ void *init(void) {
 void update(void *scene_data, float delta_time) {
     struct Scene_Data *self = (struct Scene_Data *) scene_data;
 
+    // Only input is handled here, time goes by in `tick`
+    (void) delta_time;
+
     if (IsKeyPressed(KEY_E))     enqueue_event(self, E_EXTEND);
 
     if (IsKeyPressed(KEY_UP))    enqueue_event(self, E_TURN_UP);
@@ -236,75 +630,205 @@ void update(void *scene_data, float delta_time) {
     if (IsKeyPressed(KEY_LEFT))  enqueue_event(self, E_TURN_LEFT);
     if (IsKeyPressed(KEY_RIGHT)) enqueue_event(self, E_TURN_RIGHT);
 
-    BeginMode2D(self->camera);
-        ClearBackground(DARKGRAY);
-        DrawRectangle(0, 0, BOARD_SIZE.x * CELL_SIZE.x, BOARD_SIZE.y * CELL_SIZE.y, BLACK);
-
-        // @TODO: Seperate UI camera
-        const char *score_text = TextFormat("Score: %zu", self->snake_length);
-        DrawText(score_text, -30, -30, 25, WHITE);
-
-        const char *high_score_text = TextFormat("High Score: %zu", self->session_max_length);
-        DrawText(high_score_text, 100, -30, 25, WHITE);
-
-        snake_draw(self);
+    if (IsKeyPressed(KEY_P)) {
+        std::lock_guard<std::mutex> lock(*self->events_mutex);
+        self->autopilot_toggle_queued = !self->autopilot_toggle_queued;
+    }
+    if (IsKeyPressed(KEY_L) && !self->wants_arena) {
+        std::lock_guard<std::mutex> lock(*self->events_mutex);
+        self->board_toggle_queued = true;
+        self->wants_large_board   = !self->wants_large_board;
+        self->camera.zoom    = self->wants_large_board ? 1.f : 0.9f;
+        self->camera_follows = true;
+    }
+    if (IsKeyPressed(KEY_A)) {
+        std::lock_guard<std::mutex> lock(*self->events_mutex);
+        self->arena_toggle_queued = !self->arena_toggle_queued;
+        self->wants_arena         = !self->wants_arena;
+        self->camera_follows      = true;
+        if (self->wants_arena) {
+            float fit_x = CANVAS_SIZE.x / (float) (ARENA_SIZE.x * CELL_SIZE.x);
+            float fit_y = CANVAS_SIZE.y / (float) (ARENA_SIZE.y * CELL_SIZE.y);
+            self->camera.zoom = fit_x < fit_y ? fit_x : fit_y;
+        } else {
+            self->camera.zoom = self->wants_large_board ? 1.f : 0.9f;
+        }
+    }
 
-        DrawRectangle(
-            self->food_position.x * CELL_SIZE.x,
-            self->food_position.y * CELL_SIZE.y,
-            CELL_SIZE.x,
-            CELL_SIZE.y,
-            RED
-        );
-    EndMode2D();
+    // Zooms about the middle of the screen, dragging with the right button pans and stops following
+    float wheel = GetMouseWheelMove();
+    if (wheel != 0) {
+        self->camera.zoom *= 1.f + CAMERA_ZOOM_STEP * wheel;
+        if (self->camera.zoom < CAMERA_ZOOM_MIN) self->camera.zoom = CAMERA_ZOOM_MIN;
+        if (self->camera.zoom > CAMERA_ZOOM_MAX) self->camera.zoom = CAMERA_ZOOM_MAX;
+    }
+    if (IsMouseButtonDown(MOUSE_BUTTON_RIGHT)) {
+        Vector2 delta = GetMouseDelta();
+        if (delta.x != 0 || delta.y != 0) {
+            self->camera.target.x -= delta.x / self->camera.zoom;
+            self->camera.target.y -= delta.y / self->camera.zoom;
+            self->camera_follows = false;
+        }
+    }
+    if (IsKeyPressed(KEY_F)) self->camera_follows = true;
+}
 
-    // @CleanUp: vector2_equal
-    if ((self->snake_links[0].position.x == self->food_position.x) &&
-        (self->snake_links[0].position.y == self->food_position.y)) {
+void tick(void *scene_data, void *snapshot, float delta_time) {
+    struct Scene_Data *self = (struct Scene_Data *) scene_data;
 
-        enqueue_event(self, E_EXTEND);
+    bool toggle_board = false;
+    bool toggle_arena = false;
+    {
+        std::lock_guard<std::mutex> lock(*self->events_mutex);
+        toggle_board = self->board_toggle_queued;
+        toggle_arena = self->arena_toggle_queued;
+        if (self->autopilot_toggle_queued) self->is_autopilot = !self->is_autopilot;
+        self->board_toggle_queued     = false;
+        self->arena_toggle_queued     = false;
+        self->autopilot_toggle_queued = false;
+    }
+    if (toggle_board) snake_toggle_board(self);
+    if (toggle_arena) snake_toggle_arena(self);
 
-        // @CleanUp: food_reset
-        // @Specificity: It shouldnt be possible to spawn food on a cell that there is currently a snake link
-        self->food_position = {
-            .x = GetRandomValue(0, BOARD_SIZE.x - 1),
-            .y = GetRandomValue(0, BOARD_SIZE.y - 1)
-        };
+    if (self->is_arena) {
+        self->turn_timer += delta_time;
+        if (self->turn_timer >= TURN_LENGTH) {
+            self->turn_timer -= TURN_LENGTH;
+            snake_arena_step(&self->arena, self->pool);
+        }
+        arena_snapshot_write(self, (struct Snake_Snapshot *) snapshot);
+        return;
     }
 
     if (self->is_dying) {
-
-        size_t kill_link_count = floor(
-            remap(0.f, DEATH_ANIMATION_LENGTH, 0.f, (float) self->snake_length_max, self->death_animation_timer)
+        size_t kill_link_count = floorf(
+            remap(0.f, DEATH_ANIMATION_LENGTH, 0.f, (float) self->game.length, self->death_animation_timer)
         );
-        fprintf(stderr, "kill_link_count: %zu\n", kill_link_count);
-
 
         if (self->death_animation_timer < DEATH_ANIMATION_LENGTH) {
-            self->snake_length = self->snake_length_max - kill_link_count;
+            self->snake_visible_length = self->game.length - kill_link_count;
 
             self->death_animation_timer += delta_time;
-            fprintf(stderr, "death_animation_timer: %.2f\n", self->death_animation_timer);
-
         } else {
             self->is_dying = false;
             self->death_animation_timer = 0;
-            snake_reset(self);
+            snake_game_reset(&self->game);
+            snake_start_game(self);
         }
 
     } else {
-        if (self->turn_timer >= 0.0625f) {
+        // Fixed steps, so turns come exactly every TURN_LENGTH at any tick rate
+        self->turn_timer += delta_time;
+        if (self->turn_timer >= TURN_LENGTH) {
+            self->turn_timer -= TURN_LENGTH;
+
+            if (self->is_autopilot) {
+                enum Snake_Action action = snake_autopilot_decide(&self->autopilot, &self->game);
+                if (action != SNAKE_ACTION_NONE) enqueue_event(self, (enum Event) (E_TURN_UP + (action - SNAKE_ACTION_UP)));
+            }
             end_turn(self);
-            self->turn_timer = 0;
         }
+    }
 
-        self->turn_timer += delta_time;
+    snake_snapshot_write(self, (struct Snake_Snapshot *) snapshot);
+}
+
+// Small boards are framed whole like they always were, large ones keep the head in the middle
+void camera_follow(struct Scene_Data *self, const struct Snake_Snapshot *previous, const struct Snake_Snapshot *current, float alpha) {
+    if (current->is_arena) {
+        self->camera.target = {
+            .x = (float) (current->board_width  * CELL_SIZE.x) / 2,
+            .y = (float) (current->board_height * CELL_SIZE.y) / 2,
+        };
+        self->camera.offset = { .x = CANVAS_SIZE.x / 2, .y = CANVAS_SIZE.y / 2 };
+        return;
     }
+
+    bool is_large = current->board_width != BOARD_SIZE.x || current->board_height != BOARD_SIZE.y;
+    if (!is_large) {
+        self->camera.target = { .x = -(float) CELL_SIZE.x * 2, .y = -(float) CELL_SIZE.y * 2 };
+        self->camera.offset = { };
+        return;
+    }
+
+    struct Vector2_Int head = snapshot_position(current, snake_snapshot_runs(current)[0].head);
+    Vector2 position = { .x = (float) head.x, .y = (float) head.y };
+
+    // Slides along with the head, unless it just wrapped around the board
+    bool moved = previous->generation == current->generation && previous->turn != current->turn && previous->run_count > 0;
+    if (moved) {
+        struct Vector2_Int from = snapshot_position(previous, snake_snapshot_runs(previous)[0].head);
+        if (abs(head.x - from.x) + abs(head.y - from.y) == 1) {
+            position.x = lerp((float) from.x, (float) head.x, alpha);
+            position.y = lerp((float) from.y, (float) head.y, alpha);
+        }
+    }
+
+    self->camera.target = {
+        .x = (position.x + 0.5f) * (float) CELL_SIZE.x,
+        .y = (position.y + 0.5f) * (float) CELL_SIZE.y,
+    };
+    self->camera.offset = { .x = CANVAS_SIZE.x / 2, .y = CANVAS_SIZE.y / 2 };
+}
+
+void draw(void *scene_data, const void *previous_data, const void *current_data, float alpha) {
+    struct Scene_Data *self = (struct Scene_Data *) scene_data;
+    const struct Snake_Snapshot *previous = (const struct Snake_Snapshot *) previous_data;
+    const struct Snake_Snapshot *current  = (const struct Snake_Snapshot *) current_data;
+
+    if (current->generation != 0 && self->camera_follows) camera_follow(self, previous, current, alpha);
+    Rectangle view = camera_view(self->camera);
+
+    if (current->is_arena) {
+        BeginMode2D(self->camera);
+            ClearBackground(DARKGRAY);
+            arena_draw(self, current);
+        EndMode2D();
+
+        const char *arena_text = TextFormat("Snakes: %u  Deaths: %llu", current->arena_alive, (unsigned long long) current->arena_deaths);
+        DrawText(arena_text, 10, 10, 25, WHITE);
+        return;
+    }
+
+    BeginMode2D(self->camera);
+        ClearBackground(DARKGRAY);
+        draw_cells(view, 0, 0, (float) current->board_width, (float) current->board_height, BLACK);
+
+        // @TODO: Seperate UI camera
+        const char *score_text = TextFormat("Score: %zu", current->score);
+        DrawText(score_text, -30, -30, 25, WHITE);
+
+        const char *high_score_text = TextFormat("High Score: %zu", current->high_score);
+        DrawText(high_score_text, 100, -30, 25, WHITE);
+
+        if (current->is_autopilot) DrawText("Autopilot", 330, -30, 25, WHITE);
+
+        if (current->generation != 0) {
+            snake_draw(view, previous, current, alpha);
+
+            if (current->food != SNAKE_NO_FOOD) {
+                struct Vector2_Int food = snapshot_position(current, current->food);
+                draw_cells(view, (float) food.x, (float) food.y, 1, 1, RED);
+            }
+        }
+    EndMode2D();
 }
 
 void destroy(void *scene_data) {
     struct Scene_Data *self = (struct Scene_Data *) scene_data;
     DEFER(fprintf(stderr, "Unloaded scene\n"));
     DEFER(free(self));
-}
 
+    if (!snake_replay_save(&self->replay, REPLAY_PATH)) {
+        fprintf(stderr, "Failed to write replay %s\n", REPLAY_PATH);
+    }
+    snake_replay_destroy(&self->replay);
+    snake_game_destroy(&self->game);
+    snake_autopilot_destroy(&self->autopilot);
+    free(self->runs.runs);
+    if (self->is_arena) snake_arena_destroy(&self->arena);
+    thread_pool_destroy(self->pool);
+    UnloadTexture(self->arena_texture);
+    free(self->arena_pixels);
+    delete self->events_mutex;
+}
@@ -0,0 +1,296 @@
+#pragma once
+#ifndef E_SNAKE_ARENA_H
+#define E_SNAKE_ARENA_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/random.h"
+#include "common/thread_pool.h"
+#include "03_snake_simulation.h"
+
+// Many AI snakes sharing one wrapping board, for 03_snake's arena mode. One grid holds what is
+// in every cell, so a snake hitting any other snake is a single lookup no matter how many there
+// are.
+//
+// A tick has two phases. Every snake first picks its move from the grid as it was at the end of
+// the last tick, which only reads shared state and runs on all cores. The moves are then applied
+// on one thread in snake order: every tail that moves leaves its cell, then heads claim their
+// cells, so the lower numbered snake wins a head-on meeting. The AI's random picks come from
+// each snake's own stream and everything else from the arena's, so a seed plays the same arena
+// on any number of threads.
+
+// What a grid cell holds besides a snake, which is stored as its index + 1
+const uint32_t SNAKE_ARENA_EMPTY = 0;
+const uint32_t SNAKE_ARENA_FOOD  = UINT32_MAX;
+
+// Bodies are ring buffers of this many cells, food eaten at this length is only counted
+const uint32_t SNAKE_ARENA_MAX_LENGTH = 64;
+
+// Links a snake grows into right after spawning
+const uint32_t SNAKE_ARENA_SPAWN_GROWTH = 3;
+
+// Random cells tried per spawn or food before giving up until the next tick
+const int SNAKE_ARENA_PLACE_TRIES = 16;
+
+// Snakes per job when picking moves
+const size_t SNAKE_ARENA_CHUNK_SIZE = 1024;
+
+struct Snake_Arena_Snake {
+    struct Random random;
+
+    bool is_alive;
+    enum Direction direction;
+
+    // The body runs from slot `head` of the snake's ring to the tail, like `Snake_Game`
+    uint32_t head;
+    uint32_t length;
+    uint32_t growth;
+
+    // Picked by the AI, applied by the commit
+    enum Direction next_direction;
+    uint32_t       next_cell;
+};
+
+struct Snake_Arena {
+    int      width;
+    int      height;
+    uint32_t cell_count;
+    uint32_t *cells;
+
+    size_t snake_count;
+    struct Snake_Arena_Snake *snakes;
+    uint32_t *rings;  // Snake i's ring is `SNAKE_ARENA_MAX_LENGTH` cells at i * SNAKE_ARENA_MAX_LENGTH
+
+    struct Random random;
+    uint32_t food_target;
+    uint32_t food_count;
+
+    uint64_t tick;
+    uint64_t death_count;
+    uint64_t food_eaten;
+    uint32_t alive_count;
+};
+
+uint32_t snake_arena_neighbor(const struct Snake_Arena *arena, uint32_t cell, enum Direction direction) {
+    uint32_t width = (uint32_t) arena->width;
+    uint32_t x = cell % width;
+    uint32_t y = cell / width;
+    switch (direction) {
+    case DIRECTION_UP:    { y = (y == 0 ? (uint32_t) arena->height : y) - 1; } break;
+    case DIRECTION_DOWN:  { y = (y + 1 == (uint32_t) arena->height ? 0 : y + 1); } break;
+    case DIRECTION_LEFT:  { x = (x == 0 ? width : x) - 1; } break;
+    case DIRECTION_RIGHT: { x = (x + 1 == width ? 0 : x + 1); } break;
+    }
+    return x + y * width;
+}
+
+bool snake_arena_is_snake(uint32_t value) {
+    return value != SNAKE_ARENA_EMPTY && value != SNAKE_ARENA_FOOD;
+}
+
+// Cell of link `i` of snake `snake`, counted from the head
+uint32_t snake_arena_link(const struct Snake_Arena *arena, size_t snake, uint32_t i) {
+    const struct Snake_Arena_Snake *self = &arena->snakes[snake];
+    return arena->rings[snake * SNAKE_ARENA_MAX_LENGTH + (self->head + i) % SNAKE_ARENA_MAX_LENGTH];
+}
+
+// Puts a dead snake back on an empty cell, it stays dead if none turned up
+void snake_arena_spawn(struct Snake_Arena *arena, size_t snake) {
+    struct Snake_Arena_Snake *self = &arena->snakes[snake];
+    for (int i = 0; i < SNAKE_ARENA_PLACE_TRIES; ++i) {
+        uint32_t cell = random_bounded(&arena->random, arena->cell_count);
+        if (arena->cells[cell] != SNAKE_ARENA_EMPTY) continue;
+
+        self->is_alive  = true;
+        self->direction = (enum Direction) random_bounded(&arena->random, 4);
+        self->head      = 0;
+        self->length    = 1;
+        self->growth    = SNAKE_ARENA_SPAWN_GROWTH;
+        arena->rings[snake * SNAKE_ARENA_MAX_LENGTH] = cell;
+        arena->cells[cell] = (uint32_t) snake + 1;
+        arena->alive_count += 1;
+        return;
+    }
+}
+
+// Tops the food back up to `food_target`
+void snake_arena_place_food(struct Snake_Arena *arena) {
+    int misses = 0;
+    while (arena->food_count < arena->food_target && misses < SNAKE_ARENA_PLACE_TRIES) {
+        uint32_t cell = random_bounded(&arena->random, arena->cell_count);
+        if (arena->cells[cell] != SNAKE_ARENA_EMPTY) {
+            misses += 1;
+            continue;
+        }
+        arena->cells[cell] = SNAKE_ARENA_FOOD;
+        arena->food_count += 1;
+    }
+}
+
+struct Snake_Arena snake_arena_create(size_t snake_count, int width, int height, uint32_t food_target, uint64_t seed) {
+    assert(width > 0 && height > 0 && (uint64_t) width * (uint64_t) height < UINT32_MAX && "Arena size out of range");
+    assert(snake_count < UINT32_MAX - 1 && "Too many snakes");
+
+    struct Snake_Arena arena = { };
+    arena.width       = width;
+    arena.height      = height;
+    arena.cell_count  = (uint32_t) width * (uint32_t) height;
+    arena.cells       = (uint32_t *) calloc(arena.cell_count, sizeof(uint32_t));
+    arena.snake_count = snake_count;
+    arena.snakes      = (struct Snake_Arena_Snake *) calloc(snake_count, sizeof(struct Snake_Arena_Snake));
+    arena.rings       = (uint32_t *) calloc(snake_count * SNAKE_ARENA_MAX_LENGTH, sizeof(uint32_t));
+    assert(arena.cells && arena.snakes && arena.rings && "Failed to allocate snake arena");
+
+    // Snake streams are 0 to snake_count - 1, the arena's own comes after them
+    arena.random      = random_create(seed, snake_count);
+    arena.food_target = food_target;
+
+    for (size_t i = 0; i < snake_count; ++i) {
+        arena.snakes[i].random = random_create(seed, i);
+        snake_arena_spawn(&arena, i);
+    }
+    snake_arena_place_food(&arena);
+    return arena;
+}
+
+void snake_arena_destroy(struct Snake_Arena *arena) {
+    free(arena->cells);
+    free(arena->snakes);
+    free(arena->rings);
+    *arena = { };
+}
+
+// How good moving into `cell` looks: never into a snake, food is worth a lot and so is room to
+// keep going
+int snake_arena_score(const struct Snake_Arena *arena, uint32_t cell, enum Direction direction) {
+    uint32_t value = arena->cells[cell];
+    if (snake_arena_is_snake(value)) return -1000;
+
+    int score = value == SNAKE_ARENA_FOOD ? 100 : 0;
+    for (int d = 0; d < 4; ++d) {
+        if (!snake_arena_is_snake(arena->cells[snake_arena_neighbor(arena, cell, (enum Direction) d)])) score += 10;
+    }
+
+    // Food a couple of cells further on pulls the snake along
+    uint32_t ahead = snake_arena_neighbor(arena, cell, direction);
+    if (arena->cells[ahead] == SNAKE_ARENA_FOOD) score += 30;
+    ahead = snake_arena_neighbor(arena, ahead, direction);
+    if (arena->cells[ahead] == SNAKE_ARENA_FOOD) score += 15;
+    return score;
+}
+
+// Picks moves for snakes [begin, end), only reads the grid
+void snake_arena_think_range(struct Snake_Arena *arena, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        struct Snake_Arena_Snake *self = &arena->snakes[i];
+        if (!self->is_alive) continue;
+
+        uint32_t head = snake_arena_link(arena, i, 0);
+        uint32_t jitter = random_u32(&self->random);
+
+        // Straight on, then the two sides, turning back into the body isn't a move
+        enum Direction side = self->direction <= DIRECTION_DOWN ? DIRECTION_LEFT : DIRECTION_UP;
+        enum Direction options[3] = { self->direction, side, (enum Direction) (side ^ 1) };
+
+        int best_score = INT32_MIN;
+        for (int k = 0; k < 3; ++k) {
+            uint32_t cell = snake_arena_neighbor(arena, head, options[k]);
+            int score = snake_arena_score(arena, cell, options[k]) + (k == 0 ? 3 : 0) + (int) ((jitter >> (k * 3)) & 7);
+            if (score > best_score) {
+                best_score = score;
+                self->next_direction = options[k];
+                self->next_cell      = cell;
+            }
+        }
+    }
+}
+
+// Applies every picked move, see the top of the file for the order
+void snake_arena_commit(struct Snake_Arena *arena) {
+    for (size_t i = 0; i < arena->snake_count; ++i) {
+        struct Snake_Arena_Snake *self = &arena->snakes[i];
+        if (!self->is_alive) continue;
+        if (self->growth > 0 && self->length < SNAKE_ARENA_MAX_LENGTH) continue;
+
+        self->growth = 0;
+        arena->cells[snake_arena_link(arena, i, self->length - 1)] = SNAKE_ARENA_EMPTY;
+    }
+
+    // Killed snakes keep their bodies until every head has moved, so no one slips into them
+    // on the tick they die
+    for (size_t i = 0; i < arena->snake_count; ++i) {
+        struct Snake_Arena_Snake *self = &arena->snakes[i];
+        if (!self->is_alive) continue;
+
+        uint32_t value = arena->cells[self->next_cell];
+        if (snake_arena_is_snake(value)) {
+            self->is_alive = false;
+            continue;
+        }
+
+        self->direction = self->next_direction;
+        self->head = (self->head == 0 ? SNAKE_ARENA_MAX_LENGTH : self->head) - 1;
+        arena->rings[i * SNAKE_ARENA_MAX_LENGTH + self->head] = self->next_cell;
+        arena->cells[self->next_cell] = (uint32_t) i + 1;
+
+        if (self->growth > 0) {
+            self->growth -= 1;
+            self->length += 1;
+        }
+        if (value == SNAKE_ARENA_FOOD) {
+            self->growth += 1;
+            arena->food_count -= 1;
+            arena->food_eaten += 1;
+        }
+    }
+
+    for (size_t i = 0; i < arena->snake_count; ++i) {
+        struct Snake_Arena_Snake *self = &arena->snakes[i];
+        if (self->is_alive || self->length == 0) continue;
+
+        // Its tail may already be the head of whoever moved in behind it
+        for (uint32_t k = 0; k < self->length; ++k) {
+            uint32_t cell = snake_arena_link(arena, i, k);
+            if (arena->cells[cell] == (uint32_t) i + 1) arena->cells[cell] = SNAKE_ARENA_EMPTY;
+        }
+        self->length = 0;
+        arena->alive_count -= 1;
+        arena->death_count += 1;
+    }
+
+    for (size_t i = 0; i < arena->snake_count; ++i) {
+        if (!arena->snakes[i].is_alive) snake_arena_spawn(arena, i);
+    }
+    snake_arena_place_food(arena);
+    arena->tick += 1;
+}
+
+struct Snake_Arena_Job {
+    struct Snake_Arena *arena;
+};
+
+void snake_arena_think_job(void *user_data, size_t chunk) {
+    struct Snake_Arena_Job *job = (struct Snake_Arena_Job *) user_data;
+    size_t begin = chunk * SNAKE_ARENA_CHUNK_SIZE;
+    size_t end   = begin + SNAKE_ARENA_CHUNK_SIZE < job->arena->snake_count ? begin + SNAKE_ARENA_CHUNK_SIZE : job->arena->snake_count;
+    snake_arena_think_range(job->arena, begin, end);
+}
+
+// One tick of every snake, moves are picked on `pool` when there is one
+void snake_arena_step(struct Snake_Arena *arena, struct Thread_Pool *pool) {
+    if (pool) {
+        struct Snake_Arena_Job job = { };
+        job.arena = arena;
+        size_t chunk_count = (arena->snake_count + SNAKE_ARENA_CHUNK_SIZE - 1) / SNAKE_ARENA_CHUNK_SIZE;
+        thread_pool_run(pool, chunk_count, &snake_arena_think_job, &job);
+    } else {
+        snake_arena_think_range(arena, 0, arena->snake_count);
+    }
+    snake_arena_commit(arena);
+}
+
+#endif // E_SNAKE_ARENA_H
@@ -0,0 +1,394 @@
+#pragma once
+#ifndef E_SNAKE_AUTOPILOT_H
+#define E_SNAKE_AUTOPILOT_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "03_snake_simulation.h"
+
+// Picks turns for a `Snake_Game`, raylib free like the rules.
+//
+// The way to the food comes from an A* search over the game's occupancy bitboard. A path stays
+// good until the food moves or the snake leaves it, since the only cells that fill up are the
+// ones the head moves into, so there is one search per food and the turns in between are
+// lookups.
+//
+// What keeps the snake from trapping itself is a Hamiltonian cycle through every cell. While the
+// body lies along the cycle in order, moving to the next cell on the cycle is always safe, and so
+// is any shortcut that lands between the head and the tail in cycle order with some room to
+// spare. Steps off the path that break that are replaced by the furthest safe shortcut that
+// doesn't overshoot the food. A snake that starts with one link stays in order, one that was
+// steered by hand first may not be, and then the autopilot only avoids what is right in front.
+//
+// The board needs an even width or height for the cycle. On odd by odd boards the autopilot
+// only follows paths and avoids walls of snake.
+//
+// Search memory is allocated up front: a hash of visited cells, a binary heap for the open set
+// and the path itself, all sized by the expansion budget and not by the board. Cells hash to
+// themselves, so a search stays in the few rows around it in memory, and boards smaller than
+// the hash get a plain array.
+
+// Cells expanded per search before giving up on the food until it moves
+const uint32_t SNAKE_AUTOPILOT_MAX_EXPANSIONS = 1 << 16;
+
+// Extra free cells kept between the head and the tail when shortcutting
+const uint32_t SNAKE_AUTOPILOT_SHORTCUT_MARGIN = 3;
+
+const uint8_t SNAKE_AUTOPILOT_NO_DIRECTION = 4;
+
+struct Snake_Autopilot_Node {
+    uint32_t stamp;  // Node is only in the current search if this is the search's stamp
+    uint32_t cell;
+    uint32_t g;
+    uint8_t  direction;  // Direction moved to get here
+    bool     is_closed;
+};
+
+struct Snake_Autopilot_Open {
+    uint32_t f;
+    uint32_t g;
+    uint32_t node;
+};
+
+struct Snake_Autopilot {
+    int      width;
+    int      height;
+    uint32_t cell_count;
+
+    bool has_cycle;
+    bool cycle_by_rows;
+
+    uint32_t max_expansions;
+    uint32_t node_mask;  // Node capacity - 1, a power of two
+    uint32_t stamp;
+    struct Snake_Autopilot_Node *nodes;
+
+    uint32_t open_count;
+    uint32_t open_capacity;
+    struct Snake_Autopilot_Open *open;
+
+    // Directions from the food back to `path_head`, the next step is the last one
+    uint8_t *path;
+    uint32_t path_count;
+    uint32_t path_head;
+    uint32_t path_food;
+
+    // Food the last search failed on or whose path had to be dropped, not searched for again
+    uint32_t given_up_food;
+
+    uint64_t search_count;
+    uint64_t expansion_count;
+};
+
+struct Snake_Autopilot snake_autopilot_create(int width, int height) {
+    struct Snake_Autopilot autopilot = { };
+    autopilot.width         = width;
+    autopilot.height        = height;
+    autopilot.cell_count    = (uint32_t) width * (uint32_t) height;
+    autopilot.cycle_by_rows = height % 2 == 0;
+    autopilot.has_cycle     = height % 2 == 0 || width % 2 == 0;
+
+    autopilot.max_expansions = autopilot.cell_count < SNAKE_AUTOPILOT_MAX_EXPANSIONS ? autopilot.cell_count : SNAKE_AUTOPILOT_MAX_EXPANSIONS;
+
+    // Every expansion adds at most three new cells, the hash stays at most half full
+    uint32_t node_capacity = 1;
+    while (node_capacity < 2 * (3 * autopilot.max_expansions + 1)) node_capacity *= 2;
+    autopilot.node_mask     = node_capacity - 1;
+    autopilot.nodes         = (struct Snake_Autopilot_Node *) calloc(node_capacity, sizeof(struct Snake_Autopilot_Node));
+    autopilot.open_capacity = 4 * autopilot.max_expansions + 1;
+    autopilot.open          = (struct Snake_Autopilot_Open *) calloc(autopilot.open_capacity, sizeof(struct Snake_Autopilot_Open));
+    autopilot.path          = (uint8_t *) calloc(autopilot.max_expansions + 1, sizeof(uint8_t));
+    assert(autopilot.nodes && autopilot.open && autopilot.path && "Failed to allocate autopilot");
+
+    autopilot.path_food     = SNAKE_NO_FOOD;
+    autopilot.given_up_food = SNAKE_NO_FOOD;
+    return autopilot;
+}
+
+void snake_autopilot_destroy(struct Snake_Autopilot *autopilot) {
+    free(autopilot->nodes);
+    free(autopilot->open);
+    free(autopilot->path);
+    *autopilot = { };
+}
+
+uint32_t snake_autopilot_neighbor(const struct Snake_Autopilot *autopilot, uint32_t cell, uint32_t direction) {
+    uint32_t width = (uint32_t) autopilot->width;
+    uint32_t x = cell % width;
+    uint32_t y = cell / width;
+    switch (direction) {
+    case DIRECTION_UP:    { y = (y == 0 ? (uint32_t) autopilot->height : y) - 1; } break;
+    case DIRECTION_DOWN:  { y = (y + 1 == (uint32_t) autopilot->height ? 0 : y + 1); } break;
+    case DIRECTION_LEFT:  { x = (x == 0 ? width : x) - 1; } break;
+    case DIRECTION_RIGHT: { x = (x + 1 == width ? 0 : x + 1); } break;
+    }
+    return x + y * width;
+}
+
+// Steps between two cells on the wrapping board
+uint32_t snake_autopilot_distance(const struct Snake_Autopilot *autopilot, uint32_t a, uint32_t b) {
+    uint32_t width = (uint32_t) autopilot->width;
+    uint32_t dx = a % width > b % width ? a % width - b % width : b % width - a % width;
+    uint32_t dy = a / width > b / width ? a / width - b / width : b / width - a / width;
+    if (dx > width - dx) dx = width - dx;
+    if (dy > (uint32_t) autopilot->height - dy) dy = (uint32_t) autopilot->height - dy;
+    return dx + dy;
+}
+
+// Where `cell` is on the cycle, which runs back and forth along rows or columns and closes by
+// wrapping from the last one back to the first
+uint32_t snake_autopilot_cycle_index(const struct Snake_Autopilot *autopilot, uint32_t cell) {
+    uint32_t width  = (uint32_t) autopilot->width;
+    uint32_t height = (uint32_t) autopilot->height;
+    uint32_t x = cell % width;
+    uint32_t y = cell / width;
+    if (autopilot->cycle_by_rows) return y * width  + (y % 2 == 0 ? x : width  - 1 - x);
+    else                          return x * height + (x % 2 == 0 ? y : height - 1 - y);
+}
+
+// Steps forward along the cycle from `a` to `b`
+uint32_t snake_autopilot_cycle_distance(const struct Snake_Autopilot *autopilot, uint32_t a, uint32_t b) {
+    uint32_t from = snake_autopilot_cycle_index(autopilot, a);
+    uint32_t to   = snake_autopilot_cycle_index(autopilot, b);
+    return to >= from ? to - from : to + autopilot->cell_count - from;
+}
+
+// The head can move into `cell` this turn. The tail's cell counts as free when it moves away.
+bool snake_autopilot_is_free(const struct Snake_Game *game, uint32_t cell) {
+    if (!board_is_occupied(&game->occupancy, cell)) return true;
+    bool tail_moves = game->growth == 0 || game->length == game->cell_count;
+    return game->length > 2 && tail_moves && cell == snake_game_link(game, game->length - 1);
+}
+
+// Moving into `cell` keeps the body in cycle order with room to grow
+bool snake_autopilot_is_safe(const struct Snake_Autopilot *autopilot, const struct Snake_Game *game, uint32_t cell) {
+    if (!autopilot->has_cycle) return true;
+
+    uint32_t head = snake_game_link(game, 0);
+    uint32_t step = snake_autopilot_cycle_distance(autopilot, head, cell);
+    if (step == 1) return true;
+
+    // Past half the board there is too little room to get back in order after a shortcut
+    if (game->length + game->growth > autopilot->cell_count / 2) return false;
+
+    uint32_t room = game->length == 1 ? autopilot->cell_count : snake_autopilot_cycle_distance(autopilot, head, snake_game_link(game, game->length - 1));
+    return step + game->growth + SNAKE_AUTOPILOT_SHORTCUT_MARGIN < room;
+}
+
+struct Snake_Autopilot_Node *snake_autopilot_node(struct Snake_Autopilot *autopilot, uint32_t cell, bool *is_new) {
+    uint32_t slot = cell & autopilot->node_mask;
+    for (;;) {
+        struct Snake_Autopilot_Node *node = &autopilot->nodes[slot];
+        if (node->stamp != autopilot->stamp) {
+            node->stamp     = autopilot->stamp;
+            node->cell      = cell;
+            node->g         = UINT32_MAX;
+            node->direction = SNAKE_AUTOPILOT_NO_DIRECTION;
+            node->is_closed = false;
+            *is_new = true;
+            return node;
+        }
+        if (node->cell == cell) {
+            *is_new = false;
+            return node;
+        }
+        slot = (slot + 1) & autopilot->node_mask;
+    }
+}
+
+// Lowest f first, ties go to the node furthest along so open ground is crossed in a line
+bool snake_autopilot_open_less(struct Snake_Autopilot_Open a, struct Snake_Autopilot_Open b) {
+    return a.f < b.f || (a.f == b.f && a.g > b.g);
+}
+
+void snake_autopilot_open_push(struct Snake_Autopilot *autopilot, struct Snake_Autopilot_Open entry) {
+    struct Snake_Autopilot_Open *open = autopilot->open;
+    uint32_t i = autopilot->open_count++;
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!snake_autopilot_open_less(entry, open[parent])) break;
+        open[i] = open[parent];
+        i = parent;
+    }
+    open[i] = entry;
+}
+
+struct Snake_Autopilot_Open snake_autopilot_open_pop(struct Snake_Autopilot *autopilot) {
+    struct Snake_Autopilot_Open *open = autopilot->open;
+    struct Snake_Autopilot_Open top  = open[0];
+    struct Snake_Autopilot_Open last = open[--autopilot->open_count];
+
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t child = 2 * i + 1;
+        if (child >= autopilot->open_count) break;
+        if (child + 1 < autopilot->open_count && snake_autopilot_open_less(open[child + 1], open[child])) child += 1;
+        if (!snake_autopilot_open_less(open[child], last)) break;
+        open[i] = open[child];
+        i = child;
+    }
+    open[i] = last;
+    return top;
+}
+
+// A* from the head to the food, fills `path` and returns whether one was found in budget
+bool snake_autopilot_search(struct Snake_Autopilot *autopilot, const struct Snake_Game *game) {
+    autopilot->path_count = 0;
+    autopilot->open_count = 0;
+    autopilot->search_count += 1;
+
+    autopilot->stamp += 1;
+    if (autopilot->stamp == 0) {
+        memset(autopilot->nodes, 0, ((size_t) autopilot->node_mask + 1) * sizeof(struct Snake_Autopilot_Node));
+        autopilot->stamp = 1;
+    }
+
+    uint32_t width  = (uint32_t) autopilot->width;
+    uint32_t height = (uint32_t) autopilot->height;
+    uint32_t head   = snake_game_link(game, 0);
+    uint32_t goal   = game->food;
+    uint32_t goal_x = goal % width;
+    uint32_t goal_y = goal / width;
+
+    bool is_new = false;
+    struct Snake_Autopilot_Node *start = snake_autopilot_node(autopilot, head, &is_new);
+    start->g = 0;
+    snake_autopilot_open_push(autopilot, { .f = snake_autopilot_distance(autopilot, head, goal), .g = 0, .node = (uint32_t) (start - autopilot->nodes) });
+
+    uint32_t expansions = 0;
+    while (autopilot->open_count > 0 && expansions < autopilot->max_expansions) {
+        struct Snake_Autopilot_Open entry = snake_autopilot_open_pop(autopilot);
+        struct Snake_Autopilot_Node *node = &autopilot->nodes[entry.node];
+        if (node->is_closed || entry.g != node->g) continue;
+        node->is_closed = true;
+        expansions += 1;
+
+        if (node->cell == goal) {
+            // Walks back to the head, the directions come out in reverse which is the order
+            // they are used in
+            uint32_t cell = goal;
+            while (cell != head) {
+                struct Snake_Autopilot_Node *at = snake_autopilot_node(autopilot, cell, &is_new);
+                autopilot->path[autopilot->path_count++] = at->direction;
+                cell = snake_autopilot_neighbor(autopilot, cell, at->direction ^ 1u);
+            }
+            autopilot->path_head = head;
+            autopilot->path_food = goal;
+            autopilot->expansion_count += expansions;
+            return true;
+        }
+
+        // Neighbors and distances in coordinates, the cell is only divided out once
+        uint32_t x = node->cell % width;
+        uint32_t y = node->cell / width;
+        for (uint32_t direction = 0; direction < 4; ++direction) {
+            // Turning straight back isn't a move, even when there is no neck in the way
+            if (node->cell == head && direction == ((uint32_t) game->direction ^ 1u)) continue;
+
+            uint32_t nx = x, ny = y;
+            switch (direction) {
+            case DIRECTION_UP:    { ny = (y == 0 ? height : y) - 1; } break;
+            case DIRECTION_DOWN:  { ny = (y + 1 == height ? 0 : y + 1); } break;
+            case DIRECTION_LEFT:  { nx = (x == 0 ? width : x) - 1; } break;
+            case DIRECTION_RIGHT: { nx = (x + 1 == width ? 0 : x + 1); } break;
+            }
+            uint32_t next = nx + ny * width;
+            if (board_is_occupied(&game->occupancy, next)) continue;
+            if (autopilot->open_count == autopilot->open_capacity) break;
+
+            struct Snake_Autopilot_Node *neighbor = snake_autopilot_node(autopilot, next, &is_new);
+            uint32_t g = node->g + 1;
+            if (g >= neighbor->g) continue;
+
+            uint32_t dx = nx > goal_x ? nx - goal_x : goal_x - nx;
+            uint32_t dy = ny > goal_y ? ny - goal_y : goal_y - ny;
+            if (dx > width  - dx) dx = width  - dx;
+            if (dy > height - dy) dy = height - dy;
+
+            neighbor->g         = g;
+            neighbor->direction = (uint8_t) direction;
+            snake_autopilot_open_push(autopilot, { .f = g + dx + dy, .g = g, .node = (uint32_t) (neighbor - autopilot->nodes) });
+        }
+    }
+
+    autopilot->expansion_count += expansions;
+    return false;
+}
+
+// The safe move that gets furthest along the cycle without passing the food
+enum Direction snake_autopilot_shortcut(const struct Snake_Autopilot *autopilot, const struct Snake_Game *game) {
+    uint32_t head = snake_game_link(game, 0);
+    uint32_t reverse = (uint32_t) game->direction ^ 1u;
+
+    uint32_t best_direction = SNAKE_AUTOPILOT_NO_DIRECTION;
+    uint32_t best_score     = 0;
+    uint32_t any_direction  = SNAKE_AUTOPILOT_NO_DIRECTION;
+
+    for (uint32_t direction = 0; direction < 4; ++direction) {
+        if (direction == reverse) continue;
+        uint32_t next = snake_autopilot_neighbor(autopilot, head, direction);
+        if (!snake_autopilot_is_free(game, next)) continue;
+        any_direction = direction;
+        if (!snake_autopilot_is_safe(autopilot, game, next)) continue;
+
+        // Without a cycle the food is just approached head on
+        uint32_t score;
+        if (autopilot->has_cycle) {
+            uint32_t step = snake_autopilot_cycle_distance(autopilot, head, next);
+            bool passes_food = game->food != SNAKE_NO_FOOD && step > snake_autopilot_cycle_distance(autopilot, head, game->food);
+            score = passes_food ? 0 : step;
+        } else {
+            score = game->food == SNAKE_NO_FOOD ? 1 : autopilot->cell_count - snake_autopilot_distance(autopilot, next, game->food);
+        }
+
+        if (score > best_score) {
+            best_score     = score;
+            best_direction = direction;
+        }
+    }
+
+    // Out of order from steering by hand, anything that doesn't hit a wall right away will do
+    if (best_direction == SNAKE_AUTOPILOT_NO_DIRECTION) best_direction = any_direction;
+    if (best_direction == SNAKE_AUTOPILOT_NO_DIRECTION) return game->direction;
+    return (enum Direction) best_direction;
+}
+
+// The turn to make this turn, `SNAKE_ACTION_NONE` to keep going straight
+enum Snake_Action snake_autopilot_decide(struct Snake_Autopilot *autopilot, const struct Snake_Game *game) {
+    assert(game->width == autopilot->width && game->height == autopilot->height && "Autopilot is for another board size");
+
+    uint32_t head = snake_game_link(game, 0);
+    uint32_t food = game->food;
+
+    bool has_path = autopilot->path_count > 0 && autopilot->path_head == head && autopilot->path_food == food;
+    if (!has_path && food != SNAKE_NO_FOOD && food != autopilot->given_up_food) {
+        has_path = snake_autopilot_search(autopilot, game);
+        if (!has_path) autopilot->given_up_food = food;
+    }
+
+    enum Direction direction;
+    if (has_path) {
+        direction = (enum Direction) autopilot->path[autopilot->path_count - 1];
+        uint32_t next = snake_autopilot_neighbor(autopilot, head, direction);
+
+        if (snake_autopilot_is_free(game, next) && snake_autopilot_is_safe(autopilot, game, next)) {
+            autopilot->path_count -= 1;
+            autopilot->path_head   = next;
+        } else {
+            autopilot->path_count    = 0;
+            autopilot->given_up_food = food;
+            direction = snake_autopilot_shortcut(autopilot, game);
+        }
+    } else {
+        direction = snake_autopilot_shortcut(autopilot, game);
+    }
+
+    if (direction == game->direction) return SNAKE_ACTION_NONE;
+    return (enum Snake_Action) (SNAKE_ACTION_UP + (int) direction);
+}
+
+#endif // E_SNAKE_AUTOPILOT_H
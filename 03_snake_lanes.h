@@ -0,0 +1,445 @@
+#pragma once
+#ifndef E_SNAKE_LANES_H
+#define E_SNAKE_LANES_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/random.h"
+#include "common/thread_pool.h"
+#include "03_snake_simulation.h"
+
+// Many snake games stepped in lockstep, `SNAKE_LANES` games per instruction. Same rules and
+// actions as `Snake_Batch`, but the per-game scalars are stored as a structure of arrays so a
+// turn, the move, the wraparound, growth, and the food and death tests are all masked vector
+// ops. Bodies and boards can't be vectors, each lane reads its tail and its head's board word
+// with a gather, and with AVX-512 writes them back with a scatter.
+//
+// Food is picked differently than `Snake_Game` does, there is no free-cell list to keep in step
+// here: a few random cells are tried against the board, then a uniform pick among the free
+// cells by counting bits. Runs are still deterministic for a seed on any lane width or thread
+// count, the scalar path below is the reference the vector paths must match exactly.
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define SNAKE_LANES 16
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define SNAKE_LANES 8
+#else
+#define SNAKE_LANES 1
+#endif
+
+// Multiple of every lane width so chunk boundaries never split a SIMD step
+const size_t SNAKE_LANES_CHUNK_SIZE = 256;
+
+// Random cells tried for food before counting free cells instead
+const int SNAKE_LANES_FOOD_ATTEMPTS = 8;
+
+struct Snake_Lanes {
+    size_t count;
+
+    int      width;
+    int      height;
+    uint32_t cell_count;
+    uint32_t board_words;  // 32-bit words per occupancy board, the gather width
+
+    // One entry per game
+    int32_t  *head_x;
+    int32_t  *head_y;
+    uint32_t *direction;
+    uint32_t *head_slot;
+    uint32_t *length;
+    uint32_t *growth;
+    uint32_t *food;
+    struct Random *random;  // Only drawn from on food and resets, which are scalar anyway
+
+    // Game i's ring buffer is `rings[i * cell_count ...]`, its board `boards[i * board_words ...]`
+    uint32_t *rings;
+    uint32_t *boards;
+
+    // Finished games and food eaten since the lanes were created
+    uint32_t *episode_counts;
+    uint32_t *food_counts;
+};
+
+uint32_t *snake_lanes_ring(const struct Snake_Lanes *self, size_t i) {
+    return &self->rings[i * self->cell_count];
+}
+
+uint32_t *snake_lanes_board(const struct Snake_Lanes *self, size_t i) {
+    return &self->boards[i * self->board_words];
+}
+
+bool snake_lanes_is_occupied(const struct Snake_Lanes *self, size_t i, uint32_t cell) {
+    return (snake_lanes_board(self, i)[cell / 32] >> (cell % 32)) & 1;
+}
+
+void snake_lanes_place_food(struct Snake_Lanes *self, size_t i) {
+    struct Random *random = &self->random[i];
+    uint32_t free_count = self->cell_count - self->length[i];
+    if (free_count == 0) {
+        self->food[i] = SNAKE_NO_FOOD;
+        return;
+    }
+
+    for (int attempt = 0; attempt < SNAKE_LANES_FOOD_ATTEMPTS; ++attempt) {
+        uint32_t cell = random_bounded(random, self->cell_count);
+        if (snake_lanes_is_occupied(self, i, cell)) continue;
+        self->food[i] = cell;
+        return;
+    }
+
+    // Mostly snake by now, find the k-th free cell
+    uint32_t k = random_bounded(random, free_count);
+    const uint32_t *board = snake_lanes_board(self, i);
+    for (uint32_t word = 0; word < self->board_words; ++word) {
+        uint32_t bits_in_word = self->cell_count - word * 32 < 32 ? self->cell_count - word * 32 : 32;
+        uint32_t free_bits = ~board[word] & (bits_in_word == 32 ? UINT32_MAX : (1u << bits_in_word) - 1);
+
+        uint32_t bit_count = (uint32_t) __builtin_popcount(free_bits);
+        if (k >= bit_count) {
+            k -= bit_count;
+            continue;
+        }
+
+        for (; k > 0; --k) free_bits &= free_bits - 1;
+        self->food[i] = word * 32 + (uint32_t) __builtin_ctz(free_bits);
+        return;
+    }
+    assert(false && "Free cell count out of sync with the board");
+}
+
+void snake_lanes_reset(struct Snake_Lanes *self, size_t i) {
+    struct Random *random = &self->random[i];
+    self->direction[i] = (uint32_t) random_int_range(random, 0, 3);
+    self->head_x[i]    = random_int_range(random, 0, self->width  - 1);
+    self->head_y[i]    = random_int_range(random, 0, self->height - 1);
+    self->head_slot[i] = 0;
+    self->length[i]    = 1;
+    self->growth[i]    = 0;
+
+    uint32_t cell = (uint32_t) self->head_x[i] + (uint32_t) self->head_y[i] * (uint32_t) self->width;
+    snake_lanes_ring(self, i)[0] = cell;
+
+    uint32_t *board = snake_lanes_board(self, i);
+    memset(board, 0, self->board_words * sizeof(uint32_t));
+    board[cell / 32] |= 1u << (cell % 32);
+
+    snake_lanes_place_food(self, i);
+}
+
+struct Snake_Lanes snake_lanes_create(size_t count, int width, int height, uint64_t seed) {
+    assert(width > 0 && height > 0 && "Board size out of range");
+    // Gather offsets are 32-bit, measured from the first game of a group
+    assert((uint64_t) width * (uint64_t) height * SNAKE_LANES < INT32_MAX && "Board too big for the lane gathers");
+
+    struct Snake_Lanes self = { };
+    self.count       = count;
+    self.width       = width;
+    self.height      = height;
+    self.cell_count  = (uint32_t) width * (uint32_t) height;
+    self.board_words = (self.cell_count + 31) / 32;
+
+    self.head_x         = (int32_t *)  calloc(count, sizeof(int32_t));
+    self.head_y         = (int32_t *)  calloc(count, sizeof(int32_t));
+    self.direction      = (uint32_t *) calloc(count, sizeof(uint32_t));
+    self.head_slot      = (uint32_t *) calloc(count, sizeof(uint32_t));
+    self.length         = (uint32_t *) calloc(count, sizeof(uint32_t));
+    self.growth         = (uint32_t *) calloc(count, sizeof(uint32_t));
+    self.food           = (uint32_t *) calloc(count, sizeof(uint32_t));
+    self.random         = (struct Random *) calloc(count, sizeof(struct Random));
+    self.rings          = (uint32_t *) calloc(count * self.cell_count,  sizeof(uint32_t));
+    self.boards         = (uint32_t *) calloc(count * self.board_words, sizeof(uint32_t));
+    self.episode_counts = (uint32_t *) calloc(count, sizeof(uint32_t));
+    self.food_counts    = (uint32_t *) calloc(count, sizeof(uint32_t));
+    assert(self.head_x && self.head_y && self.direction && self.head_slot && self.length && self.growth &&
+           self.food && self.random && self.rings && self.boards && self.episode_counts && self.food_counts &&
+           "Failed to allocate snake lanes");
+
+    // Game i uses stream i of the seed, like `Snake_Batch`
+    for (size_t i = 0; i < count; ++i) {
+        self.random[i] = random_create(seed, i);
+        snake_lanes_reset(&self, i);
+    }
+    return self;
+}
+
+void snake_lanes_destroy(struct Snake_Lanes *self) {
+    free(self->head_x);
+    free(self->head_y);
+    free(self->direction);
+    free(self->head_slot);
+    free(self->length);
+    free(self->growth);
+    free(self->food);
+    free(self->random);
+    free(self->rings);
+    free(self->boards);
+    free(self->episode_counts);
+    free(self->food_counts);
+    *self = { };
+}
+
+// After the board has been updated for the move. Dead games start over right away.
+uint32_t snake_lanes_finish_step(struct Snake_Lanes *self, size_t i, uint32_t cell, bool died) {
+    if (died) {
+        self->episode_counts[i] += 1;
+        snake_lanes_reset(self, i);
+        return SNAKE_STEP_DIED;
+    }
+    if (cell != self->food[i]) return 0;
+
+    self->growth[i] += 1;
+    self->food_counts[i] += 1;
+    snake_lanes_place_food(self, i);
+    return SNAKE_STEP_ATE;
+}
+
+// Steps games [begin, end) one at a time. Used for the tail of the SIMD kernel and as its reference.
+// Every action has to be below SNAKE_ACTION_COUNT, nothing here checks.
+void snake_lanes_step_scalar(struct Snake_Lanes *self, const uint8_t *actions, uint8_t *results, size_t begin, size_t end) {
+    const uint32_t cap = self->cell_count;
+    for (size_t i = begin; i < end; ++i) {
+        // Directions are numbered so that the reverse of d is d ^ 1, and actions are direction + 1
+        uint32_t action = actions[i];
+        uint32_t want   = action - 1;
+        if (action != SNAKE_ACTION_NONE && want != (self->direction[i] ^ 1)) self->direction[i] = want;
+
+        static const int32_t dx[] = { 0, 0, -1, 1 };
+        static const int32_t dy[] = { -1, 1, 0, 0 };
+        int32_t x = self->head_x[i] + dx[self->direction[i]];
+        int32_t y = self->head_y[i] + dy[self->direction[i]];
+        if (x < 0) x = self->width  - 1;
+        if (y < 0) y = self->height - 1;
+        if (x == self->width)  x = 0;
+        if (y == self->height) y = 0;
+        self->head_x[i] = x;
+        self->head_y[i] = y;
+        uint32_t cell = (uint32_t) x + (uint32_t) y * (uint32_t) self->width;
+
+        uint32_t *ring = snake_lanes_ring(self, i);
+        uint32_t tail_slot = self->head_slot[i] + self->length[i] - 1;
+        if (tail_slot >= cap) tail_slot -= cap;
+        uint32_t tail = ring[tail_slot];
+
+        self->head_slot[i] = (self->head_slot[i] == 0 ? cap : self->head_slot[i]) - 1;
+        ring[self->head_slot[i]] = cell;
+
+        uint32_t *board = snake_lanes_board(self, i);
+        if (self->growth[i] > 0 && self->length[i] < cap) {
+            self->growth[i] -= 1;
+            self->length[i] += 1;
+        } else {
+            board[tail / 32] &= ~(1u << (tail % 32));
+        }
+
+        bool died = (board[cell / 32] >> (cell % 32)) & 1;
+        if (!died) board[cell / 32] |= 1u << (cell % 32);
+
+        uint32_t flags = snake_lanes_finish_step(self, i, cell, died);
+        if (results) results[i] = (uint8_t) flags;
+    }
+}
+
+// Steps games [begin, end) `SNAKE_LANES` at a time. Deaths and meals are rare, so they are
+// collected into bit masks and finished one game at a time after the vector part.
+void snake_lanes_step_range(struct Snake_Lanes *self, const uint8_t *actions, uint8_t *results, size_t begin, size_t end) {
+    size_t i = begin;
+
+#if SNAKE_LANES == 16
+    const int32_t cap = (int32_t) self->cell_count;
+    const __m512i zero   = _mm512_setzero_si512();
+    const __m512i one    = _mm512_set1_epi32(1);
+    const __m512i bit    = _mm512_set1_epi32(31);
+    const __m512i width  = _mm512_set1_epi32(self->width);
+    const __m512i height = _mm512_set1_epi32(self->height);
+    const __m512i last_x = _mm512_set1_epi32(self->width  - 1);
+    const __m512i last_y = _mm512_set1_epi32(self->height - 1);
+    const __m512i ring_size = _mm512_set1_epi32(cap);
+    const __m512i lane      = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i ring_offsets  = _mm512_mullo_epi32(lane, ring_size);
+    const __m512i board_offsets = _mm512_mullo_epi32(lane, _mm512_set1_epi32((int) self->board_words));
+    const __m512i dx = _mm512_setr_epi32(0, 0, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m512i dy = _mm512_setr_epi32(-1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    for (; i + 16 <= end; i += 16) {
+        __m512i action    = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *) &actions[i]));
+        __m512i direction = _mm512_loadu_si512(&self->direction[i]);
+        __m512i want      = _mm512_sub_epi32(action, one);
+        __mmask16 turn    = _mm512_cmpneq_epi32_mask(action, zero) & _mm512_cmpneq_epi32_mask(want, _mm512_xor_si512(direction, one));
+        direction = _mm512_mask_mov_epi32(direction, turn, want);
+
+        __m512i x = _mm512_add_epi32(_mm512_loadu_si512(&self->head_x[i]), _mm512_permutexvar_epi32(direction, dx));
+        __m512i y = _mm512_add_epi32(_mm512_loadu_si512(&self->head_y[i]), _mm512_permutexvar_epi32(direction, dy));
+        x = _mm512_mask_mov_epi32(x, _mm512_cmplt_epi32_mask(x, zero), last_x);
+        y = _mm512_mask_mov_epi32(y, _mm512_cmplt_epi32_mask(y, zero), last_y);
+        x = _mm512_mask_mov_epi32(x, _mm512_cmpeq_epi32_mask(x, width),  zero);
+        y = _mm512_mask_mov_epi32(y, _mm512_cmpeq_epi32_mask(y, height), zero);
+        __m512i cell = _mm512_add_epi32(x, _mm512_mullo_epi32(y, width));
+
+        int *ring = (int *) snake_lanes_ring(self, i);
+        __m512i head_slot = _mm512_loadu_si512(&self->head_slot[i]);
+        __m512i length    = _mm512_loadu_si512(&self->length[i]);
+        __m512i tail_slot = _mm512_add_epi32(head_slot, _mm512_sub_epi32(length, one));
+        tail_slot = _mm512_mask_sub_epi32(tail_slot, _mm512_cmpge_epi32_mask(tail_slot, ring_size), tail_slot, ring_size);
+        __m512i tail = _mm512_i32gather_epi32(_mm512_add_epi32(ring_offsets, tail_slot), ring, 4);
+
+        head_slot = _mm512_mask_mov_epi32(head_slot, _mm512_cmpeq_epi32_mask(head_slot, zero), ring_size);
+        head_slot = _mm512_sub_epi32(head_slot, one);
+        _mm512_i32scatter_epi32(ring, _mm512_add_epi32(ring_offsets, head_slot), cell, 4);
+
+        __m512i growth = _mm512_loadu_si512(&self->growth[i]);
+        __mmask16 grow = _mm512_cmpgt_epi32_mask(growth, zero) & _mm512_cmplt_epi32_mask(length, ring_size);
+        growth = _mm512_mask_sub_epi32(growth, grow, growth, one);
+        length = _mm512_mask_add_epi32(length, grow, length, one);
+
+        // The tail's word is written back before the head's is read, they can be the same word
+        int *board = (int *) snake_lanes_board(self, i);
+        __m512i tail_word  = _mm512_add_epi32(board_offsets, _mm512_srli_epi32(tail, 5));
+        __m512i tail_bits  = _mm512_i32gather_epi32(tail_word, board, 4);
+        tail_bits = _mm512_andnot_si512(_mm512_sllv_epi32(one, _mm512_and_si512(tail, bit)), tail_bits);
+        _mm512_mask_i32scatter_epi32(board, (__mmask16) ~grow, tail_word, tail_bits, 4);
+
+        __m512i head_word = _mm512_add_epi32(board_offsets, _mm512_srli_epi32(cell, 5));
+        __m512i head_bit  = _mm512_sllv_epi32(one, _mm512_and_si512(cell, bit));
+        __m512i head_bits = _mm512_i32gather_epi32(head_word, board, 4);
+        __mmask16 died = _mm512_test_epi32_mask(head_bits, head_bit);
+        _mm512_mask_i32scatter_epi32(board, (__mmask16) ~died, head_word, _mm512_or_si512(head_bits, head_bit), 4);
+
+        __mmask16 ate = _mm512_cmpeq_epi32_mask(cell, _mm512_loadu_si512(&self->food[i])) & (__mmask16) ~died;
+
+        _mm512_storeu_si512(&self->direction[i], direction);
+        _mm512_storeu_si512(&self->head_x[i],    x);
+        _mm512_storeu_si512(&self->head_y[i],    y);
+        _mm512_storeu_si512(&self->head_slot[i], head_slot);
+        _mm512_storeu_si512(&self->length[i],    length);
+        _mm512_storeu_si512(&self->growth[i],    growth);
+
+        if (results) memset(&results[i], 0, 16);
+        alignas(64) uint32_t cells[16];
+        _mm512_store_si512(cells, cell);
+        for (unsigned mask = (unsigned) (died | ate); mask; mask &= mask - 1) {
+            size_t lane_index = (size_t) __builtin_ctz(mask);
+            uint32_t flags = snake_lanes_finish_step(self, i + lane_index, cells[lane_index], (died >> lane_index) & 1);
+            if (results) results[i + lane_index] = (uint8_t) flags;
+        }
+    }
+#elif SNAKE_LANES == 8
+    const int32_t cap = (int32_t) self->cell_count;
+    const __m256i zero   = _mm256_setzero_si256();
+    const __m256i one    = _mm256_set1_epi32(1);
+    const __m256i bit    = _mm256_set1_epi32(31);
+    const __m256i width  = _mm256_set1_epi32(self->width);
+    const __m256i height = _mm256_set1_epi32(self->height);
+    const __m256i last_x = _mm256_set1_epi32(self->width  - 1);
+    const __m256i last_y = _mm256_set1_epi32(self->height - 1);
+    const __m256i ring_size = _mm256_set1_epi32(cap);
+    const __m256i last_slot = _mm256_set1_epi32(cap - 1);
+    const __m256i lane      = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i ring_offsets  = _mm256_mullo_epi32(lane, ring_size);
+    const __m256i board_offsets = _mm256_mullo_epi32(lane, _mm256_set1_epi32((int) self->board_words));
+    const __m256i dx = _mm256_setr_epi32(0, 0, -1, 1, 0, 0, 0, 0);
+    const __m256i dy = _mm256_setr_epi32(-1, 1, 0, 0, 0, 0, 0, 0);
+
+    for (; i + 8 <= end; i += 8) {
+        __m256i action    = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) &actions[i]));
+        __m256i direction = _mm256_loadu_si256((const __m256i *) &self->direction[i]);
+        __m256i want      = _mm256_sub_epi32(action, one);
+        __m256i blocked   = _mm256_or_si256(_mm256_cmpeq_epi32(action, zero), _mm256_cmpeq_epi32(want, _mm256_xor_si256(direction, one)));
+        direction = _mm256_blendv_epi8(want, direction, blocked);
+
+        __m256i x = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) &self->head_x[i]), _mm256_permutevar8x32_epi32(dx, direction));
+        __m256i y = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) &self->head_y[i]), _mm256_permutevar8x32_epi32(dy, direction));
+        x = _mm256_blendv_epi8(x, last_x, _mm256_cmpgt_epi32(zero, x));
+        y = _mm256_blendv_epi8(y, last_y, _mm256_cmpgt_epi32(zero, y));
+        x = _mm256_andnot_si256(_mm256_cmpeq_epi32(x, width),  x);
+        y = _mm256_andnot_si256(_mm256_cmpeq_epi32(y, height), y);
+        __m256i cell = _mm256_add_epi32(x, _mm256_mullo_epi32(y, width));
+
+        const int *ring = (const int *) snake_lanes_ring(self, i);
+        __m256i head_slot = _mm256_loadu_si256((const __m256i *) &self->head_slot[i]);
+        __m256i length    = _mm256_loadu_si256((const __m256i *) &self->length[i]);
+        __m256i tail_slot = _mm256_add_epi32(head_slot, _mm256_sub_epi32(length, one));
+        tail_slot = _mm256_sub_epi32(tail_slot, _mm256_and_si256(_mm256_cmpgt_epi32(tail_slot, last_slot), ring_size));
+        __m256i tail = _mm256_i32gather_epi32(ring, _mm256_add_epi32(ring_offsets, tail_slot), 4);
+
+        head_slot = _mm256_blendv_epi8(head_slot, ring_size, _mm256_cmpeq_epi32(head_slot, zero));
+        head_slot = _mm256_sub_epi32(head_slot, one);
+
+        // Lanes grow with -1 masks, subtracting the mask adds one
+        __m256i growth = _mm256_loadu_si256((const __m256i *) &self->growth[i]);
+        __m256i grow   = _mm256_and_si256(_mm256_cmpgt_epi32(growth, zero), _mm256_cmpgt_epi32(ring_size, length));
+        growth = _mm256_add_epi32(growth, grow);
+        length = _mm256_sub_epi32(length, grow);
+
+        _mm256_storeu_si256((__m256i *) &self->direction[i], direction);
+        _mm256_storeu_si256((__m256i *) &self->head_x[i],    x);
+        _mm256_storeu_si256((__m256i *) &self->head_y[i],    y);
+        _mm256_storeu_si256((__m256i *) &self->head_slot[i], head_slot);
+        _mm256_storeu_si256((__m256i *) &self->length[i],    length);
+        _mm256_storeu_si256((__m256i *) &self->growth[i],    growth);
+
+        // AVX2 has no scatter, the head and the tail's bit are written back one lane at a time
+        alignas(32) uint32_t cells[8];
+        alignas(32) uint32_t tails[8];
+        _mm256_store_si256((__m256i *) cells, cell);
+        _mm256_store_si256((__m256i *) tails, tail);
+        unsigned kept = (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(grow));
+        for (size_t l = 0; l < 8; ++l) {
+            snake_lanes_ring(self, i + l)[self->head_slot[i + l]] = cells[l];
+            if (!((kept >> l) & 1)) snake_lanes_board(self, i + l)[tails[l] / 32] &= ~(1u << (tails[l] % 32));
+        }
+
+        const int *board = (const int *) snake_lanes_board(self, i);
+        __m256i head_word = _mm256_add_epi32(board_offsets, _mm256_srli_epi32(cell, 5));
+        __m256i head_bits = _mm256_i32gather_epi32(board, head_word, 4);
+        __m256i died = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_srlv_epi32(head_bits, _mm256_and_si256(cell, bit)), one), one);
+        __m256i ate  = _mm256_andnot_si256(died, _mm256_cmpeq_epi32(cell, _mm256_loadu_si256((const __m256i *) &self->food[i])));
+
+        unsigned died_mask = (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(died));
+        unsigned ate_mask  = (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(ate));
+        for (size_t l = 0; l < 8; ++l) {
+            if (!((died_mask >> l) & 1)) snake_lanes_board(self, i + l)[cells[l] / 32] |= 1u << (cells[l] % 32);
+        }
+
+        if (results) memset(&results[i], 0, 8);
+        for (unsigned mask = died_mask | ate_mask; mask; mask &= mask - 1) {
+            size_t l = (size_t) __builtin_ctz(mask);
+            uint32_t flags = snake_lanes_finish_step(self, i + l, cells[l], (died_mask >> l) & 1);
+            if (results) results[i + l] = (uint8_t) flags;
+        }
+    }
+#endif
+
+    snake_lanes_step_scalar(self, actions, results, i, end);
+}
+
+struct Snake_Lanes_Job {
+    struct Snake_Lanes *lanes;
+    const uint8_t *actions;
+    uint8_t *results;
+};
+
+void snake_lanes_step_job(void *user_data, size_t chunk) {
+    struct Snake_Lanes_Job *job = (struct Snake_Lanes_Job *) user_data;
+    size_t begin = chunk * SNAKE_LANES_CHUNK_SIZE;
+    size_t end   = begin + SNAKE_LANES_CHUNK_SIZE < job->lanes->count ? begin + SNAKE_LANES_CHUNK_SIZE : job->lanes->count;
+    snake_lanes_step_range(job->lanes, job->actions, job->results, begin, end);
+}
+
+// One step of every game on `pool`. `results` can be NULL.
+void snake_lanes_step(struct Snake_Lanes *self, const uint8_t *actions, uint8_t *results, struct Thread_Pool *pool) {
+    struct Snake_Lanes_Job job = { };
+    job.lanes   = self;
+    job.actions = actions;
+    job.results = results;
+
+    size_t chunk_count = (self->count + SNAKE_LANES_CHUNK_SIZE - 1) / SNAKE_LANES_CHUNK_SIZE;
+    thread_pool_run(pool, chunk_count, &snake_lanes_step_job, &job);
+}
+
+#endif // E_SNAKE_LANES_H
@@ -0,0 +1,308 @@
+#pragma once
+#ifndef E_SNAKE_REPLAY_H
+#define E_SNAKE_REPLAY_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "03_snake_simulation.h"
+
+// Replays for 03_snake. `Snake_Game` takes every random pick from its own stream, so the seed,
+// the board size and the input are enough to play a session back exactly.
+//
+// Input is stored as (tick, event) pairs, each one LEB128 varint of the ticks since the previous
+// event shifted over the event code. Turns without input cost nothing and a turn with input is a
+// single byte unless the player waited more than 15 turns, so a session is a few bytes per turn
+// at most and usually well under one.
+//
+// Playback snapshots the game every SNAKE_REPLAY_KEYFRAME_INTERVAL turns the first time it gets
+// there, seeking restores the closest snapshot before the target and plays forward from it.
+
+// Event codes, the turns share their values with `Snake_Action`
+enum Snake_Replay_Event {
+    SNAKE_REPLAY_TURN_UP    = SNAKE_ACTION_UP,
+    SNAKE_REPLAY_TURN_DOWN  = SNAKE_ACTION_DOWN,
+    SNAKE_REPLAY_TURN_LEFT  = SNAKE_ACTION_LEFT,
+    SNAKE_REPLAY_TURN_RIGHT = SNAKE_ACTION_RIGHT,
+    SNAKE_REPLAY_EXTEND     = SNAKE_ACTION_COUNT,
+};
+
+const int SNAKE_REPLAY_EVENT_BITS = 3;
+static_assert(SNAKE_REPLAY_EXTEND < (1 << SNAKE_REPLAY_EVENT_BITS), "Replay events don't fit their bits");
+
+const uint64_t SNAKE_REPLAY_KEYFRAME_INTERVAL = 1024;
+
+// Bump whenever the rules in 03_snake_simulation.h change, old replays would play out differently
+const char     SNAKE_REPLAY_MAGIC[8] = { 'S', 'N', 'A', 'K', 'E', 'R', 'P', 'L' };
+const uint32_t SNAKE_REPLAY_VERSION  = 1;
+
+struct Snake_Replay_Header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    int32_t  width;
+    int32_t  height;
+    uint64_t seed;
+    uint64_t stream;
+    uint64_t tick_count;
+    uint64_t byte_count;
+};
+static_assert(sizeof(struct Snake_Replay_Header) == 56, "Replay header layout changed, bump SNAKE_REPLAY_VERSION");
+
+struct Snake_Replay {
+    uint64_t seed;
+    uint64_t stream;
+    int      width;
+    int      height;
+
+    uint64_t tick_count;       // Turns recorded
+    uint64_t last_event_tick;  // What the next event's delta is measured from
+
+    uint8_t *bytes;
+    size_t   size;
+    size_t   capacity;
+};
+
+struct Snake_Replay snake_replay_create(uint64_t seed, uint64_t stream, int width, int height) {
+    struct Snake_Replay replay = { };
+    replay.seed   = seed;
+    replay.stream = stream;
+    replay.width  = width;
+    replay.height = height;
+    return replay;
+}
+
+void snake_replay_destroy(struct Snake_Replay *replay) {
+    free(replay->bytes);
+    *replay = { };
+}
+
+// The game the replay starts from
+struct Snake_Game snake_replay_game_create(const struct Snake_Replay *replay) {
+    return snake_game_create(replay->width, replay->height, replay->seed, replay->stream);
+}
+
+void snake_replay_write_varint(struct Snake_Replay *replay, uint64_t value) {
+    if (replay->size + 10 > replay->capacity) {
+        replay->capacity = replay->capacity ? replay->capacity * 2 : 4096;
+        replay->bytes = (uint8_t *) realloc(replay->bytes, replay->capacity);
+        assert(replay->bytes && "Failed to grow replay");
+    }
+
+    for (; value >= 0x80; value >>= 7) replay->bytes[replay->size++] = (uint8_t) (value | 0x80);
+    replay->bytes[replay->size++] = (uint8_t) value;
+}
+
+// Returns false past the end or on a truncated varint
+bool snake_replay_read_varint(const uint8_t *bytes, size_t size, size_t *offset, uint64_t *value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && *offset < size; shift += 7) {
+        uint8_t byte = bytes[(*offset)++];
+        *value |= (uint64_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+void snake_replay_record(struct Snake_Replay *replay, enum Snake_Replay_Event event) {
+    uint64_t delta = replay->tick_count - replay->last_event_tick;
+    snake_replay_write_varint(replay, (delta << SNAKE_REPLAY_EVENT_BITS) | (uint64_t) event);
+    replay->last_event_tick = replay->tick_count;
+}
+
+// Records the input of the next turn, call it right before the turn's `snake_step`
+void snake_replay_record_turn(struct Snake_Replay *replay, enum Snake_Action action, uint32_t extend_count) {
+    for (uint32_t i = 0; i < extend_count; ++i) snake_replay_record(replay, SNAKE_REPLAY_EXTEND);
+    if (action != SNAKE_ACTION_NONE) snake_replay_record(replay, (enum Snake_Replay_Event) action);
+    replay->tick_count += 1;
+}
+
+bool snake_replay_save(const struct Snake_Replay *replay, const char *path) {
+    struct Snake_Replay_Header header = { };
+    memcpy(header.magic, SNAKE_REPLAY_MAGIC, sizeof(header.magic));
+    header.version     = SNAKE_REPLAY_VERSION;
+    header.header_size = (uint32_t) sizeof(header);
+    header.width       = replay->width;
+    header.height      = replay->height;
+    header.seed        = replay->seed;
+    header.stream      = replay->stream;
+    header.tick_count  = replay->tick_count;
+    header.byte_count  = replay->size;
+
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && replay->size > 0) ok = fwrite(replay->bytes, replay->size, 1, file) == 1;
+    ok = (fclose(file) == 0) && ok;
+    return ok;
+}
+
+// Rejects files from another version, the rules they were recorded with are gone
+bool snake_replay_load(const char *path, struct Snake_Replay *replay) {
+    *replay = { };
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    struct Snake_Replay_Header header = { };
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+           && memcmp(header.magic, SNAKE_REPLAY_MAGIC, sizeof(header.magic)) == 0
+           && header.version     == SNAKE_REPLAY_VERSION
+           && header.header_size == sizeof(header)
+           && header.width  > 0 && header.height > 0;
+
+    if (ok) {
+        *replay = snake_replay_create(header.seed, header.stream, header.width, header.height);
+        replay->tick_count = header.tick_count;
+        replay->size       = (size_t) header.byte_count;
+        replay->capacity   = replay->size;
+        replay->bytes      = (uint8_t *) malloc(replay->size ? replay->size : 1);
+        ok = replay->bytes && (replay->size == 0 || fread(replay->bytes, replay->size, 1, file) == 1);
+    }
+
+    fclose(file);
+    if (!ok) snake_replay_destroy(replay);
+    return ok;
+}
+
+// Everything that decides how a game goes on, in `cell_count` cells: the body from the head,
+// then the free cells in the order food is picked from
+void snake_game_snapshot(const struct Snake_Game *game, uint32_t *cells) {
+    for (uint32_t i = 0; i < game->length; ++i) cells[i] = snake_game_link(game, i);
+    memcpy(&cells[game->length], game->occupancy.free_cells, game->occupancy.free_count * sizeof(uint32_t));
+}
+
+// `game` must already be allocated for the same board. The ring restarts at slot 0, only the
+// order of the links matters.
+void snake_game_restore(struct Snake_Game *game, const struct Snake_Game *scalars, const uint32_t *cells) {
+    game->random    = scalars->random;
+    game->turn      = scalars->turn;
+    game->direction = scalars->direction;
+    game->is_dead   = scalars->is_dead;
+    game->head      = 0;
+    game->length    = scalars->length;
+    game->growth    = scalars->growth;
+    game->food      = scalars->food;
+    memcpy(game->cells, cells, game->length * sizeof(uint32_t));
+
+    struct Board_Occupancy *occupancy = &game->occupancy;
+    memset(occupancy->occupied, 0, (occupancy->cell_count + 63) / 64 * sizeof(uint64_t));
+    for (uint32_t i = 0; i < game->length; ++i) occupancy->occupied[cells[i] / 64] |= 1ull << (cells[i] % 64);
+
+    occupancy->free_count = game->cell_count - game->length;
+    memcpy(occupancy->free_cells, &cells[game->length], occupancy->free_count * sizeof(uint32_t));
+    for (uint32_t slot = 0; slot < occupancy->free_count; ++slot) occupancy->free_slots[occupancy->free_cells[slot]] = slot;
+}
+
+struct Snake_Replay_Keyframe {
+    uint64_t tick;
+
+    // Decoder position: the next event starts at `offset`, its delta counts from `event_tick`
+    size_t   offset;
+    uint64_t event_tick;
+
+    struct Snake_Game scalars;  // Copy of the game's scalars, its arrays are not owned
+};
+
+struct Snake_Replay_Player {
+    const struct Snake_Replay *replay;
+    struct Snake_Game game;
+    uint64_t tick;
+
+    size_t   offset;
+    uint64_t event_tick;
+
+    size_t keyframe_count;
+    size_t keyframe_capacity;
+    struct Snake_Replay_Keyframe *keyframes;
+    uint32_t *keyframe_cells;  // `cell_count` per keyframe
+};
+
+void snake_replay_player_keyframe(struct Snake_Replay_Player *player) {
+    if (player->keyframe_count == player->keyframe_capacity) {
+        player->keyframe_capacity = player->keyframe_capacity ? player->keyframe_capacity * 2 : 16;
+        player->keyframes      = (struct Snake_Replay_Keyframe *) realloc(player->keyframes, player->keyframe_capacity * sizeof(struct Snake_Replay_Keyframe));
+        player->keyframe_cells = (uint32_t *) realloc(player->keyframe_cells, player->keyframe_capacity * player->game.cell_count * sizeof(uint32_t));
+        assert(player->keyframes && player->keyframe_cells && "Failed to grow replay keyframes");
+    }
+
+    struct Snake_Replay_Keyframe *keyframe = &player->keyframes[player->keyframe_count];
+    keyframe->tick       = player->tick;
+    keyframe->offset     = player->offset;
+    keyframe->event_tick = player->event_tick;
+    keyframe->scalars    = player->game;
+    snake_game_snapshot(&player->game, &player->keyframe_cells[player->keyframe_count * player->game.cell_count]);
+    player->keyframe_count += 1;
+}
+
+struct Snake_Replay_Player snake_replay_player_create(const struct Snake_Replay *replay) {
+    struct Snake_Replay_Player player = { };
+    player.replay = replay;
+    player.game   = snake_replay_game_create(replay);
+    snake_replay_player_keyframe(&player);
+    return player;
+}
+
+void snake_replay_player_destroy(struct Snake_Replay_Player *player) {
+    snake_game_destroy(&player->game);
+    free(player->keyframes);
+    free(player->keyframe_cells);
+    *player = { };
+}
+
+// Plays the next recorded turn. Games that die are reset right away, the scene does the same
+// once the death animation is over and nothing is recorded in between.
+uint32_t snake_replay_player_step(struct Snake_Replay_Player *player) {
+    const struct Snake_Replay *replay = player->replay;
+    enum Snake_Action action = SNAKE_ACTION_NONE;
+
+    for (;;) {
+        size_t offset = player->offset;
+        uint64_t value = 0;
+        if (!snake_replay_read_varint(replay->bytes, replay->size, &offset, &value)) break;
+
+        uint64_t tick = player->event_tick + (value >> SNAKE_REPLAY_EVENT_BITS);
+        if (tick != player->tick) break;
+
+        uint32_t event = (uint32_t) (value & ((1u << SNAKE_REPLAY_EVENT_BITS) - 1));
+        if (event == SNAKE_REPLAY_EXTEND) snake_game_extend(&player->game);
+        else action = (enum Snake_Action) event;
+
+        player->offset     = offset;
+        player->event_tick = tick;
+    }
+
+    uint32_t flags = snake_step(&player->game, action);
+    if (flags & SNAKE_STEP_DIED) snake_game_reset(&player->game);
+    player->tick += 1;
+
+    if (player->tick % SNAKE_REPLAY_KEYFRAME_INTERVAL == 0 && player->tick / SNAKE_REPLAY_KEYFRAME_INTERVAL == player->keyframe_count) {
+        snake_replay_player_keyframe(player);
+    }
+    return flags;
+}
+
+// Leaves the player right before turn `tick`, clamped to the end of the replay
+void snake_replay_seek(struct Snake_Replay_Player *player, uint64_t tick) {
+    if (tick > player->replay->tick_count) tick = player->replay->tick_count;
+
+    size_t index = (size_t) (tick / SNAKE_REPLAY_KEYFRAME_INTERVAL);
+    if (index >= player->keyframe_count) index = player->keyframe_count - 1;
+
+    const struct Snake_Replay_Keyframe *keyframe = &player->keyframes[index];
+    if (tick < player->tick || keyframe->tick > player->tick) {
+        snake_game_restore(&player->game, &keyframe->scalars, &player->keyframe_cells[index * player->game.cell_count]);
+        player->tick       = keyframe->tick;
+        player->offset     = keyframe->offset;
+        player->event_tick = keyframe->event_tick;
+    }
+
+    while (player->tick < tick) snake_replay_player_step(player);
+}
+
+#endif // E_SNAKE_REPLAY_H
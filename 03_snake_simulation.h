@@ -0,0 +1,334 @@
+#pragma once
+#ifndef E_SNAKE_SIMULATION_H
+#define E_SNAKE_SIMULATION_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/math.h"
+#include "common/random.h"
+#include "common/thread_pool.h"
+
+// Snake rules for 03_snake, kept free of raylib so games can be stepped headless.
+// A game is fully determined by its seed and the actions it is given: every random pick comes
+// from the game's own stream, so the same inputs replay the same game on any machine and any
+// number of threads.
+//
+// The board wraps around at the edges. Cells are indexed x + y * width.
+
+enum Direction {
+    DIRECTION_UP,   DIRECTION_DOWN,
+    DIRECTION_LEFT, DIRECTION_RIGHT,
+};
+
+enum Snake_Action {
+    SNAKE_ACTION_NONE,
+    SNAKE_ACTION_UP,   SNAKE_ACTION_DOWN,
+    SNAKE_ACTION_LEFT, SNAKE_ACTION_RIGHT,
+    SNAKE_ACTION_COUNT,
+};
+
+// What a step did, as bit flags
+enum Snake_Step_Flags {
+    SNAKE_STEP_ATE  = 1 << 0,
+    SNAKE_STEP_DIED = 1 << 1,
+};
+
+// `food` when every cell is snake
+const uint32_t SNAKE_NO_FOOD = UINT32_MAX;
+
+// Which cells the snake covers, one bit per cell so self-collision is a single test. The free
+// cells are also kept packed in an array, with `free_slots` mapping a cell to where it sits in
+// it, so a cell leaves the set by swapping the last one into its place and food is a uniform
+// pick from the array no matter how full the board is.
+struct Board_Occupancy {
+    uint32_t  cell_count;
+    uint64_t *occupied;
+    uint32_t *free_cells;
+    uint32_t *free_slots;
+    uint32_t  free_count;
+};
+
+struct Snake_Game {
+    int      width;
+    int      height;
+    uint32_t cell_count;
+
+    struct Random random;
+    uint64_t turn;
+
+    enum Direction direction;
+    bool is_dead;
+
+    // The body is a ring buffer of `cell_count` cells running from the head at slot `head` to
+    // the tail. Moving pushes a new head in front and the tail falls off the end, growing keeps
+    // it, so a turn costs the same at any length.
+    uint32_t  head;
+    uint32_t  length;
+    uint32_t  growth;  // Links still to grow, one per turn
+    uint32_t *cells;
+
+    uint32_t food;
+    struct Board_Occupancy occupancy;
+};
+
+struct Board_Occupancy board_occupancy_create(uint32_t cell_count) {
+    struct Board_Occupancy occupancy = { };
+    occupancy.cell_count = cell_count;
+    occupancy.occupied   = (uint64_t *) calloc((cell_count + 63) / 64, sizeof(uint64_t));
+    occupancy.free_cells = (uint32_t *) calloc(cell_count, sizeof(uint32_t));
+    occupancy.free_slots = (uint32_t *) calloc(cell_count, sizeof(uint32_t));
+    assert(occupancy.occupied && occupancy.free_cells && occupancy.free_slots && "Failed to allocate board occupancy");
+    return occupancy;
+}
+
+void board_occupancy_destroy(struct Board_Occupancy *occupancy) {
+    free(occupancy->occupied);
+    free(occupancy->free_cells);
+    free(occupancy->free_slots);
+    *occupancy = { };
+}
+
+// Everything free
+void board_occupancy_reset(struct Board_Occupancy *occupancy) {
+    memset(occupancy->occupied, 0, (occupancy->cell_count + 63) / 64 * sizeof(uint64_t));
+    for (uint32_t cell = 0; cell < occupancy->cell_count; ++cell) {
+        occupancy->free_cells[cell] = cell;
+        occupancy->free_slots[cell] = cell;
+    }
+    occupancy->free_count = occupancy->cell_count;
+}
+
+bool board_is_occupied(const struct Board_Occupancy *occupancy, uint32_t cell) {
+    return (occupancy->occupied[cell / 64] >> (cell % 64)) & 1;
+}
+
+void board_occupy(struct Board_Occupancy *occupancy, uint32_t cell) {
+    if (board_is_occupied(occupancy, cell)) return;
+    occupancy->occupied[cell / 64] |= 1ull << (cell % 64);
+
+    uint32_t slot = occupancy->free_slots[cell];
+    uint32_t last = occupancy->free_cells[--occupancy->free_count];
+    occupancy->free_cells[slot] = last;
+    occupancy->free_slots[last] = slot;
+}
+
+void board_vacate(struct Board_Occupancy *occupancy, uint32_t cell) {
+    if (!board_is_occupied(occupancy, cell)) return;
+    occupancy->occupied[cell / 64] &= ~(1ull << (cell % 64));
+
+    occupancy->free_slots[cell] = occupancy->free_count;
+    occupancy->free_cells[occupancy->free_count++] = cell;
+}
+
+uint32_t snake_game_cell(const struct Snake_Game *game, struct Vector2_Int position) {
+    return (uint32_t) position.x + (uint32_t) position.y * (uint32_t) game->width;
+}
+
+struct Vector2_Int snake_game_position(const struct Snake_Game *game, uint32_t cell) {
+    return { .x = (int) (cell % (uint32_t) game->width), .y = (int) (cell / (uint32_t) game->width) };
+}
+
+// Cell of link `i` counted from the head
+uint32_t snake_game_link(const struct Snake_Game *game, uint32_t i) {
+    uint32_t slot = game->head + i;
+    if (slot >= game->cell_count) slot -= game->cell_count;
+    return game->cells[slot];
+}
+
+void snake_game_place_food(struct Snake_Game *game) {
+    struct Board_Occupancy *occupancy = &game->occupancy;
+    if (occupancy->free_count == 0) {
+        game->food = SNAKE_NO_FOOD;
+        return;
+    }
+    game->food = occupancy->free_cells[random_bounded(&game->random, occupancy->free_count)];
+}
+
+// A new one-link snake and new food, continuing the game's random stream
+void snake_game_reset(struct Snake_Game *game) {
+    game->direction = (enum Direction) random_int_range(&game->random, 0, 3);
+    game->is_dead   = false;
+    game->turn      = 0;
+    game->head      = 0;
+    game->length    = 1;
+    game->growth    = 0;
+    game->cells[0]  = snake_game_cell(game, {
+        .x = random_int_range(&game->random, 0, game->width  - 1),
+        .y = random_int_range(&game->random, 0, game->height - 1)
+    });
+
+    board_occupancy_reset(&game->occupancy);
+    board_occupy(&game->occupancy, game->cells[0]);
+    snake_game_place_food(game);
+}
+
+struct Snake_Game snake_game_create(int width, int height, uint64_t seed, uint64_t stream) {
+    assert(width > 0 && height > 0 && (uint64_t) width * (uint64_t) height < SNAKE_NO_FOOD && "Board size out of range");
+
+    struct Snake_Game game = { };
+    game.width      = width;
+    game.height     = height;
+    game.cell_count = (uint32_t) width * (uint32_t) height;
+    game.random     = random_create(seed, stream);
+    game.cells      = (uint32_t *) calloc(game.cell_count, sizeof(uint32_t));
+    game.occupancy  = board_occupancy_create(game.cell_count);
+    assert(game.cells && "Failed to allocate snake");
+
+    snake_game_reset(&game);
+    return game;
+}
+
+void snake_game_destroy(struct Snake_Game *game) {
+    free(game->cells);
+    board_occupancy_destroy(&game->occupancy);
+    *game = { };
+}
+
+// Grows the snake by one link over the next turn, on top of whatever food already queued
+void snake_game_extend(struct Snake_Game *game) {
+    game->growth += 1;
+}
+
+// Turning back into the body is ignored, like the keyboard always did
+void snake_game_turn(struct Snake_Game *game, enum Snake_Action action) {
+    switch (action) {
+    case SNAKE_ACTION_UP:    { if (game->direction != DIRECTION_DOWN)  game->direction = DIRECTION_UP;    } break;
+    case SNAKE_ACTION_DOWN:  { if (game->direction != DIRECTION_UP)    game->direction = DIRECTION_DOWN;  } break;
+    case SNAKE_ACTION_LEFT:  { if (game->direction != DIRECTION_RIGHT) game->direction = DIRECTION_LEFT;  } break;
+    case SNAKE_ACTION_RIGHT: { if (game->direction != DIRECTION_LEFT)  game->direction = DIRECTION_RIGHT; } break;
+    case SNAKE_ACTION_NONE:
+    case SNAKE_ACTION_COUNT: break;
+    }
+}
+
+// One turn: apply `action`, move, then eat or die. Returns `Snake_Step_Flags`.
+// A dead game stays dead until `snake_game_reset`.
+uint32_t snake_step(struct Snake_Game *game, enum Snake_Action action) {
+    if (game->is_dead) return SNAKE_STEP_DIED;
+
+    snake_game_turn(game, action);
+
+    struct Vector2_Int head = snake_game_position(game, snake_game_link(game, 0));
+    switch (game->direction) {
+    case DIRECTION_UP:    { head.y -= 1; } break;
+    case DIRECTION_DOWN:  { head.y += 1; } break;
+    case DIRECTION_LEFT:  { head.x -= 1; } break;
+    case DIRECTION_RIGHT: { head.x += 1; } break;
+    }
+
+    if (head.x < 0) head.x = game->width  - 1;
+    if (head.y < 0) head.y = game->height - 1;
+    if (head.x == game->width)  head.x = 0;
+    if (head.y == game->height) head.y = 0;
+    uint32_t head_cell = snake_game_cell(game, head);
+
+    // Read before the push, on a full board the new head takes the old tail's slot
+    uint32_t tail_cell = snake_game_link(game, game->length - 1);
+
+    // Every other link moves up into the cell in front of it by the head taking a new slot
+    game->head = (game->head == 0 ? game->cell_count : game->head) - 1;
+    game->cells[game->head] = head_cell;
+    game->turn += 1;
+
+    // The tail that just fell off the end is still in the buffer right behind the body, so
+    // growing only has to count it again
+    if (game->growth > 0 && game->length < game->cell_count) {
+        game->growth -= 1;
+        game->length += 1;
+    } else {
+        board_vacate(&game->occupancy, tail_cell);
+    }
+
+    // The tail has already moved out of the way, so the head can follow right behind it
+    if (board_is_occupied(&game->occupancy, head_cell)) {
+        game->is_dead = true;
+        return SNAKE_STEP_DIED;
+    }
+    board_occupy(&game->occupancy, head_cell);
+
+    if (head_cell != game->food) return 0;
+
+    // Grows over the next turn, and the new food can't land on the head
+    game->growth += 1;
+    snake_game_place_food(game);
+    return SNAKE_STEP_ATE;
+}
+
+// Many independent games stepped together, for bots and fuzzing. Game i uses stream i of the
+// batch seed. Games that die are reset on the spot, so every step steps every game.
+struct Snake_Batch {
+    size_t count;
+    struct Snake_Game *games;
+
+    // Per game, finished games and food eaten since the batch was created
+    uint32_t *episode_counts;
+    uint32_t *food_counts;
+};
+
+// Games per job, each game's state is a few KB on a small board so this stays cache friendly
+const size_t SNAKE_BATCH_CHUNK_SIZE = 256;
+
+struct Snake_Batch snake_batch_create(size_t count, int width, int height, uint64_t seed) {
+    struct Snake_Batch batch = { };
+    batch.count          = count;
+    batch.games          = (struct Snake_Game *) calloc(count, sizeof(struct Snake_Game));
+    batch.episode_counts = (uint32_t *) calloc(count, sizeof(uint32_t));
+    batch.food_counts    = (uint32_t *) calloc(count, sizeof(uint32_t));
+    assert(batch.games && batch.episode_counts && batch.food_counts && "Failed to allocate snake batch");
+
+    for (size_t i = 0; i < count; ++i) batch.games[i] = snake_game_create(width, height, seed, i);
+    return batch;
+}
+
+void snake_batch_destroy(struct Snake_Batch *batch) {
+    for (size_t i = 0; i < batch->count; ++i) snake_game_destroy(&batch->games[i]);
+    free(batch->games);
+    free(batch->episode_counts);
+    free(batch->food_counts);
+    *batch = { };
+}
+
+// Steps games [begin, end), `actions` and `results` are indexed by game
+void snake_batch_step_range(struct Snake_Batch *batch, const uint8_t *actions, uint8_t *results, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        struct Snake_Game *game = &batch->games[i];
+        uint32_t flags = snake_step(game, (enum Snake_Action) actions[i]);
+
+        batch->food_counts[i] += (flags & SNAKE_STEP_ATE) ? 1 : 0;
+        if (flags & SNAKE_STEP_DIED) {
+            batch->episode_counts[i] += 1;
+            snake_game_reset(game);
+        }
+        if (results) results[i] = (uint8_t) flags;
+    }
+}
+
+struct Snake_Batch_Job {
+    struct Snake_Batch *batch;
+    const uint8_t *actions;
+    uint8_t *results;
+};
+
+void snake_batch_step_job(void *user_data, size_t chunk) {
+    struct Snake_Batch_Job *job = (struct Snake_Batch_Job *) user_data;
+    size_t begin = chunk * SNAKE_BATCH_CHUNK_SIZE;
+    size_t end   = begin + SNAKE_BATCH_CHUNK_SIZE < job->batch->count ? begin + SNAKE_BATCH_CHUNK_SIZE : job->batch->count;
+    snake_batch_step_range(job->batch, job->actions, job->results, begin, end);
+}
+
+// One step of every game on `pool`. `results` can be NULL.
+void snake_batch_step(struct Snake_Batch *batch, const uint8_t *actions, uint8_t *results, struct Thread_Pool *pool) {
+    struct Snake_Batch_Job job = { };
+    job.batch   = batch;
+    job.actions = actions;
+    job.results = results;
+
+    size_t chunk_count = (batch->count + SNAKE_BATCH_CHUNK_SIZE - 1) / SNAKE_BATCH_CHUNK_SIZE;
+    thread_pool_run(pool, chunk_count, &snake_batch_step_job, &job);
+}
+
+#endif // E_SNAKE_SIMULATION_H
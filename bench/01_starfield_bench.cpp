@@ -0,0 +1,115 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "bench/bench.h"
+#include "common/thread_pool.h"
+#include "01_starfield_simulation.h"
+#include "01_starfield_batch.h"
+
+// Headless benchmark for the starfield simulation kernel.
+// Usage: bench_01_starfield [star_count] [steps] [max_threads]
+
+const float    BENCH_CANVAS_WIDTH  = 800;
+const float    BENCH_CANVAS_HEIGHT = 600;
+const float    BENCH_DELTA_TIME    = 1.f / 60.f;
+const uint64_t BENCH_SEED          = 1234;
+
+typedef void (*Step_Function)(struct Stars *, size_t, size_t, float, struct Random *);
+
+double bench_stars_kernel(const char *name, Step_Function step, size_t star_count, int steps) {
+    struct Stars stars = stars_create(star_count, BENCH_CANVAS_WIDTH, BENCH_CANVAS_HEIGHT, BENCH_SEED);
+    struct Random random = random_create(BENCH_SEED, 0);
+
+    // Warm the caches and the branch predictor before timing
+    step(&stars, 0, stars.count, BENCH_DELTA_TIME, &random);
+
+    double start = bench_now_seconds();
+    for (int i = 0; i < steps; ++i) {
+        step(&stars, 0, stars.count, BENCH_DELTA_TIME, &random);
+    }
+    double elapsed = bench_now_seconds() - start;
+
+    double checksum = 0;
+    for (size_t i = 0; i < stars.count; ++i) checksum += stars.z[i];
+
+    double ns_per_star = elapsed * 1e9 / ((double) star_count * steps);
+    printf("%-8s %10zu stars  %4d steps  %8.3f ns/star/step  (checksum %.1f)\n", name, star_count, steps, ns_per_star, checksum);
+
+    stars_destroy(&stars);
+    return ns_per_star;
+}
+
+double bench_stars_parallel(size_t thread_count, size_t star_count, int steps, double *checksum) {
+    struct Thread_Pool *pool = thread_pool_create(thread_count);
+    struct Stars stars = stars_create(star_count, BENCH_CANVAS_WIDTH, BENCH_CANVAS_HEIGHT, BENCH_SEED);
+
+    double start = bench_now_seconds();
+    for (int i = 0; i < steps; ++i) {
+        stars_step_parallel(&stars, pool, BENCH_DELTA_TIME);
+    }
+    double elapsed = bench_now_seconds() - start;
+
+    *checksum = 0;
+    for (size_t i = 0; i < stars.count; ++i) *checksum += stars.x[i] + stars.y[i] + stars.z[i];
+
+    stars_destroy(&stars);
+    thread_pool_destroy(pool);
+    return elapsed * 1e9 / ((double) star_count * steps);
+}
+
+// Builds the frame geometry for `star_count` stars, after a few steps so the trails have length
+void bench_stars_batch(size_t star_count, int frames) {
+    struct Stars stars = stars_create(star_count, BENCH_CANVAS_WIDTH, BENCH_CANVAS_HEIGHT, BENCH_SEED);
+    struct Star_Batch batch = star_batch_create();
+    for (int i = 0; i < 10; ++i) stars_step(&stars, BENCH_DELTA_TIME);
+
+    double elapsed = 0;
+    for (int i = 0; i < frames; ++i) {
+        double start = bench_now_seconds();
+        star_batch_build(&batch, &stars, BENCH_CANVAS_WIDTH, BENCH_CANVAS_HEIGHT);
+        elapsed += bench_now_seconds() - start;
+
+        stars_step(&stars, BENCH_DELTA_TIME);
+    }
+
+    printf("batch  %8zu stars  %6zu trails  %6zu circles  %8zu vertices  %8zu indices  %9zu bytes/frame  %8.1f us/frame\n",
+        star_count, batch.trail_count, batch.circle_count, batch.vertex_count, batch.index_count,
+        star_batch_bytes_written(&batch), elapsed * 1e6 / frames);
+
+    star_batch_destroy(&batch);
+    stars_destroy(&stars);
+}
+
+int main(int argc, char **argv) {
+    size_t star_count  = argc > 1 ? (size_t) strtoull(argv[1], NULL, 10) : 1 << 20;
+    int    steps       = argc > 2 ? atoi(argv[2]) : 100;
+    size_t max_threads = argc > 3 ? (size_t) strtoull(argv[3], NULL, 10) : 16;
+
+    printf("STARS_LANES = %d, hardware threads = %zu\n", STARS_LANES, thread_pool_default_thread_count());
+    double scalar = bench_stars_kernel("scalar", &stars_step_scalar, star_count, steps);
+    double simd   = bench_stars_kernel("simd",   &stars_step_range,  star_count, steps);
+    printf("speedup  %.2fx\n\n", scalar / simd);
+
+    // The checksum must not change with the thread count, chunks own their random streams
+    double single_thread = 0;
+    double single_checksum = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        double checksum = 0;
+        double ns_per_star = bench_stars_parallel(threads, star_count, steps, &checksum);
+        if (threads == 1) {
+            single_thread = ns_per_star;
+            single_checksum = checksum;
+        }
+
+        printf("threads %2zu  %8.3f ns/star/step  %8.1f Mstars/s  scaling %5.2fx  %s\n",
+            threads, ns_per_star, 1e3 / ns_per_star, single_thread / ns_per_star,
+            checksum == single_checksum ? "deterministic" : "MISMATCH");
+    }
+
+    printf("\n");
+    bench_stars_batch(600, 600);
+    bench_stars_batch(64 * 1024, 20);
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "bench/bench.h"
+#include "common/thread_pool.h"
+#include "02_menger_sponge_cache.h"
+#include "02_menger_sponge_cubes.h"
+#include "02_menger_sponge_lod.h"
+#include "02_menger_sponge_mesh.h"
+
+// Headless benchmark for Menger subdivision, reports output cubes per second for each level,
+// then how long meshing takes and how many triangles culling and merging save, and how many
+// triangles level of detail selection keeps from a few camera distances, and how long the level
+// takes to write to and map back from its cache file.
+// Usage: bench_02_menger_sponge [max_level] [threads]
+
+typedef void (*Subdivide_Range_Function)(const struct Cube_Array *, struct Cube_Array *, size_t, size_t);
+
+// The pre-table approach: a runtime triple loop appending one child at a time through cube_create
+void subdivide_range_append(const struct Cube_Array *source, struct Cube_Array *destination, size_t begin, size_t end) {
+    destination->count = begin * CUBES_PER_SUBDIVISION;
+    for (size_t i = begin; i < end; ++i) {
+        struct Vector3_Int parent = morton_decode(source->cubes[i]);
+        for (int x = -1; x < 2; ++x) {
+            for (int y = -1; y < 2; ++y) {
+                for (int z = -1; z < 2; ++z) {
+                    int sum = abs(x) + abs(y) + abs(z);
+                    if (sum <= 1) continue;
+                    cube_create(destination, { parent.x * 3 + (x + 1), parent.y * 3 + (y + 1), parent.z * 3 + (z + 1) });
+                }
+            }
+        }
+    }
+}
+
+double bench_serial(Subdivide_Range_Function subdivide, const struct Cube_Array *source, struct Cube_Array *destination) {
+    cubes_reserve(destination, source->level + 1, source->count * CUBES_PER_SUBDIVISION);
+
+    // Untimed pass so page faults in freshly committed arena memory don't count
+    subdivide(source, destination, 0, source->count);
+
+    double start = bench_now_seconds();
+    subdivide(source, destination, 0, source->count);
+    double elapsed = bench_now_seconds() - start;
+    destination->count = destination->capacity;
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    int    max_level = argc > 1 ? atoi(argv[1]) : MENGER_MAX_LEVEL;
+    size_t threads   = argc > 2 ? (size_t) strtoull(argv[2], NULL, 10) : thread_pool_default_thread_count();
+    if (max_level > MENGER_MAX_LEVEL) max_level = MENGER_MAX_LEVEL;
+
+    struct Thread_Pool *pool = thread_pool_create(threads);
+
+    struct Cube_Array parents   = cubes_create(MENGER_MAX_LEVEL);
+    struct Cube_Array children  = cubes_create(MENGER_MAX_LEVEL);
+    struct Cube_Array reference = cubes_create(MENGER_MAX_LEVEL);
+
+    cubes_reserve(&parents, 0, 1);
+    cube_create(&parents, { 0, 0, 0 });
+
+    printf("%zu threads, output cubes per second\n", threads);
+    for (int level = 1; level <= max_level; ++level) {
+        double append = bench_serial(&subdivide_range_append,       &parents, &reference);
+        double scalar = bench_serial(&cubes_subdivide_range_scalar, &parents, &reference);
+        double simd   = bench_serial(&cubes_subdivide_range,        &parents, &children);
+
+        double start = bench_now_seconds();
+        cubes_subdivide_parallel(&parents, &children, pool);
+        double parallel = bench_now_seconds() - start;
+
+        bool matches = memcmp(children.cubes, reference.cubes, children.count * sizeof(Cube_Code)) == 0;
+
+        double cubes = (double) children.count;
+        if (level >= 3) {
+            printf("level %d %9zu cubes  append %8.1f M/s  table %8.1f M/s  simd %8.1f M/s  parallel %8.1f M/s  %s\n",
+                level, children.count, cubes / append / 1e6, cubes / scalar / 1e6, cubes / simd / 1e6, cubes / parallel / 1e6,
+                matches ? "ok" : "MISMATCH");
+        }
+
+        if (level <= MENGER_MESH_MAX_LEVEL) {
+            double mesh_start = bench_now_seconds();
+            struct Sponge_Mesh mesh = sponge_mesh_build(&children, NULL);
+            double mesh_elapsed = bench_now_seconds() - mesh_start;
+
+            printf("level %d mesh  %10zu -> %9zu triangles (%5.1f%%)  %8.2f ms\n",
+                level, mesh.unculled_triangle_count, mesh.triangle_count,
+                100.0 * (double) mesh.triangle_count / (double) mesh.unculled_triangle_count, mesh_elapsed * 1e3);
+            sponge_mesh_destroy(&mesh);
+
+            double lod_start = bench_now_seconds();
+            struct Sponge_Lod lod = sponge_lod_build(&children, pool, NULL);
+            double lod_elapsed = bench_now_seconds() - lod_start;
+            printf("level %d lod   %zu chunks built in %.2f ms\n", level, lod.chunk_count, lod_elapsed * 1e3);
+
+            // The open includes the checksum, the one pass over the data before it gets uploaded
+            const char *cache_path = "bench_02_menger_sponge.cache";
+            double write_start = bench_now_seconds();
+            bool is_written = sponge_cache_write(cache_path, &children, &lod, pool);
+            double write_elapsed = bench_now_seconds() - write_start;
+
+            struct Sponge_Cache cache = { };
+            double open_start = bench_now_seconds();
+            bool is_opened = is_written && sponge_cache_open(cache_path, level, pool, &cache);
+            struct Sponge_Lod cached_lod = is_opened ? sponge_cache_lod(&cache) : (struct Sponge_Lod) { };
+            double open_elapsed = bench_now_seconds() - open_start;
+
+            if (is_opened) {
+                printf("level %d cache %8.1f MB  write %8.2f ms  open %6.2f ms\n",
+                    level, (double) cache.file.size / (1024.0 * 1024.0), write_elapsed * 1e3, open_elapsed * 1e3);
+            } else {
+                printf("level %d cache FAILED\n", level);
+            }
+            sponge_lod_destroy(&cached_lod);
+            sponge_cache_close(&cache);
+            remove(cache_path);
+
+            // Looking at the center along the diagonal like the scene's default camera, 800x600
+            const float distances[] = { 5, 17.3f, 50 };
+            for (float distance : distances) {
+                float offset = distance / sqrtf(3.f);
+                float position[3] = { offset, offset, offset };
+                float target[3]   = { 0, 0, 0 };
+                float up[3]       = { 0, 1, 0 };
+                struct Sponge_View view = sponge_view_create(position, target, up, 45.f, 800.f / 600.f, 600.f);
+
+                double select_start = bench_now_seconds();
+                sponge_lod_select(&lod, &view);
+                double select_elapsed = bench_now_seconds() - select_start;
+
+                printf("  distance %5.1f  %3zu chunks drawn  %9zu of %9zu triangles  select %6.1f us\n",
+                    distance, lod.draw_count, lod.drawn_triangle_count, lod.triangle_count, select_elapsed * 1e6);
+            }
+            sponge_lod_destroy(&lod);
+        }
+
+        struct Cube_Array swap = parents;
+        parents  = children;
+        children = swap;
+    }
+
+    cubes_destroy(&parents);
+    cubes_destroy(&children);
+    cubes_destroy(&reference);
+    thread_pool_destroy(pool);
+    return 0;
+}
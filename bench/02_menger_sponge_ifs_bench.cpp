@@ -0,0 +1,112 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "bench/bench.h"
+#include "common/thread_pool.h"
+#include "02_menger_sponge_cubes.h"
+
+// Headless benchmark for every subdivision rule, reports output cubes per second for each level
+// against a runtime triple loop that asks the keep predicate for every child.
+// Usage: bench_02_menger_ifs [max_cubes_millions] [threads]
+
+typedef bool (*Keep_Function)(int x, int y, int z);
+typedef void (*Subdivide_Range_Function)(const struct Cube_Array *, struct Cube_Array *, size_t, size_t);
+
+// The rule known only at runtime, one child at a time through cube_create
+template <typename Rule>
+void subdivide_range_runtime(const struct Cube_Array *source, struct Cube_Array *destination, size_t begin, size_t end, Keep_Function keep) {
+    const int n = Rule::SPLIT;
+    destination->count = begin * (size_t) Rule::CHILD_COUNT;
+    for (size_t i = begin; i < end; ++i) {
+        struct Vector3_Int parent = morton_decode(source->cubes[i]);
+        for (int z = 0; z < n; ++z) {
+            for (int y = 0; y < n; ++y) {
+                for (int x = 0; x < n; ++x) {
+                    if (!keep(x, y, z)) continue;
+                    cube_create(destination, { parent.x * n + x, parent.y * n + y, parent.z * n + z });
+                }
+            }
+        }
+    }
+}
+
+// Untimed pass first so page faults in freshly committed arena memory don't count
+template <typename Rule>
+double bench_runtime(Keep_Function keep, const struct Cube_Array *source, struct Cube_Array *destination) {
+    cubes_reserve(destination, source->level + 1, source->count * (size_t) Rule::CHILD_COUNT);
+    subdivide_range_runtime<Rule>(source, destination, 0, source->count, keep);
+
+    double start = bench_now_seconds();
+    subdivide_range_runtime<Rule>(source, destination, 0, source->count, keep);
+    return bench_now_seconds() - start;
+}
+
+template <typename Rule>
+double bench_serial(Subdivide_Range_Function subdivide, const struct Cube_Array *source, struct Cube_Array *destination) {
+    cubes_reserve(destination, source->level + 1, source->count * (size_t) Rule::CHILD_COUNT);
+    subdivide(source, destination, 0, source->count);
+
+    double start = bench_now_seconds();
+    subdivide(source, destination, 0, source->count);
+    double elapsed = bench_now_seconds() - start;
+    destination->count = destination->capacity;
+    return elapsed;
+}
+
+template <typename Rule>
+void bench_rule(const char *name, Keep_Function keep, size_t max_cubes, struct Thread_Pool *pool) {
+    int max_level = 0;
+    while (max_level < Rule::MAX_LEVEL && ifs_cube_count<Rule>(max_level + 1) <= max_cubes) max_level += 1;
+
+    printf("%s: %dx%dx%d keeping %d, levels 1 to %d\n", name, Rule::SPLIT, Rule::SPLIT, Rule::SPLIT, Rule::CHILD_COUNT, max_level);
+
+    struct Cube_Array parents   = ifs_cubes_create<Rule>(max_level);
+    struct Cube_Array children  = ifs_cubes_create<Rule>(max_level);
+    struct Cube_Array reference = ifs_cubes_create<Rule>(max_level);
+
+    cubes_reserve(&parents, 0, 1);
+    cube_create(&parents, { 0, 0, 0 });
+
+    for (int level = 1; level <= max_level; ++level) {
+        double runtime = bench_runtime<Rule>(keep, &parents, &reference);
+        double scalar  = bench_serial<Rule>(&ifs_subdivide_range_scalar<Rule>, &parents, &children);
+        bool matches   = memcmp(children.cubes, reference.cubes, children.count * sizeof(Cube_Code)) == 0;
+        double simd    = bench_serial<Rule>(&ifs_subdivide_range<Rule>, &parents, &children);
+        matches = matches && memcmp(children.cubes, reference.cubes, children.count * sizeof(Cube_Code)) == 0;
+
+        double start = bench_now_seconds();
+        ifs_subdivide_parallel<Rule>(&parents, &children, pool);
+        double parallel = bench_now_seconds() - start;
+        matches = matches && memcmp(children.cubes, reference.cubes, children.count * sizeof(Cube_Code)) == 0;
+
+        double cubes = (double) children.count;
+        printf("  level %2d %9zu cubes  runtime %8.1f M/s  unrolled %8.1f M/s  simd %8.1f M/s  parallel %8.1f M/s  %s\n",
+            level, children.count, cubes / runtime / 1e6, cubes / scalar / 1e6, cubes / simd / 1e6, cubes / parallel / 1e6,
+            matches ? "ok" : "MISMATCH");
+
+        struct Cube_Array swap = parents;
+        parents  = children;
+        children = swap;
+    }
+
+    cubes_destroy(&parents);
+    cubes_destroy(&children);
+    cubes_destroy(&reference);
+}
+
+int main(int argc, char **argv) {
+    size_t max_cubes = argc > 1 ? (size_t) strtoull(argv[1], NULL, 10) * 1000000 : 64000000;
+    size_t threads   = argc > 2 ? (size_t) strtoull(argv[2], NULL, 10) : thread_pool_default_thread_count();
+
+    struct Thread_Pool *pool = thread_pool_create(threads);
+    printf("%zu threads, output cubes per second, at most %zu cubes per level\n", threads, max_cubes);
+
+    bench_rule<Menger_Rule>("menger", &menger_keep, max_cubes, pool);
+    bench_rule<Mosely_Rule>("mosely", &mosely_keep, max_cubes, pool);
+    bench_rule<Jerusalem_Rule>("jerusalem", &jerusalem_keep, max_cubes, pool);
+    bench_rule<Sierpinski_Rule>("sierpinski", &sierpinski_keep, max_cubes, pool);
+
+    thread_pool_destroy(pool);
+    return 0;
+}
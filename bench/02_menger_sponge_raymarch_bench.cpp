@@ -0,0 +1,115 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "bench/bench.h"
+#include "common/thread_pool.h"
+#include "02_menger_sponge_cubes.h"
+#include "02_menger_sponge_mesh.h"
+#include "02_menger_sponge_raymarch.h"
+
+// Headless benchmark for the ray-marched sponge. Reports Mrays/s per depth, then renders levels
+// 1 to 5 both by ray marching and by tracing the cube list and counts the pixels that differ.
+// Usage: bench_02_menger_raymarch [width] [height] [threads] [ppm_prefix]
+// With a prefix, the level 5 images are written to <prefix>_sdf.ppm and <prefix>_cubes.ppm.
+
+const int BENCH_CHECK_MAX_LEVEL = 5;
+
+double bench_render(struct Raymarch_Image *image, const struct Sponge_View *view, int depth, bool is_scalar, struct Thread_Pool *pool) {
+    struct Raymarch_Job job = { };
+    job.image     = image;
+    job.view      = view;
+    job.depth     = depth;
+    job.is_scalar = is_scalar;
+    double start = bench_now_seconds();
+    raymarch_run(&job, pool);
+    return bench_now_seconds() - start;
+}
+
+// Pixels that are sponge in one image and background in the other, and pixels with any difference
+void bench_compare(const struct Raymarch_Image *a, const struct Raymarch_Image *b, size_t *coverage, size_t *color) {
+    *coverage = 0;
+    *color    = 0;
+    for (size_t i = 0; i < (size_t) a->width * (size_t) a->height; ++i) {
+        const uint8_t *pa = &a->pixels[i * 4], *pb = &b->pixels[i * 4];
+        bool a_hit = pa[0] | pa[1] | pa[2];
+        bool b_hit = pb[0] | pb[1] | pb[2];
+        if (a_hit != b_hit) *coverage += 1;
+        if (memcmp(pa, pb, 4) != 0) *color += 1;
+    }
+}
+
+int main(int argc, char **argv) {
+    int    width   = argc > 1 ? atoi(argv[1]) : 800;
+    int    height  = argc > 2 ? atoi(argv[2]) : 600;
+    size_t threads = argc > 3 ? (size_t) strtoull(argv[3], NULL, 10) : thread_pool_default_thread_count();
+    const char *ppm_prefix = argc > 4 ? argv[4] : NULL;
+
+    struct Thread_Pool *pool = thread_pool_create(threads);
+
+    // The scene's default camera position, with a level horizon
+    float position[3] = { 10, 10, 10 };
+    float target[3]   = { 0, 0, 0 };
+    float up[3]       = { 0, 1, 0 };
+    struct Sponge_View view = sponge_view_create(position, target, up, 45.f, (float) width / (float) height, (float) height);
+
+    struct Raymarch_Image sdf   = raymarch_image_create(width, height);
+    struct Raymarch_Image cubes = raymarch_image_create(width, height);
+    double rays = (double) width * (double) height;
+
+    printf("%dx%d, %zu threads, %d lanes\n", width, height, threads, RAYMARCH_LANES);
+    for (int depth = 1; depth <= RAYMARCH_MAX_DEPTH; ++depth) {
+        double packets = bench_render(&sdf, &view, depth, false, pool);
+        if (depth == 1 || depth == 5 || depth == RAYMARCH_MAX_DEPTH) {
+            double scalar = bench_render(&cubes, &view, depth, true, pool);
+            size_t coverage, color;
+            bench_compare(&sdf, &cubes, &coverage, &color);
+            printf("depth %2d  packets %7.2f Mrays/s  scalar %7.2f Mrays/s  (%zu pixels differ)\n",
+                depth, rays / packets / 1e6, rays / scalar / 1e6, color);
+        } else {
+            printf("depth %2d  packets %7.2f Mrays/s\n", depth, rays / packets / 1e6);
+        }
+    }
+
+    printf("against the cube list\n");
+    struct Cube_Array parents  = cubes_create(BENCH_CHECK_MAX_LEVEL);
+    struct Cube_Array children = cubes_create(BENCH_CHECK_MAX_LEVEL);
+    cubes_reserve(&parents, 0, 1);
+    cube_create(&parents, { 0, 0, 0 });
+
+    for (int level = 0; level <= BENCH_CHECK_MAX_LEVEL; ++level) {
+        if (level > 0) {
+            cubes_subdivide_parallel(&parents, &children, pool);
+            struct Cube_Array swap = parents;
+            parents  = children;
+            children = swap;
+        }
+
+        struct Cube_Occupancy occupancy = cube_occupancy_create(&parents, level);
+        double start = bench_now_seconds();
+        raymarch_render_cubes(&cubes, &view, &occupancy, pool);
+        double traced = bench_now_seconds() - start;
+        bench_render(&sdf, &view, level, false, pool);
+
+        size_t coverage, color;
+        bench_compare(&sdf, &cubes, &coverage, &color);
+        printf("level %d  lattice %7.2f Mrays/s  coverage differs %6zu px (%.3f%%)  shading differs %6zu px (%.3f%%)\n",
+            level, rays / traced / 1e6, coverage, 100.0 * (double) coverage / rays, color, 100.0 * (double) color / rays);
+        cube_occupancy_destroy(&occupancy);
+    }
+
+    if (ppm_prefix) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s_sdf.ppm", ppm_prefix);
+        if (!raymarch_image_write_ppm(&sdf, path)) fprintf(stderr, "Failed to write %s\n", path);
+        snprintf(path, sizeof(path), "%s_cubes.ppm", ppm_prefix);
+        if (!raymarch_image_write_ppm(&cubes, path)) fprintf(stderr, "Failed to write %s\n", path);
+    }
+
+    cubes_destroy(&parents);
+    cubes_destroy(&children);
+    raymarch_image_destroy(&sdf);
+    raymarch_image_destroy(&cubes);
+    thread_pool_destroy(pool);
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "bench/bench.h"
+#include "common/thread_pool.h"
+#include "03_snake_arena.h"
+
+// Headless benchmark for the snake arena, reports snake ticks per second as the snake count
+// grows by 10x from 1 up to `max_snakes`. The board grows with the snakes so they stay about as
+// crowded, and every arena is played on one thread and on the pool to check that both play the
+// same game.
+// Usage: bench_03_snake_arena [max_snakes] [snake_ticks] [threads]
+
+const uint64_t BENCH_SEED = 1234;
+
+// Board cells per snake, and the fewest ticks any count is run for
+const size_t BENCH_CELLS_PER_SNAKE = 64;
+const size_t BENCH_MIN_TICKS       = 50;
+
+uint64_t bench_arena_checksum(const struct Snake_Arena *arena) {
+    uint64_t checksum = arena->death_count * 7 + arena->food_eaten * 3 + arena->alive_count;
+    for (uint32_t cell = 0; cell < arena->cell_count; ++cell) checksum = checksum * 31 + arena->cells[cell];
+    return checksum;
+}
+
+struct Bench_Arena_Result {
+    double   think_seconds;
+    double   commit_seconds;
+    uint64_t checksum;
+    uint64_t deaths;
+    uint64_t food;
+};
+
+struct Bench_Arena_Result bench_arena(size_t snake_count, int side, size_t ticks, struct Thread_Pool *pool) {
+    struct Snake_Arena arena = snake_arena_create(snake_count, side, side, (uint32_t) snake_count, BENCH_SEED);
+    struct Bench_Arena_Result result = { };
+
+    // Same as `snake_arena_step`, split up to time the two phases
+    struct Snake_Arena_Job job = { };
+    job.arena = &arena;
+    size_t chunk_count = (snake_count + SNAKE_ARENA_CHUNK_SIZE - 1) / SNAKE_ARENA_CHUNK_SIZE;
+
+    for (size_t i = 0; i < ticks; ++i) {
+        double start = bench_now_seconds();
+        if (pool) thread_pool_run(pool, chunk_count, &snake_arena_think_job, &job);
+        else      snake_arena_think_range(&arena, 0, snake_count);
+        double thought = bench_now_seconds();
+        snake_arena_commit(&arena);
+        result.think_seconds  += thought - start;
+        result.commit_seconds += bench_now_seconds() - thought;
+    }
+
+    result.checksum = bench_arena_checksum(&arena);
+    result.deaths   = arena.death_count;
+    result.food     = arena.food_eaten;
+    snake_arena_destroy(&arena);
+    return result;
+}
+
+int main(int argc, char **argv) {
+    size_t max_snakes  = argc > 1 ? (size_t) strtoull(argv[1], NULL, 10) : 100000;
+    size_t snake_ticks = argc > 2 ? (size_t) strtoull(argv[2], NULL, 10) : 10000000;
+    size_t threads     = argc > 3 ? (size_t) strtoull(argv[3], NULL, 10) : thread_pool_default_thread_count();
+
+    printf("%zu cells per snake, %zu threads on the pool\n", BENCH_CELLS_PER_SNAKE, threads);
+    printf("%8s %11s %8s  %12s %12s  %7s %7s  %s\n", "snakes", "board", "ticks", "serial", "pool", "think", "commit", "");
+
+    struct Thread_Pool *pool = thread_pool_create(threads);
+    for (size_t snake_count = 1; snake_count <= max_snakes; snake_count *= 10) {
+        int side = (int) ceil(sqrt((double) (snake_count * BENCH_CELLS_PER_SNAKE)));
+        if (side < 16) side = 16;
+        size_t ticks = snake_ticks / snake_count > BENCH_MIN_TICKS ? snake_ticks / snake_count : BENCH_MIN_TICKS;
+
+        struct Bench_Arena_Result serial = bench_arena(snake_count, side, ticks, NULL);
+        struct Bench_Arena_Result pooled = bench_arena(snake_count, side, ticks, pool);
+
+        char board[32];
+        snprintf(board, sizeof(board), "%dx%d", side, side);
+
+        double total = (double) (snake_count * ticks);
+        double pooled_seconds = pooled.think_seconds + pooled.commit_seconds;
+        printf("%8zu %11s %8zu  %7.2f Mst/s %7.2f Mst/s  %6.1f%% %6.1f%%  %s (%llu deaths, %llu food)\n",
+            snake_count, board, ticks,
+            total / (serial.think_seconds + serial.commit_seconds) / 1e6, total / pooled_seconds / 1e6,
+            100 * pooled.think_seconds / pooled_seconds, 100 * pooled.commit_seconds / pooled_seconds,
+            serial.checksum == pooled.checksum ? "deterministic" : "MISMATCH",
+            (unsigned long long) pooled.deaths, (unsigned long long) pooled.food);
+    }
+    thread_pool_destroy(pool);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "bench/bench.h"
+#include "03_snake_simulation.h"
+#include "03_snake_autopilot.h"
+
+// Headless benchmark for the snake autopilot. Plays one game per board size with only the
+// autopilot steering, and reports turns per second, the mean and worst time to decide a turn,
+// how much searching it took, and how the game went. Deaths should stay at 0 on boards with an
+// even side.
+// Usage: bench_03_snake_autopilot [turns] [largest_side]
+
+const uint64_t BENCH_SEED = 1234;
+
+void bench_autopilot(int width, int height, uint64_t turns) {
+    struct Snake_Game      game      = snake_game_create(width, height, BENCH_SEED, 0);
+    struct Snake_Autopilot autopilot = snake_autopilot_create(width, height);
+
+    uint64_t deaths = 0, food = 0;
+    uint32_t longest = 0;
+    double decide_seconds = 0, worst_seconds = 0;
+
+    double start = bench_now_seconds();
+    for (uint64_t turn = 0; turn < turns; ++turn) {
+        double before = bench_now_seconds();
+        enum Snake_Action action = snake_autopilot_decide(&autopilot, &game);
+        double took = bench_now_seconds() - before;
+        decide_seconds += took;
+        if (took > worst_seconds) worst_seconds = took;
+
+        uint32_t flags = snake_step(&game, action);
+        if (game.length > longest) longest = game.length;
+        if (flags & SNAKE_STEP_ATE) food += 1;
+        if (flags & SNAKE_STEP_DIED) {
+            deaths += 1;
+            snake_game_reset(&game);
+        }
+    }
+    double elapsed = bench_now_seconds() - start;
+
+    char board[32];
+    snprintf(board, sizeof(board), "%dx%d", width, height);
+    printf("%11s  %8.0f turns/s  %8.1f ns mean  %8.1f us worst  %7llu searches %8.1f exp/search  %6llu food  longest %8u  deaths %llu\n",
+        board, (double) turns / elapsed, decide_seconds * 1e9 / (double) turns, worst_seconds * 1e6,
+        (unsigned long long) autopilot.search_count,
+        autopilot.search_count ? (double) autopilot.expansion_count / (double) autopilot.search_count : 0.0,
+        (unsigned long long) food, longest, (unsigned long long) deaths);
+
+    snake_autopilot_destroy(&autopilot);
+    snake_game_destroy(&game);
+}
+
+int main(int argc, char **argv) {
+    uint64_t turns        = argc > 1 ? strtoull(argv[1], NULL, 10) : 200000;
+    int      largest_side = argc > 2 ? atoi(argv[2]) : 4096;
+
+    printf("%llu turns per board\n", (unsigned long long) turns);
+    bench_autopilot(40, 30, turns);
+    for (int side = 256; side <= largest_side; side *= 4) bench_autopilot(side, side, turns);
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "bench/bench.h"
+#include "common/thread_pool.h"
+#include "03_snake_simulation.h"
+#include "03_snake_lanes.h"
+
+// Headless benchmark for the snake rules, reports game steps per second for one game, for a
+// batch on one thread, for the batch spread over the thread pool, and for the lockstep lanes
+// against their own scalar loop.
+// Usage: bench_03_snake [game_count] [steps] [max_threads] [board_width] [board_height]
+
+const uint64_t BENCH_SEED = 1234;
+
+// Inputs are generated up front and cycled, so the timings are the rules and not the policy
+const size_t BENCH_ACTION_FRAMES = 64;
+
+// A random player that turns about once every eight turns
+uint8_t *bench_actions_create(size_t game_count) {
+    uint8_t *actions = (uint8_t *) malloc(BENCH_ACTION_FRAMES * game_count);
+    struct Random random = random_create(BENCH_SEED, 1);
+    for (size_t i = 0; i < BENCH_ACTION_FRAMES * game_count; ++i) {
+        uint32_t r = random_u32(&random);
+        actions[i] = (uint8_t) ((r & 7) < 4 ? (uint32_t) SNAKE_ACTION_UP + (r & 3) : (uint32_t) SNAKE_ACTION_NONE);
+    }
+    return actions;
+}
+
+uint64_t bench_batch_checksum(const struct Snake_Batch *batch) {
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < batch->count; ++i) {
+        const struct Snake_Game *game = &batch->games[i];
+        checksum = checksum * 31 + batch->episode_counts[i] * 7 + batch->food_counts[i] * 3 + game->length + snake_game_link(game, 0);
+    }
+    return checksum;
+}
+
+void bench_single_game(int width, int height, size_t steps, const uint8_t *actions) {
+    struct Snake_Game game = snake_game_create(width, height, BENCH_SEED, 0);
+    uint32_t episodes = 0;
+    uint32_t longest  = 0;
+
+    double start = bench_now_seconds();
+    for (size_t i = 0; i < steps; ++i) {
+        uint32_t flags = snake_step(&game, (enum Snake_Action) actions[i % BENCH_ACTION_FRAMES]);
+        if (game.length > longest) longest = game.length;
+        if (flags & SNAKE_STEP_DIED) {
+            episodes += 1;
+            snake_game_reset(&game);
+        }
+    }
+    double elapsed = bench_now_seconds() - start;
+
+    printf("single   %10zu steps  %8.2f ns/step  %8.2f Msteps/s  (%u games, longest %u)\n",
+        steps, elapsed * 1e9 / (double) steps, (double) steps / elapsed / 1e6, episodes, longest);
+    snake_game_destroy(&game);
+}
+
+double bench_batch(size_t game_count, int width, int height, size_t steps, const uint8_t *actions, struct Thread_Pool *pool, uint64_t *checksum) {
+    struct Snake_Batch batch = snake_batch_create(game_count, width, height, BENCH_SEED);
+    uint8_t *results = (uint8_t *) malloc(game_count);
+
+    double start = bench_now_seconds();
+    for (size_t i = 0; i < steps; ++i) {
+        const uint8_t *frame = actions + (i % BENCH_ACTION_FRAMES) * game_count;
+        if (pool) snake_batch_step(&batch, frame, results, pool);
+        else      snake_batch_step_range(&batch, frame, results, 0, game_count);
+    }
+    double elapsed = bench_now_seconds() - start;
+
+    *checksum = bench_batch_checksum(&batch);
+    free(results);
+    snake_batch_destroy(&batch);
+    return (double) (game_count * steps) / elapsed;
+}
+
+typedef void (*Lanes_Step_Function)(struct Snake_Lanes *, const uint8_t *, uint8_t *, size_t, size_t);
+
+double bench_lanes(const char *name, Lanes_Step_Function step, size_t game_count, int width, int height, size_t steps, const uint8_t *actions, struct Snake_Lanes *out) {
+    struct Snake_Lanes lanes = snake_lanes_create(game_count, width, height, BENCH_SEED);
+    uint8_t *results = (uint8_t *) malloc(game_count);
+
+    double start = bench_now_seconds();
+    for (size_t i = 0; i < steps; ++i) {
+        step(&lanes, actions + (i % BENCH_ACTION_FRAMES) * game_count, results, 0, game_count);
+    }
+    double elapsed = bench_now_seconds() - start;
+
+    uint64_t episodes = 0, food = 0;
+    for (size_t i = 0; i < game_count; ++i) {
+        episodes += lanes.episode_counts[i];
+        food     += lanes.food_counts[i];
+    }
+    double steps_per_second = (double) (game_count * steps) / elapsed;
+    printf("%-7s  %8.2f Msteps/s  (%llu games over, %llu food)\n", name, steps_per_second / 1e6,
+        (unsigned long long) episodes, (unsigned long long) food);
+
+    free(results);
+    *out = lanes;
+    return steps_per_second;
+}
+
+// Every lane width has to play exactly the games the scalar loop plays
+bool bench_lanes_match(const struct Snake_Lanes *a, const struct Snake_Lanes *b) {
+    size_t n = a->count;
+    return memcmp(a->head_x,    b->head_x,    n * sizeof(int32_t))  == 0 &&
+           memcmp(a->head_y,    b->head_y,    n * sizeof(int32_t))  == 0 &&
+           memcmp(a->direction, b->direction, n * sizeof(uint32_t)) == 0 &&
+           memcmp(a->head_slot, b->head_slot, n * sizeof(uint32_t)) == 0 &&
+           memcmp(a->length,    b->length,    n * sizeof(uint32_t)) == 0 &&
+           memcmp(a->growth,    b->growth,    n * sizeof(uint32_t)) == 0 &&
+           memcmp(a->food,      b->food,      n * sizeof(uint32_t)) == 0 &&
+           memcmp(a->rings,  b->rings,  n * a->cell_count  * sizeof(uint32_t)) == 0 &&
+           memcmp(a->boards, b->boards, n * a->board_words * sizeof(uint32_t)) == 0 &&
+           memcmp(a->episode_counts, b->episode_counts, n * sizeof(uint32_t)) == 0;
+}
+
+int main(int argc, char **argv) {
+    size_t game_count  = argc > 1 ? (size_t) strtoull(argv[1], NULL, 10) : 4096;
+    size_t steps       = argc > 2 ? (size_t) strtoull(argv[2], NULL, 10) : 1000;
+    size_t max_threads = argc > 3 ? (size_t) strtoull(argv[3], NULL, 10) : thread_pool_default_thread_count();
+    int    width       = argc > 4 ? atoi(argv[4]) : 40;
+    int    height      = argc > 5 ? atoi(argv[5]) : 30;
+
+    printf("%dx%d board, %zu games, %zu steps, hardware threads = %zu\n", width, height, game_count, steps, thread_pool_default_thread_count());
+
+    uint8_t *actions = bench_actions_create(game_count);
+    bench_single_game(width, height, game_count * steps, actions);
+
+    uint64_t serial_checksum = 0;
+    double serial = bench_batch(game_count, width, height, steps, actions, NULL, &serial_checksum);
+    printf("batch    %8.2f Msteps/s on the calling thread\n\n", serial / 1e6);
+
+    // Every game owns its random stream, so the checksum must not change with the thread count
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        struct Thread_Pool *pool = thread_pool_create(threads);
+        uint64_t checksum = 0;
+        double steps_per_second = bench_batch(game_count, width, height, steps, actions, pool, &checksum);
+        thread_pool_destroy(pool);
+
+        printf("threads %2zu  %8.2f Msteps/s  %8.2f Msteps/s/core  scaling %5.2fx  %s\n",
+            threads, steps_per_second / 1e6, steps_per_second / 1e6 / (double) threads, steps_per_second / serial,
+            checksum == serial_checksum ? "deterministic" : "MISMATCH");
+    }
+
+    printf("\nSNAKE_LANES = %d\n", SNAKE_LANES);
+    struct Snake_Lanes scalar_lanes = { };
+    struct Snake_Lanes simd_lanes   = { };
+    double scalar = bench_lanes("scalar", &snake_lanes_step_scalar, game_count, width, height, steps, actions, &scalar_lanes);
+    double simd   = bench_lanes("simd",   &snake_lanes_step_range,  game_count, width, height, steps, actions, &simd_lanes);
+    printf("speedup  %.2fx  %s\n", simd / scalar, bench_lanes_match(&scalar_lanes, &simd_lanes) ? "ok" : "MISMATCH");
+    snake_lanes_destroy(&scalar_lanes);
+    snake_lanes_destroy(&simd_lanes);
+
+    free(actions);
+    return 0;
+}
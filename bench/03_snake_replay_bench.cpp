@@ -0,0 +1,129 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "bench/bench.h"
+#include "03_snake_simulation.h"
+#include "03_snake_replay.h"
+
+// Headless benchmark for snake replays: recording cost and size, playback speed, and seeking.
+// Every replay is played back and checked against the game that was recorded.
+// Usage: bench_03_snake_replay [game_count] [turns_per_game] [seek_count]
+
+const uint64_t BENCH_SEED        = 1234;
+const int      BENCH_WIDTH       = 40;
+const int      BENCH_HEIGHT      = 30;
+const char    *BENCH_REPLAY_PATH = "bench_03_snake.replay";
+
+// Same state, as far as the rest of the game is concerned
+bool bench_games_equal(const struct Snake_Game *a, const struct Snake_Game *b, uint32_t *scratch_a, uint32_t *scratch_b) {
+    if (a->length != b->length || a->growth != b->growth || a->direction != b->direction || a->food != b->food ||
+        memcmp(&a->random, &b->random, sizeof(a->random)) != 0) {
+        return false;
+    }
+    snake_game_snapshot(a, scratch_a);
+    snake_game_snapshot(b, scratch_b);
+    return memcmp(scratch_a, scratch_b, a->cell_count * sizeof(uint32_t)) == 0;
+}
+
+// A random player that turns about once every eight turns and now and then cheats in a link.
+// Copies the game into `marked` right before turn `mark`.
+void bench_record(struct Snake_Replay *replay, struct Snake_Game *game, uint64_t turns, uint64_t mark, struct Snake_Game *marked, uint32_t *scratch) {
+    struct Random policy = random_create(BENCH_SEED, replay->stream + 1000000);
+    for (uint64_t turn = 0; turn < turns; ++turn) {
+        if (turn == mark) {
+            snake_game_snapshot(game, scratch);
+            snake_game_restore(marked, game, scratch);
+        }
+
+        uint32_t r = random_u32(&policy);
+        enum Snake_Action action = (r & 7) == 0 ? (enum Snake_Action) (SNAKE_ACTION_UP + ((r >> 3) & 3)) : SNAKE_ACTION_NONE;
+        uint32_t extend_count = ((r >> 8) & 255) == 0 ? 1 : 0;
+
+        snake_replay_record_turn(replay, action, extend_count);
+        for (uint32_t i = 0; i < extend_count; ++i) snake_game_extend(game);
+        if (snake_step(game, action) & SNAKE_STEP_DIED) snake_game_reset(game);
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t   game_count = argc > 1 ? (size_t) strtoull(argv[1], NULL, 10) : 64;
+    uint64_t turns      = argc > 2 ? strtoull(argv[2], NULL, 10) : 100000;
+    size_t   seek_count = argc > 3 ? (size_t) strtoull(argv[3], NULL, 10) : 1000;
+    uint64_t mark       = turns / 3;
+
+    struct Snake_Replay *replays = (struct Snake_Replay *) calloc(game_count, sizeof(struct Snake_Replay));
+    struct Snake_Game   *finals  = (struct Snake_Game *)   calloc(game_count, sizeof(struct Snake_Game));
+    struct Snake_Game   *marks   = (struct Snake_Game *)   calloc(game_count, sizeof(struct Snake_Game));
+    uint32_t *scratch_a = (uint32_t *) malloc((size_t) BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint32_t));
+    uint32_t *scratch_b = (uint32_t *) malloc((size_t) BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint32_t));
+
+    printf("%zu games of %llu turns on a %dx%d board\n", game_count, (unsigned long long) turns, BENCH_WIDTH, BENCH_HEIGHT);
+
+    size_t total_bytes = 0;
+    double start = bench_now_seconds();
+    for (size_t i = 0; i < game_count; ++i) {
+        replays[i] = snake_replay_create(BENCH_SEED, i, BENCH_WIDTH, BENCH_HEIGHT);
+        finals[i]  = snake_replay_game_create(&replays[i]);
+        marks[i]   = snake_replay_game_create(&replays[i]);
+        bench_record(&replays[i], &finals[i], turns, mark, &marks[i], scratch_a);
+        total_bytes += replays[i].size;
+    }
+    double record_seconds = bench_now_seconds() - start;
+    double total_turns = (double) game_count * (double) turns;
+
+    printf("record    %8.2f Mturns/s  %10zu bytes  %6.3f bytes/turn\n",
+        total_turns / record_seconds / 1e6, total_bytes, (double) total_bytes / total_turns);
+
+    // Round trip through a file before playing anything back
+    struct Snake_Replay loaded = { };
+    bool round_trip = snake_replay_save(&replays[0], BENCH_REPLAY_PATH) && snake_replay_load(BENCH_REPLAY_PATH, &loaded)
+                   && loaded.size == replays[0].size && loaded.tick_count == replays[0].tick_count
+                   && memcmp(loaded.bytes, replays[0].bytes, loaded.size) == 0;
+    remove(BENCH_REPLAY_PATH);
+    snake_replay_destroy(&loaded);
+    printf("file      %s\n", round_trip ? "ok" : "MISMATCH");
+
+    bool matches = true;
+    start = bench_now_seconds();
+    for (size_t i = 0; i < game_count; ++i) {
+        struct Snake_Replay_Player player = snake_replay_player_create(&replays[i]);
+        snake_replay_seek(&player, turns);
+        matches = matches && bench_games_equal(&player.game, &finals[i], scratch_a, scratch_b);
+        snake_replay_player_destroy(&player);
+    }
+    double play_seconds = bench_now_seconds() - start;
+    printf("playback  %8.2f Mturns/s, keyframes every %llu turns  %s\n",
+        total_turns / play_seconds / 1e6, (unsigned long long) SNAKE_REPLAY_KEYFRAME_INTERVAL, matches ? "ok" : "MISMATCH");
+
+    // Jumps anywhere in a replay that has been played through once, so every keyframe exists
+    struct Snake_Replay_Player player = snake_replay_player_create(&replays[0]);
+    snake_replay_seek(&player, turns);
+
+    struct Random random = random_create(BENCH_SEED, 1);
+    start = bench_now_seconds();
+    for (size_t i = 0; i < seek_count; ++i) {
+        snake_replay_seek(&player, random_bounded(&random, (uint32_t) turns));
+        bench_sink = bench_sink + player.game.length;
+    }
+    double seek_seconds = bench_now_seconds() - start;
+
+    snake_replay_seek(&player, mark);
+    bool seek_matches = bench_games_equal(&player.game, &marks[0], scratch_a, scratch_b);
+    snake_replay_seek(&player, turns);
+    seek_matches = seek_matches && bench_games_equal(&player.game, &finals[0], scratch_a, scratch_b);
+    printf("seek      %8.2f us/seek  %s\n", seek_seconds * 1e6 / (double) seek_count, seek_matches ? "ok" : "MISMATCH");
+    snake_replay_player_destroy(&player);
+
+    for (size_t i = 0; i < game_count; ++i) {
+        snake_replay_destroy(&replays[i]);
+        snake_game_destroy(&finals[i]);
+        snake_game_destroy(&marks[i]);
+    }
+    free(replays);
+    free(finals);
+    free(marks);
+    free(scratch_a);
+    free(scratch_b);
+    return 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#ifndef E_BENCH_H
+#define E_BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Shared helpers for the headless benchmarks in bench/. None of these link raylib.
+
+double bench_now_seconds(void) {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Keeps the optimizer from discarding results that are otherwise never read.
+volatile uint64_t bench_sink;
+
+#endif // E_BENCH_H
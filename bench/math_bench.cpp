@@ -0,0 +1,161 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "bench/bench.h"
+#include "common/math.h"
+#include "common/random.h"
+
+// Headless microbenchmarks and error checks for common/math.h.
+// Usage: bench_math [count] [repeats]
+
+const uint64_t BENCH_SEED = 1234;
+
+struct Bench_Buffers {
+    size_t count;
+    float *a, *b, *t, *out;
+};
+
+void bench_report(const char *name, double elapsed, size_t count, int repeats) {
+    printf("%-28s %7.3f ns/value\n", name, elapsed * 1e9 / ((double) count * repeats));
+}
+
+// Walks every 97th float bit pattern in [1e-30, 1e30] and returns the worst relative error
+double bench_max_relative_error(float (*approx)(float), double (*exact)(double)) {
+    uint32_t first, last;
+    float low = 1e-30f, high = 1e30f;
+    memcpy(&first, &low, sizeof(first));
+    memcpy(&last,  &high, sizeof(last));
+
+    double worst = 0;
+    for (uint32_t bits = first; bits < last; bits += 97) {
+        float v;
+        memcpy(&v, &bits, sizeof(v));
+        double expected = exact(v);
+        double error = fabs((double) approx(v) - expected) / expected;
+        if (error > worst) worst = error;
+    }
+    return worst;
+}
+
+double exact_rsqrt(double v)      { return 1.0 / sqrt(v); }
+double exact_reciprocal(double v) { return 1.0 / v; }
+
+int main(int argc, char **argv) {
+    size_t count   = argc > 1 ? (size_t) strtoull(argv[1], NULL, 10) : 4096;
+    int    repeats = argc > 2 ? atoi(argv[2]) : 20000;
+
+    // Small enough to stay in L1/L2 so the numbers show compute, not bandwidth
+    struct Bench_Buffers buffers = { };
+    buffers.count = count;
+    buffers.a   = (float *) malloc(count * sizeof(float));
+    buffers.b   = (float *) malloc(count * sizeof(float));
+    buffers.t   = (float *) malloc(count * sizeof(float));
+    buffers.out = (float *) malloc(count * sizeof(float));
+
+    struct Random random = random_create(BENCH_SEED, 0);
+    random_fill_float(&random, buffers.a, count, -400, 400);
+    random_fill_float(&random, buffers.b, count, 1, 400);
+    random_fill_float(&random, buffers.t, count, 0, 1);
+
+    double start, sum;
+
+    start = bench_now_seconds();
+    for (int r = 0; r < repeats; ++r) {
+        for (size_t i = 0; i < count; ++i) buffers.out[i] = lerp(buffers.a[i], buffers.b[i], buffers.t[i]);
+        bench_sink = (uint64_t) buffers.out[r % count];
+    }
+    bench_report("lerp scalar", bench_now_seconds() - start, count, repeats);
+
+    start = bench_now_seconds();
+    for (int r = 0; r < repeats; ++r) {
+        lerp(buffers.a, buffers.b, buffers.t, buffers.out, count);
+        bench_sink = (uint64_t) buffers.out[r % count];
+    }
+    bench_report("lerp array", bench_now_seconds() - start, count, repeats);
+
+    start = bench_now_seconds();
+    for (int r = 0; r < repeats; ++r) {
+        lerp(-5.f, 5.f, buffers.t, buffers.out, count);
+        bench_sink = (uint64_t) buffers.out[r % count];
+    }
+    bench_report("lerp array broadcast", bench_now_seconds() - start, count, repeats);
+
+    start = bench_now_seconds();
+    for (int r = 0; r < repeats; ++r) {
+        for (size_t i = 0; i < count; ++i) buffers.out[i] = inverse_lerp(-400, 400, buffers.a[i]);
+        bench_sink = (uint64_t) buffers.out[r % count];
+    }
+    bench_report("inverse_lerp scalar", bench_now_seconds() - start, count, repeats);
+
+    start = bench_now_seconds();
+    for (int r = 0; r < repeats; ++r) {
+        for (size_t i = 0; i < count; ++i) buffers.out[i] = remap(0, 1, 0, 800, buffers.t[i]);
+        bench_sink = (uint64_t) buffers.out[r % count];
+    }
+    bench_report("remap scalar", bench_now_seconds() - start, count, repeats);
+
+    start = bench_now_seconds();
+    for (int r = 0; r < repeats; ++r) {
+        remap(0, 1, 0, 800, buffers.t, buffers.out, count);
+        bench_sink = (uint64_t) buffers.out[r % count];
+    }
+    bench_report("remap array", bench_now_seconds() - start, count, repeats);
+
+    sum = 0;
+    start = bench_now_seconds();
+    for (int r = 0; r < repeats; ++r) {
+        for (size_t i = 0; i < count; ++i) sum += 1.f / sqrtf(buffers.b[i]);
+    }
+    bench_report("1 / sqrtf", bench_now_seconds() - start, count, repeats);
+    bench_sink = (uint64_t) sum;
+
+    sum = 0;
+    start = bench_now_seconds();
+    for (int r = 0; r < repeats; ++r) {
+        for (size_t i = 0; i < count; ++i) sum += fast_rsqrt(buffers.b[i]);
+    }
+    bench_report("fast_rsqrt", bench_now_seconds() - start, count, repeats);
+    bench_sink = (uint64_t) sum;
+
+    sum = 0;
+    start = bench_now_seconds();
+    for (int r = 0; r < repeats; ++r) {
+        for (size_t i = 0; i < count; ++i) sum += 1.f / buffers.b[i];
+    }
+    bench_report("1 / v", bench_now_seconds() - start, count, repeats);
+    bench_sink = (uint64_t) sum;
+
+    sum = 0;
+    start = bench_now_seconds();
+    for (int r = 0; r < repeats; ++r) {
+        for (size_t i = 0; i < count; ++i) sum += fast_reciprocal(buffers.b[i]);
+    }
+    bench_report("fast_reciprocal", bench_now_seconds() - start, count, repeats);
+    bench_sink = (uint64_t) sum;
+
+    start = bench_now_seconds();
+    for (int r = 0; r < repeats; ++r) {
+        for (size_t i = 0; i < count; ++i) buffers.out[i] = buffers.a[i] / buffers.b[i];
+        bench_sink = (uint64_t) buffers.out[r % count];
+    }
+    bench_report("a / b", bench_now_seconds() - start, count, repeats);
+
+    start = bench_now_seconds();
+    for (int r = 0; r < repeats; ++r) {
+        fast_divide(buffers.a, buffers.b, buffers.out, count);
+        bench_sink = (uint64_t) buffers.out[r % count];
+    }
+    bench_report("fast_divide array", bench_now_seconds() - start, count, repeats);
+
+    printf("\n");
+    printf("fast_rsqrt      max relative error %.3g\n", bench_max_relative_error(&fast_rsqrt,      &exact_rsqrt));
+    printf("fast_reciprocal max relative error %.3g\n", bench_max_relative_error(&fast_reciprocal, &exact_reciprocal));
+
+    free(buffers.a);
+    free(buffers.b);
+    free(buffers.t);
+    free(buffers.out);
+    return 0;
+}
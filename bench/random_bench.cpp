@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "bench/bench.h"
+#include "common/random.h"
+
+// Headless benchmark for common/random.h.
+// Usage: bench_random [count]
+
+const uint64_t BENCH_SEED = 1234;
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? (size_t) strtoull(argv[1], NULL, 10) : 1 << 24;
+
+    uint32_t *u32s   = (uint32_t *) malloc(count * sizeof(uint32_t));
+    float    *floats = (float *)    malloc(count * sizeof(float));
+
+    // Fault the pages in up front so the first fill isn't charged for them
+    memset(u32s,   0, count * sizeof(uint32_t));
+    memset(floats, 0, count * sizeof(float));
+
+    {
+        struct Random random = random_create(BENCH_SEED, 0);
+        uint64_t sum = 0;
+        double start = bench_now_seconds();
+        for (size_t i = 0; i < count; ++i) sum += random_u32(&random);
+        double elapsed = bench_now_seconds() - start;
+        bench_sink = sum;
+        printf("random_u32               %6.3f ns/value\n", elapsed * 1e9 / (double) count);
+    }
+
+    {
+        struct Random random = random_create(BENCH_SEED, 0);
+        uint64_t sum = 0;
+        double start = bench_now_seconds();
+        for (size_t i = 0; i < count; ++i) sum += (uint64_t) random_int_range(&random, 0, 39);
+        double elapsed = bench_now_seconds() - start;
+        bench_sink = sum;
+        printf("random_int_range         %6.3f ns/value\n", elapsed * 1e9 / (double) count);
+    }
+
+    {
+        struct Random random = random_create(BENCH_SEED, 0);
+        double start = bench_now_seconds();
+        random_fill_float(&random, floats, count, -400, 400);
+        double elapsed = bench_now_seconds() - start;
+        printf("random_fill_float        %6.3f ns/value\n", elapsed * 1e9 / (double) count);
+    }
+
+    {
+        struct Random_Lanes random = random_lanes_create(BENCH_SEED, 0);
+        double start = bench_now_seconds();
+        random_lanes_fill_u32(&random, u32s, count);
+        double elapsed = bench_now_seconds() - start;
+        printf("random_lanes_fill_u32    %6.3f ns/value\n", elapsed * 1e9 / (double) count);
+    }
+
+    {
+        struct Random_Lanes random = random_lanes_create(BENCH_SEED, 0);
+        double start = bench_now_seconds();
+        random_lanes_fill_float(&random, floats, count, -400, 400);
+        double elapsed = bench_now_seconds() - start;
+        printf("random_lanes_fill_float  %6.3f ns/value\n", elapsed * 1e9 / (double) count);
+    }
+
+    // Lane output does not depend on the instruction set, so this hash is the same on every build
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < count; ++i) hash = (hash ^ u32s[i]) * 1099511628211ull;
+    printf("lanes hash               %016llx\n", (unsigned long long) hash);
+
+    free(u32s);
+    free(floats);
+    return 0;
+}
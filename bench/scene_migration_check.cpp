@@ -0,0 +1,255 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/scene_migration.h"
+
+// Headless check for common/scene_migration.h. Runs layout matching, the field by field copy and
+// the order `scene_migrate` tries its paths in on made up scenes, no libraries are loaded.
+// Prints every failed check and exits with 1 if there was one.
+// Usage: check_scene_migration
+
+struct Data_V1 {
+    int   a;
+    float b;
+    char *c;
+};
+
+// `b` and `a` swapped, `d` added
+struct Data_V2 {
+    float  b;
+    int    a;
+    double d;
+    char  *c;
+};
+
+// `a` grew
+struct Data_V3 {
+    int64_t a;
+    float   b;
+    char   *c;
+};
+
+const struct Scene_Field DATA_V1_FIELDS[] = {
+    SCENE_FIELD(struct Data_V1, a),
+    SCENE_FIELD(struct Data_V1, b),
+    SCENE_FIELD(struct Data_V1, c),
+};
+
+const struct Scene_Field DATA_V2_FIELDS[] = {
+    SCENE_FIELD(struct Data_V2, b),
+    SCENE_FIELD(struct Data_V2, a),
+    SCENE_FIELD(struct Data_V2, d),
+    SCENE_FIELD(struct Data_V2, c),
+};
+
+const struct Scene_Field DATA_V3_FIELDS[] = {
+    SCENE_FIELD(struct Data_V3, a),
+    SCENE_FIELD(struct Data_V3, b),
+    SCENE_FIELD(struct Data_V3, c),
+};
+
+int check_failures = 0;
+
+void check(bool is_ok, const char *what) {
+    if (is_ok) return;
+    fprintf(stderr, "FAILED: %s\n", what);
+    check_failures += 1;
+}
+
+// Which hooks ran, reset before every `scene_migrate`
+int init_calls, destroy_calls, migrate_calls, serialize_calls, deserialize_calls;
+char check_text[] = "kept";
+
+void reset_calls(void) {
+    init_calls = destroy_calls = migrate_calls = serialize_calls = deserialize_calls = 0;
+}
+
+struct Data_V1 *data_v1_create(void) {
+    struct Data_V1 *data = (struct Data_V1 *) malloc(sizeof(struct Data_V1));
+    data->a = 7;
+    data->b = 2.5f;
+    data->c = check_text;
+    return data;
+}
+
+void *check_init(uint64_t seed) {
+    (void) seed;
+    init_calls += 1;
+    return calloc(1, sizeof(struct Data_V2));
+}
+
+void check_destroy(void *data) {
+    destroy_calls += 1;
+    free(data);
+}
+
+void *check_migrate(void *old_data, const struct Scene_Layout *old_layout) {
+    migrate_calls += 1;
+    struct Scene_Layout layout = SCENE_LAYOUT(struct Data_V2, 2, DATA_V2_FIELDS);
+    struct Data_V2 *data = (struct Data_V2 *) calloc(1, sizeof(struct Data_V2));
+    scene_migrate_fields(data, &layout, old_data, old_layout);
+    free(old_data);
+    return data;
+}
+
+void *check_serialize(void *data, size_t *size) {
+    serialize_calls += 1;
+    *size = sizeof(struct Data_V1);
+    return data;
+}
+
+void *check_deserialize(void *buffer, size_t size, const struct Scene_Layout *old_layout) {
+    (void) size;
+    deserialize_calls += 1;
+    return check_migrate(buffer, old_layout);
+}
+
+struct Scene_Functions check_functions(struct Scene_Layout layout) {
+    struct Scene_Functions functions = { };
+    functions.init    = &check_init;
+    functions.destroy = &check_destroy;
+    functions.layout  = layout;
+    return functions;
+}
+
+void check_layouts_match(void) {
+    struct Scene_Layout v1      = SCENE_LAYOUT(struct Data_V1, 1, DATA_V1_FIELDS);
+    struct Scene_Layout v1_copy = SCENE_LAYOUT(struct Data_V1, 1, DATA_V1_FIELDS);
+    struct Scene_Layout v1_next = SCENE_LAYOUT(struct Data_V1, 2, DATA_V1_FIELDS);
+    struct Scene_Layout v2      = SCENE_LAYOUT(struct Data_V2, 1, DATA_V2_FIELDS);
+    struct Scene_Layout unknown = { };
+
+    check(scene_layouts_match(&v1, &v1_copy),       "the same layout matches");
+    check(!scene_layouts_match(&v1, &v1_next),      "a new version doesn't match");
+    check(!scene_layouts_match(&v1, &v2),           "changed fields don't match");
+    check(!scene_layouts_match(&unknown, &unknown), "unknown layouts never match");
+    check(!scene_layouts_match(&v1, &unknown),      "an unknown layout doesn't match a known one");
+
+    // Same size and names, but `a` and `b` traded places
+    struct Scene_Field swapped[] = { DATA_V1_FIELDS[0], DATA_V1_FIELDS[1], DATA_V1_FIELDS[2] };
+    size_t offset = swapped[0].offset;
+    swapped[0].offset = swapped[1].offset;
+    swapped[1].offset = offset;
+    struct Scene_Layout v1_swapped = SCENE_LAYOUT(struct Data_V1, 1, swapped);
+    check(!scene_layouts_match(&v1, &v1_swapped), "moved fields don't match");
+}
+
+void check_migrate_fields(void) {
+    struct Scene_Layout v1 = SCENE_LAYOUT(struct Data_V1, 1, DATA_V1_FIELDS);
+    struct Scene_Layout v2 = SCENE_LAYOUT(struct Data_V2, 1, DATA_V2_FIELDS);
+    struct Scene_Layout v3 = SCENE_LAYOUT(struct Data_V3, 1, DATA_V3_FIELDS);
+    struct Data_V1 *old = data_v1_create();
+
+    struct Data_V2 moved = { };
+    scene_migrate_fields(&moved, &v2, old, &v1);
+    check(moved.a == 7 && moved.b == 2.5f && moved.c == check_text, "moved fields are copied");
+    check(moved.d == 0, "added fields stay zeroed");
+
+    struct Data_V3 grown = { };
+    scene_migrate_fields(&grown, &v3, old, &v1);
+    check(grown.a == 0, "resized fields are not copied");
+    check(grown.b == 2.5f && grown.c == check_text, "fields next to a resized one are copied");
+
+    free(old);
+}
+
+void check_migrate_order(void) {
+    struct Scene_Layout v1      = SCENE_LAYOUT(struct Data_V1, 1, DATA_V1_FIELDS);
+    struct Scene_Layout v2      = SCENE_LAYOUT(struct Data_V2, 1, DATA_V2_FIELDS);
+    struct Scene_Layout v2_next = SCENE_LAYOUT(struct Data_V2, 2, DATA_V2_FIELDS);
+    struct Scene_Layout unknown = { };
+    enum Scene_Migration migration;
+
+    {
+        struct Scene_Functions from = check_functions(v1);
+        struct Scene_Functions to   = check_functions(v1);
+        to.migrate     = &check_migrate;
+        from.serialize = &check_serialize;
+        to.deserialize = &check_deserialize;
+
+        reset_calls();
+        void *old  = data_v1_create();
+        void *data = scene_migrate(&from, &to, old, 1, &migration);
+        check(migration == SCENE_MIGRATION_KEPT && data == old, "the same layout keeps the data");
+        check(migrate_calls + serialize_calls + init_calls + destroy_calls == 0, "kept data runs no hooks");
+        free(data);
+    }
+
+    {
+        struct Scene_Functions from = check_functions(v1);
+        struct Scene_Functions to   = check_functions(v2_next);
+        to.migrate     = &check_migrate;
+        from.serialize = &check_serialize;
+        to.deserialize = &check_deserialize;
+
+        reset_calls();
+        struct Data_V2 *data = (struct Data_V2 *) scene_migrate(&from, &to, data_v1_create(), 1, &migration);
+        check(migration == SCENE_MIGRATION_SERIALIZED, "serializing comes before migrate");
+        check(serialize_calls == 1 && deserialize_calls == 1, "serialize and deserialize run once");
+        check(data->a == 7 && data->c == check_text, "deserialized data has the old fields");
+        free(data);
+    }
+
+    {
+        struct Scene_Functions from = check_functions(v1);
+        struct Scene_Functions to   = check_functions(v2_next);
+        to.migrate     = &check_migrate;
+        to.deserialize = &check_deserialize;
+
+        reset_calls();
+        struct Data_V2 *data = (struct Data_V2 *) scene_migrate(&from, &to, data_v1_create(), 1, &migration);
+        check(migration == SCENE_MIGRATION_MIGRATED, "migrate runs without serialize on the old side");
+        check(migrate_calls == 1 && deserialize_calls == 0 && init_calls == 0, "only migrate runs");
+        check(data->a == 7 && data->b == 2.5f, "migrated data has the old fields");
+        free(data);
+    }
+
+    {
+        struct Scene_Functions from = check_functions(v1);
+        struct Scene_Functions to   = check_functions(v2);
+
+        reset_calls();
+        struct Data_V2 *data = (struct Data_V2 *) scene_migrate(&from, &to, data_v1_create(), 1, &migration);
+        check(migration == SCENE_MIGRATION_FIELDS, "same version without hooks copies fields");
+        check(init_calls == 0 && destroy_calls == 0, "copying fields doesn't restart the scene");
+        check(data->a == 7 && data->b == 2.5f && data->d == 0 && data->c == check_text, "copied fields are in place");
+        free(data);
+    }
+
+    {
+        struct Scene_Functions from = check_functions(v1);
+        struct Scene_Functions to   = check_functions(v2_next);
+
+        reset_calls();
+        void *data = scene_migrate(&from, &to, data_v1_create(), 1, &migration);
+        check(migration == SCENE_MIGRATION_RESTARTED, "a new version without hooks restarts");
+        check(destroy_calls == 1 && init_calls == 1, "restarting destroys the old data and inits");
+        free(data);
+    }
+
+    {
+        struct Scene_Functions from = check_functions(unknown);
+        struct Scene_Functions to   = check_functions(v2);
+        to.migrate = &check_migrate;
+
+        reset_calls();
+        void *data = scene_migrate(&from, &to, data_v1_create(), 1, &migration);
+        check(migration == SCENE_MIGRATION_RESTARTED, "an unknown old layout restarts even with migrate");
+        check(migrate_calls == 0 && destroy_calls == 1 && init_calls == 1, "migrate doesn't run on an unknown layout");
+        free(data);
+    }
+}
+
+int main(void) {
+    check_layouts_match();
+    check_migrate_fields();
+    check_migrate_order();
+
+    if (check_failures > 0) {
+        printf("%d checks failed\n", check_failures);
+        return 1;
+    }
+    printf("All scene migration checks passed\n");
+    return 0;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#ifndef E_ARENA_H
+#define E_ARENA_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include "WinDef.h"
+#include "memoryapi.h"
+#else
+#include <sys/mman.h>
+#endif
+
+// Linear allocator over one reserved range of address space. Pages are committed as the arena
+// grows, so a big reservation costs nothing until it is used and pushes never move or copy
+// earlier allocations. `arena_reset` keeps the committed pages around for the next fill.
+
+struct Arena {
+    uint8_t *base;
+    size_t   reserved;
+    size_t   committed;
+    size_t   used;
+};
+
+const size_t ARENA_COMMIT_GRANULARITY = 64 * 1024;
+
+struct Arena arena_create(size_t reserve_size) {
+    struct Arena arena = { };
+    arena.reserved = (reserve_size + ARENA_COMMIT_GRANULARITY - 1) & ~(ARENA_COMMIT_GRANULARITY - 1);
+
+#if defined(_WIN32)
+    arena.base = (uint8_t *) VirtualAlloc(NULL, arena.reserved, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void *base = mmap(NULL, arena.reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    arena.base = base == MAP_FAILED ? NULL : (uint8_t *) base;
+#endif
+
+    assert(arena.base && "Failed to reserve arena");
+    return arena;
+}
+
+void arena_destroy(struct Arena *arena) {
+    if (arena->base) {
+#if defined(_WIN32)
+        VirtualFree(arena->base, 0, MEM_RELEASE);
+#else
+        munmap(arena->base, arena->reserved);
+#endif
+    }
+    *arena = { };
+}
+
+void arena_commit(struct Arena *arena, size_t size) {
+    if (size <= arena->committed) return;
+
+    size_t commit_end = (size + ARENA_COMMIT_GRANULARITY - 1) & ~(ARENA_COMMIT_GRANULARITY - 1);
+    if (commit_end > arena->reserved) commit_end = arena->reserved;
+
+#if defined(_WIN32)
+    void *committed = VirtualAlloc(arena->base + arena->committed, commit_end - arena->committed, MEM_COMMIT, PAGE_READWRITE);
+    assert(committed && "Failed to commit arena memory");
+#else
+    int result = mprotect(arena->base + arena->committed, commit_end - arena->committed, PROT_READ | PROT_WRITE);
+    assert(result == 0 && "Failed to commit arena memory");
+#endif
+
+    arena->committed = commit_end;
+}
+
+void *arena_push(struct Arena *arena, size_t size, size_t alignment) {
+    size_t offset = (arena->used + alignment - 1) & ~(alignment - 1);
+    assert(offset + size <= arena->reserved && "Arena out of reserved space");
+
+    arena_commit(arena, offset + size);
+    arena->used = offset + size;
+    return arena->base + offset;
+}
+
+#define ARENA_PUSH_ARRAY(arena, type, count) ((type *) arena_push((arena), sizeof(type) * (count), alignof(type)))
+
+void arena_reset(struct Arena *arena) {
+    arena->used = 0;
+}
+
+#endif // E_ARENA_H
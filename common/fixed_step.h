@@ -0,0 +1,152 @@
+#pragma once
+#ifndef E_FIXED_STEP_H
+#define E_FIXED_STEP_H
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+#include "common/scene.h"
+
+// Runs a scene's simulation on its own thread at a fixed tick rate, for scenes that provide
+// `tick` and `draw`. Every tick writes the state to draw into a back buffer that is then swapped
+// with the published one. The render side swaps the published snapshot in as its current one and
+// keeps the one before it, then draws between the two. Nothing is copied and the lock is only held
+// for pointer swaps, so a slow frame never holds back a tick and a slow tick never holds back a frame.
+
+// Ticks are dropped rather than run back to back after a stall longer than this
+const double FIXED_STEP_MAX_CATCH_UP_SECONDS = 0.25;
+
+struct Fixed_Step {
+    struct Scene_Functions functions;
+    void  *scene_data;
+    double tick_seconds;
+
+    std::thread       thread;
+    std::atomic<bool> is_running;
+
+    // Held for every tick, so scene code can be swapped between two of them
+    std::mutex tick_mutex;
+
+    // Simulation thread only
+    void *back;
+
+    std::mutex mutex;
+    void    *published;
+    uint64_t published_tick;
+    double   published_time;
+
+    // Render thread only
+    void    *previous;
+    void    *current;
+    uint64_t current_tick;
+    double   current_time;
+};
+
+double fixed_step_now_seconds(void) {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+void fixed_step_run(struct Fixed_Step *self) {
+    using namespace std::chrono;
+    double next_tick = fixed_step_now_seconds();
+
+    while (self->is_running.load(std::memory_order_acquire)) {
+        {
+            std::lock_guard<std::mutex> lock(self->tick_mutex);
+            self->functions.tick(self->scene_data, self->back, (float) self->tick_seconds);
+        }
+
+        double now = fixed_step_now_seconds();
+        {
+            std::lock_guard<std::mutex> lock(self->mutex);
+            void *swap = self->published;
+            self->published = self->back;
+            self->back = swap;
+            self->published_tick += 1;
+            self->published_time = now;
+        }
+
+        next_tick += self->tick_seconds;
+        if (now - next_tick > FIXED_STEP_MAX_CATCH_UP_SECONDS) next_tick = now;
+        std::this_thread::sleep_until(steady_clock::time_point(duration_cast<steady_clock::duration>(duration<double>(next_tick))));
+    }
+}
+
+// Starts ticking right away. `tick_rate` of 0 uses the scene's own.
+struct Fixed_Step *fixed_step_create(struct Scene_Functions functions, void *scene_data, float tick_rate) {
+    assert(functions.tick && functions.draw && functions.snapshot_size > 0 && "Scene has no fixed step");
+
+    struct Fixed_Step *self = new Fixed_Step();
+    self->functions    = functions;
+    self->scene_data   = scene_data;
+    self->tick_seconds = 1.0 / (double) (tick_rate > 0 ? tick_rate : functions.tick_rate);
+
+    // Zeroed snapshots mean nothing has been simulated yet, scenes draw them as empty
+    self->back      = calloc(1, functions.snapshot_size);
+    self->published = calloc(1, functions.snapshot_size);
+    self->previous  = calloc(1, functions.snapshot_size);
+    self->current   = calloc(1, functions.snapshot_size);
+    assert(self->back && self->published && self->previous && self->current && "Failed to allocate snapshots");
+
+    self->is_running.store(true, std::memory_order_release);
+    self->thread = std::thread(fixed_step_run, self);
+    return self;
+}
+
+// Joins the simulation thread, the scene can be destroyed after this
+void fixed_step_destroy(struct Fixed_Step *self) {
+    self->is_running.store(false, std::memory_order_release);
+    self->thread.join();
+
+    free(self->back);
+    free(self->published);
+    free(self->previous);
+    free(self->current);
+    delete self;
+}
+
+// Holds the simulation between two ticks, waiting for a tick in progress to finish, until
+// `fixed_step_resume`. Meanwhile the scene's data can be changed from other threads and its code
+// can be reloaded.
+void fixed_step_pause(struct Fixed_Step *self) {
+    self->tick_mutex.lock();
+}
+
+// Carries on with `functions`, which can come from a reloaded library. Snapshots are kept, so they
+// have to stay the same size.
+void fixed_step_resume(struct Fixed_Step *self, struct Scene_Functions functions) {
+    assert(functions.tick && functions.draw && functions.snapshot_size == self->functions.snapshot_size && "Snapshot size changed");
+    self->functions = functions;
+    self->tick_mutex.unlock();
+}
+
+// Takes the newest snapshot if there is one and returns how far the frame is from `previous` to
+// `current` in [0, 1]. Frames run one tick behind the simulation so there is always a next state
+// to move towards.
+float fixed_step_acquire(struct Fixed_Step *self, const void **previous, const void **current) {
+    {
+        std::lock_guard<std::mutex> lock(self->mutex);
+        if (self->published_tick != self->current_tick) {
+            void *swap = self->previous;
+            self->previous  = self->current;
+            self->current   = self->published;
+            self->published = swap;
+            self->current_tick = self->published_tick;
+            self->current_time = self->published_time;
+        }
+    }
+
+    *previous = self->previous;
+    *current  = self->current;
+
+    float alpha = (float) ((fixed_step_now_seconds() - self->current_time) / self->tick_seconds);
+    return alpha < 0 ? 0 : (alpha > 1 ? 1 : alpha);
+}
+
+#endif // E_FIXED_STEP_H
@@ -0,0 +1,85 @@
+#pragma once
+#ifndef E_MAPPED_FILE_H
+#define E_MAPPED_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include "WinDef.h"
+#include "fileapi.h"
+#include "handleapi.h"
+#include "memoryapi.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file. Pages come straight from the OS file cache as they are touched,
+// so opening costs the same no matter how big the file is and nothing is copied into our memory.
+
+struct Mapped_File {
+    const uint8_t *data;
+    size_t size;
+};
+
+// Returns false when the file is missing, empty, or can't be mapped
+bool mapped_file_open(const char *path, struct Mapped_File *file) {
+    *file = { };
+
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size = { };
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        CloseHandle(handle);
+        return false;
+    }
+
+    // The view keeps the mapping alive, so neither handle is needed once it exists
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+    if (!mapping) return false;
+
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) return false;
+
+    file->data = (const uint8_t *) data;
+    file->size = (size_t) size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info = { };
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    file->data = (const uint8_t *) data;
+    file->size = (size_t) info.st_size;
+#endif
+
+    return true;
+}
+
+void mapped_file_close(struct Mapped_File *file) {
+    if (file->data) {
+#if defined(_WIN32)
+        UnmapViewOfFile(file->data);
+#else
+        munmap((void *) file->data, file->size);
+#endif
+    }
+    *file = { };
+}
+
+#endif // E_MAPPED_FILE_H
@@ -2,10 +2,146 @@
 #ifndef E_MATH_H
 #define E_MATH_H
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
 struct Vector2_Int { int x, y; };
+struct Vector3_Int { int x, y, z; };
+
+constexpr float lerp(float a, float b, float t)         { return (1 - t) * a + b * t; }
+constexpr float inverse_lerp(float a, float b, float v) { return (v - a) / (b - a); }
+constexpr float remap(float a, float b, float a1, float b1, float v) { return lerp(a1, b1, inverse_lerp(a, b, v)); }
+
+constexpr float square(float v) { return v * v; }
+
+// Float-only approximations for hot loops. Both refine the hardware estimate (or a bit trick
+// when there is no SSE) with one Newton-Raphson step.
+// Max relative error, sampled over [1e-30, 1e30] by bench/math_bench.cpp:
+//   fast_rsqrt       SSE: < 3e-7,    no SSE: < 5e-6
+//   fast_reciprocal  SSE: < 2.1e-7,  no SSE: exact division
+// The SSE estimates are only specified to 1.5 * 2^-12, so other CPUs can land slightly higher.
+// Neither handles 0, negatives, infinities or denormals, callers must keep inputs in range.
+
+float fast_rsqrt(float v) {
+#if defined(__SSE2__) || defined(_M_X64)
+    float estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(v)));
+#else
+    // https://en.wikipedia.org/wiki/Fast_inverse_square_root
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    bits = 0x5F375A86u - (bits >> 1);
+    float estimate;
+    memcpy(&estimate, &bits, sizeof(estimate));
+    estimate = estimate * (1.5f - 0.5f * v * estimate * estimate);
+#endif
+    return estimate * (1.5f - 0.5f * v * estimate * estimate);
+}
+
+float fast_reciprocal(float v) {
+#if defined(__SSE2__) || defined(_M_X64)
+    float estimate = _mm_cvtss_f32(_mm_rcp_ss(_mm_set_ss(v)));
+    return estimate * (2.f - v * estimate);
+#else
+    return 1.f / v;
+#endif
+}
+
+// sqrt(v) as v * rsqrt(v), same error as `fast_rsqrt`. Returns 0 for 0.
+float fast_sqrt(float v) {
+    return v > 0 ? v * fast_rsqrt(v) : 0;
+}
+
+// Array versions, 8 wide with AVX and 4 wide with SSE. `out` may alias the inputs.
+// The broadcast lerp and remap fold their constants into one multiply-add, so results can
+// differ from the scalar versions in the last bit.
+
+void lerp(const float *a, const float *b, const float *t, float *out, size_t count) {
+    size_t i = 0;
+#if defined(__AVX__)
+    const __m256 one = _mm256_set1_ps(1.f);
+    for (; i + 8 <= count; i += 8) {
+        __m256 vt = _mm256_loadu_ps(&t[i]);
+        __m256 va = _mm256_mul_ps(_mm256_sub_ps(one, vt), _mm256_loadu_ps(&a[i]));
+        _mm256_storeu_ps(&out[i], _mm256_add_ps(va, _mm256_mul_ps(_mm256_loadu_ps(&b[i]), vt)));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128 one = _mm_set1_ps(1.f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 vt = _mm_loadu_ps(&t[i]);
+        __m128 va = _mm_mul_ps(_mm_sub_ps(one, vt), _mm_loadu_ps(&a[i]));
+        _mm_storeu_ps(&out[i], _mm_add_ps(va, _mm_mul_ps(_mm_loadu_ps(&b[i]), vt)));
+    }
+#endif
+    for (; i < count; ++i) out[i] = lerp(a[i], b[i], t[i]);
+}
+
+void lerp(float a, float b, const float *t, float *out, size_t count) {
+    size_t i = 0;
+    float delta = b - a;
+#if defined(__AVX__)
+    const __m256 va = _mm256_set1_ps(a);
+    const __m256 vd = _mm256_set1_ps(delta);
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(&out[i], _mm256_add_ps(va, _mm256_mul_ps(vd, _mm256_loadu_ps(&t[i]))));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128 va = _mm_set1_ps(a);
+    const __m128 vd = _mm_set1_ps(delta);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(&out[i], _mm_add_ps(va, _mm_mul_ps(vd, _mm_loadu_ps(&t[i]))));
+    }
+#endif
+    for (; i < count; ++i) out[i] = a + delta * t[i];
+}
+
+void remap(float a, float b, float a1, float b1, const float *v, float *out, size_t count) {
+    size_t i = 0;
+    float scale  = (b1 - a1) / (b - a);
+    float offset = a1 - a * scale;
+#if defined(__AVX__)
+    const __m256 vs = _mm256_set1_ps(scale);
+    const __m256 vo = _mm256_set1_ps(offset);
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(&out[i], _mm256_add_ps(vo, _mm256_mul_ps(vs, _mm256_loadu_ps(&v[i]))));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128 vs = _mm_set1_ps(scale);
+    const __m128 vo = _mm_set1_ps(offset);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(&out[i], _mm_add_ps(vo, _mm_mul_ps(vs, _mm_loadu_ps(&v[i]))));
+    }
+#endif
+    for (; i < count; ++i) out[i] = offset + scale * v[i];
+}
 
-float lerp(float a, float b, float t)         { return (1 - t) * a + b * t; }
-float inverse_lerp(float a, float b, float v) { return (v - a) / (b - a); }
-float remap(float a, float b, float a1, float b1, float v) { return lerp(a1, b1, inverse_lerp(a, b, v)); }
+// out[i] = numerator[i] / denominator[i] using `fast_reciprocal` precision
+void fast_divide(const float *numerator, const float *denominator, float *out, size_t count) {
+    size_t i = 0;
+#if defined(__AVX__)
+    const __m256 two = _mm256_set1_ps(2.f);
+    for (; i + 8 <= count; i += 8) {
+        __m256 d = _mm256_loadu_ps(&denominator[i]);
+        __m256 r = _mm256_rcp_ps(d);
+        r = _mm256_mul_ps(r, _mm256_sub_ps(two, _mm256_mul_ps(d, r)));
+        _mm256_storeu_ps(&out[i], _mm256_mul_ps(_mm256_loadu_ps(&numerator[i]), r));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128 two = _mm_set1_ps(2.f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 d = _mm_loadu_ps(&denominator[i]);
+        __m128 r = _mm_rcp_ps(d);
+        r = _mm_mul_ps(r, _mm_sub_ps(two, _mm_mul_ps(d, r)));
+        _mm_storeu_ps(&out[i], _mm_mul_ps(_mm_loadu_ps(&numerator[i]), r));
+    }
+#endif
+    for (; i < count; ++i) out[i] = numerator[i] * fast_reciprocal(denominator[i]);
+}
 
 #endif // E_MATH_H
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef E_MORTON_H
+#define E_MORTON_H
+
+#include <stdint.h>
+
+#include "common/math.h"
+
+// 3D Morton (Z-order) codes with 10 bits per axis packed into a uint32_t. Interleaving the
+// axes keeps cells that are close in space close in memory.
+// https://fgiesen.wordpress.com/2009/12/13/decoding-morton-codes/
+
+const uint32_t MORTON_AXIS_BITS = 10;
+const uint32_t MORTON_AXIS_MAX  = (1u << MORTON_AXIS_BITS) - 1;
+
+// The bits that belong to each axis
+const uint32_t MORTON_MASK_X = 0x09249249u;
+const uint32_t MORTON_MASK_Y = MORTON_MASK_X << 1;
+const uint32_t MORTON_MASK_Z = MORTON_MASK_X << 2;
+
+constexpr uint32_t morton_spread(uint32_t v) {
+    v &= MORTON_AXIS_MAX;
+    v = (v | (v << 16)) & 0x030000FFu;
+    v = (v | (v <<  8)) & 0x0300F00Fu;
+    v = (v | (v <<  4)) & 0x030C30C3u;
+    v = (v | (v <<  2)) & 0x09249249u;
+    return v;
+}
+
+constexpr uint32_t morton_compact(uint32_t v) {
+    v &= 0x09249249u;
+    v = (v ^ (v >>  2)) & 0x030C30C3u;
+    v = (v ^ (v >>  4)) & 0x0300F00Fu;
+    v = (v ^ (v >>  8)) & 0x030000FFu;
+    v = (v ^ (v >> 16)) & 0x000003FFu;
+    return v;
+}
+
+constexpr uint32_t morton_encode(struct Vector3_Int position) {
+    return morton_spread((uint32_t) position.x)
+         | (morton_spread((uint32_t) position.y) << 1)
+         | (morton_spread((uint32_t) position.z) << 2);
+}
+
+constexpr struct Vector3_Int morton_decode(uint32_t code) {
+    return {
+        (int) morton_compact(code),
+        (int) morton_compact(code >> 1),
+        (int) morton_compact(code >> 2)
+    };
+}
+
+// Adds two codes axis by axis without decoding them. Filling the other axes' bits with ones
+// lets the carries ripple straight through to the next bit of the same axis.
+// https://en.wikipedia.org/wiki/Z-order_curve#Coordinate_values
+constexpr uint32_t morton_add(uint32_t a, uint32_t b) {
+    return (((a | ~MORTON_MASK_X) + (b & MORTON_MASK_X)) & MORTON_MASK_X)
+         | (((a | ~MORTON_MASK_Y) + (b & MORTON_MASK_Y)) & MORTON_MASK_Y)
+         | (((a | ~MORTON_MASK_Z) + (b & MORTON_MASK_Z)) & MORTON_MASK_Z);
+}
+
+#endif // E_MORTON_H
@@ -0,0 +1,214 @@
+#pragma once
+#ifndef E_RANDOM_H
+#define E_RANDOM_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Deterministic random numbers with explicit state, so every thread or chunk can own a stream
+// and runs replay exactly for a given seed. Unlike raylib's GetRandomValue nothing here is global.
+//
+// `Random` is xoshiro256** for scalar use. `Random_Lanes` runs eight xoshiro128+ generators side
+// by side for bulk fills. The lane count is fixed, and SSE2/AVX2 only change how many lanes
+// step per instruction, so the output is the same on every machine.
+// https://prng.di.unimi.it/
+
+struct Random {
+    uint64_t s[4];
+};
+
+uint64_t random_splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+uint64_t random_rotl64(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+uint32_t random_rotl32(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+// Streams with the same seed and different `stream` ids are independent
+struct Random random_create(uint64_t seed, uint64_t stream) {
+    struct Random self = { };
+    uint64_t state = seed ^ random_splitmix64(&stream);
+    for (int i = 0; i < 4; ++i) self.s[i] = random_splitmix64(&state);
+    return self;
+}
+
+uint64_t random_u64(struct Random *self) {
+    uint64_t *s = self->s;
+    uint64_t result = random_rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = random_rotl64(s[3], 45);
+
+    return result;
+}
+
+uint32_t random_u32(struct Random *self) {
+    return (uint32_t) (random_u64(self) >> 32);
+}
+
+// [0, 1) with 24 bits of precision
+float random_float(struct Random *self) {
+    return (float) (random_u64(self) >> 40) * 0x1.0p-24f;
+}
+
+float random_float_range(struct Random *self, float min, float max) {
+    return min + (max - min) * random_float(self);
+}
+
+// Unbiased [0, bound) using Lemire's multiply-shift rejection
+// https://arxiv.org/abs/1805.10941
+uint32_t random_bounded(struct Random *self, uint32_t bound) {
+    uint64_t m = (uint64_t) random_u32(self) * bound;
+    uint32_t low = (uint32_t) m;
+    if (low < bound) {
+        uint32_t threshold = (uint32_t) -bound % bound;
+        while (low < threshold) {
+            m = (uint64_t) random_u32(self) * bound;
+            low = (uint32_t) m;
+        }
+    }
+    return (uint32_t) (m >> 32);
+}
+
+// Inclusive on both ends, like GetRandomValue. The full int range wraps `range` to 0, every
+// value is fair game then.
+int random_int_range(struct Random *self, int min, int max) {
+    assert(min <= max && "Empty random range");
+    uint32_t range = (uint32_t) ((int64_t) max - (int64_t) min + 1);
+    if (range == 0) return (int) random_u32(self);
+    return (int) ((int64_t) min + random_bounded(self, range));
+}
+
+void random_fill_u32(struct Random *self, uint32_t *out, size_t count) {
+    for (size_t i = 0; i < count; ++i) out[i] = random_u32(self);
+}
+
+void random_fill_float(struct Random *self, float *out, size_t count, float min, float max) {
+    for (size_t i = 0; i < count; ++i) out[i] = random_float_range(self, min, max);
+}
+
+const int RANDOM_LANES = 8;
+
+// State is stored word-major, s[word][lane], so each word is one vector load
+struct Random_Lanes {
+    alignas(32) uint32_t s[4][RANDOM_LANES];
+};
+
+struct Random_Lanes random_lanes_create(uint64_t seed, uint64_t stream) {
+    struct Random_Lanes self = { };
+    struct Random seeder = random_create(seed, stream);
+    for (int lane = 0; lane < RANDOM_LANES; ++lane) {
+        for (int word = 0; word < 4; ++word) {
+            self.s[word][lane] = random_u32(&seeder);
+        }
+
+        // The all-zero state is the one state xoshiro never leaves
+        if (!(self.s[0][lane] | self.s[1][lane] | self.s[2][lane] | self.s[3][lane])) self.s[0][lane] = 1;
+    }
+    return self;
+}
+
+// Steps every lane once and writes RANDOM_LANES outputs. xoshiro128+ has weak low bits,
+// prefer the high bits (as `random_lanes_fill_float` does) when only a few are needed.
+void random_lanes_next(struct Random_Lanes *self, uint32_t *out) {
+#if defined(__AVX2__)
+    __m256i s0 = _mm256_load_si256((const __m256i *) self->s[0]);
+    __m256i s1 = _mm256_load_si256((const __m256i *) self->s[1]);
+    __m256i s2 = _mm256_load_si256((const __m256i *) self->s[2]);
+    __m256i s3 = _mm256_load_si256((const __m256i *) self->s[3]);
+
+    _mm256_storeu_si256((__m256i *) out, _mm256_add_epi32(s0, s3));
+
+    __m256i t = _mm256_slli_epi32(s1, 9);
+    s2 = _mm256_xor_si256(s2, s0);
+    s3 = _mm256_xor_si256(s3, s1);
+    s1 = _mm256_xor_si256(s1, s2);
+    s0 = _mm256_xor_si256(s0, s3);
+    s2 = _mm256_xor_si256(s2, t);
+    s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+
+    _mm256_store_si256((__m256i *) self->s[0], s0);
+    _mm256_store_si256((__m256i *) self->s[1], s1);
+    _mm256_store_si256((__m256i *) self->s[2], s2);
+    _mm256_store_si256((__m256i *) self->s[3], s3);
+#elif defined(__SSE2__) || defined(_M_X64)
+    for (int half = 0; half < RANDOM_LANES; half += 4) {
+        __m128i s0 = _mm_load_si128((const __m128i *) &self->s[0][half]);
+        __m128i s1 = _mm_load_si128((const __m128i *) &self->s[1][half]);
+        __m128i s2 = _mm_load_si128((const __m128i *) &self->s[2][half]);
+        __m128i s3 = _mm_load_si128((const __m128i *) &self->s[3][half]);
+
+        _mm_storeu_si128((__m128i *) &out[half], _mm_add_epi32(s0, s3));
+
+        __m128i t = _mm_slli_epi32(s1, 9);
+        s2 = _mm_xor_si128(s2, s0);
+        s3 = _mm_xor_si128(s3, s1);
+        s1 = _mm_xor_si128(s1, s2);
+        s0 = _mm_xor_si128(s0, s3);
+        s2 = _mm_xor_si128(s2, t);
+        s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+        _mm_store_si128((__m128i *) &self->s[0][half], s0);
+        _mm_store_si128((__m128i *) &self->s[1][half], s1);
+        _mm_store_si128((__m128i *) &self->s[2][half], s2);
+        _mm_store_si128((__m128i *) &self->s[3][half], s3);
+    }
+#else
+    for (int lane = 0; lane < RANDOM_LANES; ++lane) {
+        uint32_t s0 = self->s[0][lane], s1 = self->s[1][lane], s2 = self->s[2][lane], s3 = self->s[3][lane];
+        out[lane] = s0 + s3;
+
+        uint32_t t = s1 << 9;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = random_rotl32(s3, 11);
+
+        self->s[0][lane] = s0; self->s[1][lane] = s1; self->s[2][lane] = s2; self->s[3][lane] = s3;
+    }
+#endif
+}
+
+void random_lanes_fill_u32(struct Random_Lanes *self, uint32_t *out, size_t count) {
+    size_t i = 0;
+    for (; i + RANDOM_LANES <= count; i += RANDOM_LANES) random_lanes_next(self, &out[i]);
+
+    if (i < count) {
+        uint32_t tail[RANDOM_LANES];
+        random_lanes_next(self, tail);
+        for (size_t j = 0; i < count; ++i, ++j) out[i] = tail[j];
+    }
+}
+
+// Uses the top 24 bits of each output, [min, max)
+void random_lanes_fill_float(struct Random_Lanes *self, float *out, size_t count, float min, float max) {
+    float scale = (max - min) * 0x1.0p-24f;
+    uint32_t bits[RANDOM_LANES];
+
+    for (size_t i = 0; i < count; i += RANDOM_LANES) {
+        random_lanes_next(self, bits);
+        size_t lanes = count - i < (size_t) RANDOM_LANES ? count - i : (size_t) RANDOM_LANES;
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            out[i + lane] = min + (float) (bits[lane] >> 8) * scale;
+        }
+    }
+}
+
+#endif // E_RANDOM_H
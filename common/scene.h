@@ -1,16 +1,87 @@
 #ifndef E_SCENE_H
 #define E_SCENE_H
 
-typedef void *(*Scene_Init_Function)    (void);
+#include <stddef.h>
+#include <stdint.h>
+
+// Scenes get their random seed from the host so a run can be reproduced with --seed
+typedef void *(*Scene_Init_Function)    (uint64_t);
 typedef void  (*Scene_Update_Function)  (void *, float);
 typedef void  (*Scene_Destroy_Function) (void *);
 
+// Optional fixed-step simulation, see common/fixed_step.h. `tick` runs on the host's simulation
+// thread and writes what there is to draw into a `snapshot_size` snapshot. `draw` runs on the main
+// thread between two snapshots, `alpha` of the way from the first to the second. When a scene has
+// them, `update` is still called every frame on the main thread but only for input.
+typedef void  (*Scene_Tick_Function)    (void *, void *snapshot, float delta_time);
+typedef void  (*Scene_Draw_Function)    (void *, const void *previous, const void *current, float alpha);
+
+// Optional, for scenes whose data keeps threads. A thread runs the code of the library that
+// started it, so it can't outlive that library. On a hot reload `before_reload` from the old
+// library ends them, and `after_reload` from the new one starts them again. Both run on the main
+// thread while no other scene code runs.
+typedef void  (*Scene_Reload_Function)  (void *);
+
+// What a scene's data looks like, so a hot reload can tell whether the rebuilt scene can keep
+// running on the data of the old one, see common/scene_migration.h. `fields` has to list every
+// field of the data except the ones owning threads, which `before_reload` ends and
+// `after_reload` starts again from the new library. `version` is bumped by hand when something
+// changes that the fields can't show, like what a field means or what goes in a snapshot.
+struct Scene_Field {
+    const char *name;
+    size_t offset;
+    size_t size;
+};
+
+#define SCENE_FIELD(type, field) { #field, offsetof(type, field), sizeof(((type *) 0)->field) }
+
+struct Scene_Layout {
+    uint32_t version;
+    size_t   size;
+    const struct Scene_Field *fields;
+    size_t   field_count;
+};
+
+#define SCENE_LAYOUT(type, layout_version, field_array) {              \
+    .version = (layout_version), .size = sizeof(type),                 \
+    .fields = (field_array),                                           \
+    .field_count = sizeof(field_array) / sizeof((field_array)[0]),     \
+}
+
+// Optional hooks for when the layout changed. `migrate` comes from the new library and turns the
+// old data into the new one, `old_layout` tells it where the old fields are. `serialize` comes from
+// the old library and packs its data into a buffer from malloc, which `deserialize` from the new
+// library reads back. All three take over the data they are given.
+typedef void *(*Scene_Migrate_Function)     (void *old_data, const struct Scene_Layout *old_layout);
+typedef void *(*Scene_Serialize_Function)   (void *, size_t *size);
+typedef void *(*Scene_Deserialize_Function) (void *buffer, size_t size, const struct Scene_Layout *old_layout);
+
 struct Scene_Functions {
     Scene_Init_Function    init;
     Scene_Update_Function  update;
     Scene_Destroy_Function destroy;
+
+    Scene_Tick_Function    tick;
+    Scene_Draw_Function    draw;
+    size_t snapshot_size;
+    float  tick_rate;  // Ticks per second unless the host is told otherwise
+
+    Scene_Reload_Function  before_reload;
+    Scene_Reload_Function  after_reload;
+
+    struct Scene_Layout        layout;
+    Scene_Migrate_Function     migrate;
+    Scene_Serialize_Function   serialize;
+    Scene_Deserialize_Function deserialize;
 };
 
+// Marks `get_scene_functions` so the host can look it up in the scene's library
+#if defined(_WIN32)
+#define SCENE_EXPORT __declspec(dllexport)
+#else
+#define SCENE_EXPORT __attribute__((visibility("default")))
+#endif
+
 typedef struct Scene_Functions Scene_Functions_T;
 typedef Scene_Functions_T (*Scene_Get_Function)(void);
 
@@ -19,6 +90,13 @@ struct Scene {
     long  last_library_write_time;
     bool  is_valid;
 
+    // Hot reloading, see common/scene_loading.h. `library_write_seconds` is when the loaded
+    // library was written, on the same clock as `scene_clock_seconds`.
+    const char *library_path;
+    int      watch_fd;
+    uint32_t reload_count;
+    double   library_write_seconds;
+
     void *scene_data;
     struct Scene_Functions functions;
 };
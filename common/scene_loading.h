@@ -3,21 +3,31 @@
 
 #include <assert.h>
 
-#include "WinDef.h"
-#include "winbase.h"
-#include "libloaderapi.h"
-
 #include "common/scene.h"
 
-void *empty_init(void) { }
+void *empty_init(uint64_t seed) { (void) seed; return NULL; }
 void  empty_update(void  *scene_data, float delta_time) { }
 void  empty_destroy(void *scene_data) { }
 
-const struct Scene_Functions EMPTY_SCENE_FUNCTIONS = {
-    .init    = &empty_init,
-    .update  = &empty_update,
-    .destroy = &empty_destroy,
-};
+struct Scene_Functions empty_scene_functions(void) {
+    struct Scene_Functions functions = { };
+    functions.init    = &empty_init;
+    functions.update  = &empty_update;
+    functions.destroy = &empty_destroy;
+    return functions;
+}
+
+// Hot reloading goes in three steps so the host can make sure no scene code runs while its
+// library is swapped: `scene_library_changed` once per frame, then `reload_scene` to load the
+// rebuilt library next to the running one, then `close_scene_library` on the old one once
+// nothing can be running it anymore. These only exist on Linux, the host leaves hot reloading
+// out on Windows.
+
+#if defined(_WIN32)
+
+#include "WinDef.h"
+#include "winbase.h"
+#include "libloaderapi.h"
 
 struct Scene load_scene_from_dll(
     const char *dll_path,
@@ -25,7 +35,7 @@ struct Scene load_scene_from_dll(
     const char *pdb_path,
     const char *temp_pdb_path
 ) {
-    struct Scene scene = { 0 };
+    struct Scene scene = { };
     scene.last_library_write_time = GetFileModTime(dll_path);
 
     CopyFileA((LPCSTR) dll_path, (LPCSTR) temp_dll_path, FALSE);
@@ -45,10 +55,147 @@ void unload_scene(struct Scene *scene) {
     if (scene->library) {
         FreeLibrary((HMODULE) scene->library);
         scene->library = NULL;
-        scene->functions = EMPTY_SCENE_FUNCTIONS;
+        scene->functions = empty_scene_functions();
     }
 
     scene->is_valid = false;
 }
 
+#elif defined(__linux__)
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Same clock as file modification times, so a reload can be timed from when the library was written
+double scene_clock_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+double scene_library_write_seconds(const char *library_path) {
+    struct stat status;
+    if (stat(library_path, &status) != 0) return 0;
+    return (double) status.st_mtim.tv_sec + (double) status.st_mtim.tv_nsec * 1e-9;
+}
+
+// dlopen hands back the library already loaded from a path instead of loading it again, so
+// every load goes through a hard link with a name of its own. Linking copies nothing, and the
+// link is removed as soon as the library is mapped.
+//
+// Builds have to replace the library with a new file, like linkers do, and not write over it
+// in place, which would change the code under the running scene.
+void *scene_library_open(struct Scene *scene) {
+    char link_path[PATH_MAX];
+    snprintf(link_path, sizeof(link_path), "%s.%d.%u", scene->library_path, (int) getpid(), scene->reload_count);
+
+    unlink(link_path);
+    if (link(scene->library_path, link_path) != 0) {
+        fprintf(stderr, "Failed to link %s: %s\n", scene->library_path, strerror(errno));
+        return NULL;
+    }
+
+    void *library = dlopen(link_path, RTLD_NOW | RTLD_LOCAL);
+    if (!library) fprintf(stderr, "Failed to load %s: %s\n", scene->library_path, dlerror());
+    unlink(link_path);
+    return library;
+}
+
+struct Scene load_scene_from_library(const char *library_path) {
+    struct Scene scene = { };
+    scene.library_path          = library_path;
+    scene.library_write_seconds = scene_library_write_seconds(library_path);
+    scene.library               = scene_library_open(&scene);
+    scene.is_valid              = true;
+
+    assert(scene.library && "Failed to load scene");
+    Scene_Get_Function get_scene_functions = (Scene_Get_Function) dlsym(scene.library, "get_scene_functions");
+    assert(get_scene_functions && "Scene has no get_scene_functions");
+    scene.functions = get_scene_functions();
+
+    // The directory is watched and not the file, since every build puts a new file there
+    char directory[PATH_MAX];
+    const char *slash = strrchr(library_path, '/');
+    if (slash) snprintf(directory, sizeof(directory), "%.*s", (int) (slash - library_path), library_path);
+    else       snprintf(directory, sizeof(directory), ".");
+
+    scene.watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (scene.watch_fd < 0 || inotify_add_watch(scene.watch_fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        fprintf(stderr, "Hot reloading is off, failed to watch %s: %s\n", directory, strerror(errno));
+    }
+
+    return scene;
+}
+
+// Whether the library was rebuilt since the last call. Never blocks, one read when nothing happened.
+bool scene_library_changed(struct Scene *scene) {
+    if (scene->watch_fd < 0) return false;
+
+    const char *slash = strrchr(scene->library_path, '/');
+    const char *name  = slash ? slash + 1 : scene->library_path;
+
+    bool is_changed = false;
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t size = read(scene->watch_fd, buffer, sizeof(buffer));
+        if (size <= 0) break;
+
+        for (char *at = buffer; at < buffer + size; ) {
+            struct inotify_event *event = (struct inotify_event *) at;
+            if (event->len > 0 && strcmp(event->name, name) == 0) is_changed = true;
+            at += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return is_changed;
+}
+
+// Loads the rebuilt library next to the running one. On success `scene->functions` are the new
+// ones and the old library is returned, for `close_scene_library` once none of its code can run
+// anymore. On failure nothing changes and NULL is returned.
+void *reload_scene(struct Scene *scene) {
+    scene->reload_count += 1;
+    double write_seconds = scene_library_write_seconds(scene->library_path);
+
+    void *library = scene_library_open(scene);
+    if (!library) return NULL;
+
+    Scene_Get_Function get_scene_functions = (Scene_Get_Function) dlsym(library, "get_scene_functions");
+    if (!get_scene_functions) {
+        fprintf(stderr, "Failed to reload %s: no get_scene_functions\n", scene->library_path);
+        dlclose(library);
+        return NULL;
+    }
+
+    void *previous = scene->library;
+    scene->library               = library;
+    scene->functions             = get_scene_functions();
+    scene->library_write_seconds = write_seconds;
+    return previous;
+}
+
+void close_scene_library(void *library) {
+    dlclose(library);
+}
+
+void unload_scene(struct Scene *scene) {
+    if (scene->library) {
+        dlclose(scene->library);
+        scene->library = NULL;
+        scene->functions = empty_scene_functions();
+    }
+    if (scene->watch_fd >= 0) close(scene->watch_fd);
+    scene->watch_fd = -1;
+
+    scene->is_valid = false;
+}
+
+#endif
+
 #endif // E_SCENE_LOADING_H
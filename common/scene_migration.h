@@ -0,0 +1,123 @@
+#ifndef E_SCENE_MIGRATION_H
+#define E_SCENE_MIGRATION_H
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/scene.h"
+
+// Moves a scene's data over to a rebuilt library. Runs between the reload and closing the old
+// library, while no scene code runs, and tries the cheapest way that is still safe:
+//
+//   - The layout didn't change, so the data is kept as it is.
+//   - The old library can serialize and the new one deserialize.
+//   - The new library has `migrate`.
+//   - Only fields were added, removed, moved or resized. Fields with the same name and size are
+//     copied over, new ones start zeroed.
+//   - Otherwise the old data is destroyed and the new scene starts over from `init`.
+//
+// Scene data has to come from malloc, since copying the fields frees the old data. Fields are
+// copied byte for byte, so pointers in them carry over and what they point to now belongs to the
+// new data. Whatever only a removed field pointed to is leaked. Threads can't carry over, they
+// run the old library's code, so fields owning them stay out of the layout and start zeroed.
+
+enum Scene_Migration {
+    SCENE_MIGRATION_KEPT,
+    SCENE_MIGRATION_SERIALIZED,
+    SCENE_MIGRATION_MIGRATED,
+    SCENE_MIGRATION_FIELDS,
+    SCENE_MIGRATION_RESTARTED,
+};
+
+const char *scene_migration_name(enum Scene_Migration migration) {
+    switch (migration) {
+        case SCENE_MIGRATION_KEPT:       return "data kept";
+        case SCENE_MIGRATION_SERIALIZED: return "data serialized";
+        case SCENE_MIGRATION_MIGRATED:   return "data migrated";
+        case SCENE_MIGRATION_FIELDS:     return "fields copied";
+        case SCENE_MIGRATION_RESTARTED:  return "scene restarted";
+    }
+    return "";
+}
+
+// Scenes without a layout never match, nothing can be known about their data
+bool scene_layout_is_known(const struct Scene_Layout *layout) {
+    return layout->size > 0 && layout->fields && layout->field_count > 0;
+}
+
+const struct Scene_Field *scene_layout_find(const struct Scene_Layout *layout, const char *name) {
+    for (size_t i = 0; i < layout->field_count; ++i) {
+        if (strcmp(layout->fields[i].name, name) == 0) return &layout->fields[i];
+    }
+    return NULL;
+}
+
+bool scene_layouts_match(const struct Scene_Layout *a, const struct Scene_Layout *b) {
+    if (!scene_layout_is_known(a) || !scene_layout_is_known(b)) return false;
+    if (a->version != b->version || a->size != b->size || a->field_count != b->field_count) return false;
+
+    for (size_t i = 0; i < a->field_count; ++i) {
+        const struct Scene_Field *x = &a->fields[i];
+        const struct Scene_Field *y = &b->fields[i];
+        if (x->offset != y->offset || x->size != y->size || strcmp(x->name, y->name) != 0) return false;
+    }
+    return true;
+}
+
+// Copies every field `new_layout` shares with `old_layout` by name and size. Also meant for
+// `migrate` hooks that only have a few fields to fix up after it.
+void scene_migrate_fields(
+    void *new_data, const struct Scene_Layout *new_layout,
+    const void *old_data, const struct Scene_Layout *old_layout
+) {
+    for (size_t i = 0; i < new_layout->field_count; ++i) {
+        const struct Scene_Field *field = &new_layout->fields[i];
+        const struct Scene_Field *old   = scene_layout_find(old_layout, field->name);
+        if (!old || old->size != field->size) continue;
+        memcpy((char *) new_data + field->offset, (const char *) old_data + old->offset, field->size);
+    }
+}
+
+// Returns the data for the `to` scene, `scene_data` must not be used after. Both libraries have to
+// be loaded and nothing may be running scene code.
+void *scene_migrate(
+    const struct Scene_Functions *from,
+    const struct Scene_Functions *to,
+    void *scene_data,
+    uint64_t seed,
+    enum Scene_Migration *migration
+) {
+    if (scene_layouts_match(&from->layout, &to->layout)) {
+        *migration = SCENE_MIGRATION_KEPT;
+        return scene_data;
+    }
+
+    if (from->serialize && to->deserialize) {
+        size_t size = 0;
+        void *buffer = from->serialize(scene_data, &size);
+        *migration = SCENE_MIGRATION_SERIALIZED;
+        return to->deserialize(buffer, size, &from->layout);
+    }
+
+    if (to->migrate && scene_layout_is_known(&from->layout)) {
+        *migration = SCENE_MIGRATION_MIGRATED;
+        return to->migrate(scene_data, &from->layout);
+    }
+
+    // A new version means the fields can't be trusted to mean the same, even with the same names
+    if (scene_layout_is_known(&from->layout) && scene_layout_is_known(&to->layout) && from->layout.version == to->layout.version) {
+        void *data = calloc(1, to->layout.size);
+        assert(data && "Failed to allocate scene data");
+        scene_migrate_fields(data, &to->layout, scene_data, &from->layout);
+        free(scene_data);
+        *migration = SCENE_MIGRATION_FIELDS;
+        return data;
+    }
+
+    from->destroy(scene_data);
+    *migration = SCENE_MIGRATION_RESTARTED;
+    return to->init(seed);
+}
+
+#endif // E_SCENE_MIGRATION_H
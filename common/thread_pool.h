@@ -0,0 +1,139 @@
+#pragma once
+#ifndef E_THREAD_POOL_H
+#define E_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+// Persistent worker pool. `thread_pool_run` hands out `job_count` jobs to the workers and the
+// calling thread, and only returns once every job has finished, so it doubles as the join.
+
+typedef void (*Thread_Pool_Job_Function)(void *user_data, size_t job_index);
+
+struct Thread_Pool {
+    size_t       worker_count;
+    std::thread *workers;
+
+    std::mutex              mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    // Bumped once per `thread_pool_run`, workers sleep until it changes
+    size_t generation;
+    bool   is_shutting_down;
+
+    // Workers currently inside `thread_pool_take_jobs`. A new run waits for this to drain
+    // so no straggler from the previous run can see the job fields change under it.
+    size_t workers_busy;
+
+    Thread_Pool_Job_Function function;
+    void  *user_data;
+    size_t job_count;
+
+    std::atomic<size_t> next_job;
+    std::atomic<size_t> jobs_remaining;
+};
+
+size_t thread_pool_default_thread_count(void) {
+    size_t count = std::thread::hardware_concurrency();
+    return count ? count : 1;
+}
+
+void thread_pool_take_jobs(struct Thread_Pool *pool) {
+    for (;;) {
+        size_t job = pool->next_job.fetch_add(1, std::memory_order_relaxed);
+        if (job >= pool->job_count) return;
+
+        pool->function(pool->user_data, job);
+
+        if (pool->jobs_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            pool->done.notify_all();
+        }
+    }
+}
+
+void thread_pool_worker(struct Thread_Pool *pool) {
+    size_t seen_generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->wake.wait(lock, [&]() { return pool->is_shutting_down || pool->generation != seen_generation; });
+            if (pool->is_shutting_down) return;
+            seen_generation = pool->generation;
+            pool->workers_busy += 1;
+        }
+
+        thread_pool_take_jobs(pool);
+
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            pool->workers_busy -= 1;
+        }
+        pool->done.notify_all();
+    }
+}
+
+// `thread_count` includes the calling thread, so a count of 1 runs every job inline
+struct Thread_Pool *thread_pool_create(size_t thread_count) {
+    struct Thread_Pool *pool = new Thread_Pool();
+    pool->worker_count = thread_count > 1 ? thread_count - 1 : 0;
+    pool->workers = new std::thread[pool->worker_count];
+
+    for (size_t i = 0; i < pool->worker_count; ++i) {
+        pool->workers[i] = std::thread(&thread_pool_worker, pool);
+    }
+
+    return pool;
+}
+
+void thread_pool_destroy(struct Thread_Pool *pool) {
+    if (!pool) return;
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->is_shutting_down = true;
+    }
+    pool->wake.notify_all();
+
+    for (size_t i = 0; i < pool->worker_count; ++i) pool->workers[i].join();
+
+    delete[] pool->workers;
+    delete pool;
+}
+
+size_t thread_pool_thread_count(struct Thread_Pool *pool) {
+    return pool->worker_count + 1;
+}
+
+void thread_pool_run(struct Thread_Pool *pool, size_t job_count, Thread_Pool_Job_Function function, void *user_data) {
+    if (job_count == 0) return;
+
+    if (pool->worker_count == 0 || job_count == 1) {
+        for (size_t i = 0; i < job_count; ++i) function(user_data, i);
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(pool->mutex);
+        pool->done.wait(lock, [&]() { return pool->workers_busy == 0; });
+
+        pool->function  = function;
+        pool->user_data = user_data;
+        pool->job_count = job_count;
+        pool->next_job.store(0, std::memory_order_relaxed);
+        pool->jobs_remaining.store(job_count, std::memory_order_relaxed);
+        pool->generation += 1;
+    }
+    pool->wake.notify_all();
+
+    thread_pool_take_jobs(pool);
+
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->done.wait(lock, [&]() { return pool->jobs_remaining.load(std::memory_order_acquire) == 0; });
+}
+
+#endif // E_THREAD_POOL_H
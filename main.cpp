@@ -1,14 +1,27 @@
 #include <ctime>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 #include "raylib.h"
 
 #include "common/common.h"
 #include "common/defer.hpp"
+#include "common/fixed_step.h"
 #include "common/scene_loading.h"
+#include "common/scene_migration.h"
+
+int main(int argc, char **argv) {
+    // Scenes own their random streams, the host only picks the seed. Pass --seed to replay a run.
+    // --tick-rate overrides the simulation rate of scenes with a fixed step, in ticks per second.
+    uint64_t seed = (uint64_t) time(NULL);
+    float tick_rate = 0;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--seed") == 0)      seed      = strtoull(argv[i + 1], NULL, 10);
+        if (strcmp(argv[i], "--tick-rate") == 0) tick_rate = strtof(argv[i + 1], NULL);
+    }
+    fprintf(stderr, "seed: %llu\n", (unsigned long long) seed);
 
-int main(void) {
-    SetRandomSeed(time(NULL));
     SetConfigFlags(FLAG_MSAA_4X_HINT | FLAG_WINDOW_HIGHDPI | FLAG_VSYNC_HINT | FLAG_WINDOW_RESIZABLE);
 
     InitWindow(SCREEN_SIZE_INITIAL.x, SCREEN_SIZE_INITIAL.y, "starfield");
@@ -25,7 +38,7 @@ int main(void) {
     float window_scale  = (float) window_height / CANVAS_SIZE.y;
 
     // @TODO: Main menu with scene selection
-    struct Scene current_scene_info = { 0 };
+    struct Scene current_scene_info = { };
     /*
     current_scene_info = load_scene_from_dll(
         "bin/01_starfield.dll",
@@ -48,6 +61,7 @@ int main(void) {
     );
     */
 
+#if defined(_WIN32)
     current_scene_info = load_scene_from_dll(
         "bin/03_snake.dll",
         "bin/03_snake_loaded.dll",
@@ -56,21 +70,81 @@ int main(void) {
         "bin/03_snake.pdb",
         "bin/03_snake_loaded.pdb"
     );
+#else
+    current_scene_info = load_scene_from_library("bin/03_snake.so");
+#endif
 
 
     struct Scene_Functions current_scene = current_scene_info.functions;
 
-    void *scene_data = current_scene.init();
+    void *scene_data = current_scene.init(seed);
+
+    // Scenes with a fixed step simulate on their own thread, frames only draw what it publishes
+    struct Fixed_Step *fixed_step = NULL;
+    if (current_scene.tick) fixed_step = fixed_step_create(current_scene, scene_data, tick_rate);
+
+#if !defined(_WIN32)
+    bool   is_reload_pending = false;
+    double reload_seconds    = 0;
+    enum Scene_Migration migration = SCENE_MIGRATION_KEPT;
+#endif
 
     while (!WindowShouldClose()) {
         float delta_time = GetFrameTime();
 
+#if !defined(_WIN32)
+        // A rebuilt scene is swapped in between frames. Threads run the code of the library that
+        // started them, so the scene's own threads are ended by the old code's `before_reload` and
+        // started again by the new code's `after_reload`. When the data layout is the same the data
+        // is kept and the simulation thread is only held between two ticks. Otherwise it is stopped
+        // while the data is migrated and started again with the new code. The old library is closed
+        // last, once no thread can be running its code.
+        if (scene_library_changed(&current_scene_info)) {
+            double start = scene_clock_seconds();
+            void *previous_library = reload_scene(&current_scene_info);
+            if (previous_library) {
+                struct Scene_Functions functions = current_scene_info.functions;
+                bool keeps_fixed_step = fixed_step && functions.tick
+                    && functions.snapshot_size == current_scene.snapshot_size
+                    && scene_layouts_match(&current_scene.layout, &functions.layout);
+
+                if (keeps_fixed_step) fixed_step_pause(fixed_step);
+                else if (fixed_step)  fixed_step_destroy(fixed_step);
+
+                if (current_scene.before_reload) current_scene.before_reload(scene_data);
+                scene_data = scene_migrate(&current_scene, &functions, scene_data, seed, &migration);
+                if (functions.after_reload && migration != SCENE_MIGRATION_RESTARTED) functions.after_reload(scene_data);
+
+                if (keeps_fixed_step) fixed_step_resume(fixed_step, functions);
+                else fixed_step = functions.tick ? fixed_step_create(functions, scene_data, tick_rate) : NULL;
+
+                current_scene = functions;
+                close_scene_library(previous_library);
+
+                is_reload_pending = true;
+                reload_seconds    = scene_clock_seconds() - start;
+            }
+        }
+#endif
+
         const char *title = TextFormat("coding challenges - %.2f ms/frame", delta_time * 1'000);
         SetWindowTitle(title);
 
-        BeginTextureMode(render_target);
+        if (fixed_step) {
             current_scene.update(scene_data, delta_time);
-        EndTextureMode();
+
+            const void *previous = NULL;
+            const void *current  = NULL;
+            float alpha = fixed_step_acquire(fixed_step, &previous, &current);
+
+            BeginTextureMode(render_target);
+                current_scene.draw(scene_data, previous, current, alpha);
+            EndTextureMode();
+        } else {
+            BeginTextureMode(render_target);
+                current_scene.update(scene_data, delta_time);
+            EndTextureMode();
+        }
 
         if (IsWindowResized()) {
             window_width  = GetRenderWidth()  / dpi_scale.x;
@@ -92,8 +166,18 @@ int main(void) {
                 { 0.0f, 0.0f }, 0.0f, WHITE
             );
         EndDrawing();
+
+#if !defined(_WIN32)
+        if (is_reload_pending) {
+            double since_write = scene_clock_seconds() - current_scene_info.library_write_seconds;
+            fprintf(stderr, "Reloaded %s in %.2f ms (%s), %.2f ms from write to first frame\n",
+                current_scene_info.library_path, reload_seconds * 1e3, scene_migration_name(migration), since_write * 1e3);
+            is_reload_pending = false;
+        }
+#endif
     }
 
+    if (fixed_step) fixed_step_destroy(fixed_step);
     current_scene.destroy(scene_data);
     return 0;
 }